@@ -0,0 +1,241 @@
+// Qt headers
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+// C headers
+#include <cstdlib>
+
+// C++ headers
+#include <iostream>
+
+// Local headers
+#include "work_precision.hpp"
+
+namespace {
+
+void Fail(
+   QString message
+){
+   std::cerr << "work-precision: " << message.toStdString() << std::endl;
+   exit( EXIT_FAILURE );
+}
+
+QVector<double> NumberList(
+   QString list
+ , QString option
+){
+   QVector<double> numbers;
+   for( auto item : list.split( ',', QString::SkipEmptyParts ) ){
+      bool ok;
+      double number = item.toDouble( &ok );
+      if( !ok || !( number > 0.0 ) )
+         Fail( QString( "--%1: \"%2\" is not a positive number" ).arg( option, item ) );
+      numbers.push_back( number );
+   }
+
+   return numbers;
+}
+
+// JSON has no infinity, a run that blew up has no error to report
+QJsonValue JsonNumber(
+   double value
+){
+   return std::isfinite( value ) ? QJsonValue( value ) : QJsonValue();
+}
+
+QJsonObject JsonRun(
+   const WorkPrecisionRun &run
+){
+   QJsonObject object;
+   object["method"]         = MethodName( run.method );
+   object["precision"]      = PrecisionName( run.precision );
+   object["dt"]             = run.dt;
+   object["tolerance"]      = run.tolerance;
+   object["steps"]          = (double)run.steps;
+   object["evaluations"]    = (double)run.evaluations;
+   object["seconds"]        = run.seconds;
+   object["error"]          = JsonNumber( run.error );
+   object["relative_error"] = JsonNumber( run.relativeError );
+   return object;
+}
+
+}
+
+int main(
+   int argc
+ , char *argv[]
+){
+   QCoreApplication app( argc, argv );
+   QCoreApplication::setApplicationName( "work-precision" );
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription(
+      "Runs a problem with each integrator over a sweep of step sizes, or of\n"
+      "tolerances for taylor, and reports the error at t_end against a\n"
+      "high-precision reference solution, with the right-hand side\n"
+      "evaluations and the time it took." );
+   parser.addHelpOption();
+   parser.addPositionalArgument( "problem", "Problem ini file." );
+   QCommandLineOption methodsOption( "methods", "Methods to compare.", "list", "euler,heun,rk3,rk4,rk38,rk6,taylor" );
+   QCommandLineOption precisionsOption( "precisions", "Precisions to compare, by default the one of the problem.", "list" );
+   QCommandLineOption dtOption( "dt", "Step sizes, by default dt of the problem halved --levels times.", "list" );
+   QCommandLineOption levelsOption( "levels", "Step sizes in the default sweep.", "n", "6" );
+   QCommandLineOption tolerancesOption( "tolerances", "Tolerances of taylor.", "list", "1e-4,1e-6,1e-8,1e-10,1e-12,1e-14" );
+   QCommandLineOption timeEndOption( "t-end", "End time, by default t_end of the problem.", "t" );
+   QCommandLineOption repeatsOption( "repeats", "Runs of each configuration, the fastest is reported.", "n", "3" );
+   QCommandLineOption maxStepsOption( "max-steps", "Skip step sizes needing more steps than this.", "n", "10000000" );
+   QCommandLineOption budgetOption( "budget", "Also report the fastest configuration with at most this error.", "error" );
+   QCommandLineOption formatOption( "format", "Output format, csv or json.", "format", "csv" );
+   QCommandLineOption outputOption( "output", "Output file, by default standard output.", "file" );
+   parser.addOptions( { methodsOption, precisionsOption, dtOption, levelsOption, tolerancesOption, timeEndOption
+                      , repeatsOption, maxStepsOption, budgetOption, formatOption, outputOption } );
+   parser.process( app );
+
+   if( parser.positionalArguments().size() != 1 )
+      parser.showHelp( EXIT_FAILURE );
+   QString format = parser.value( formatOption ).toLower();
+   if( format != "csv" && format != "json" )
+      Fail( "--format must be csv or json" );
+
+   WorkPrecision bench;
+   QString error;
+   if( !bench.Load( parser.positionalArguments()[0], error ) )
+      Fail( error );
+   if( parser.isSet( timeEndOption ) )
+      bench.SetTimeEnd( parser.value( timeEndOption ).toDouble() );
+
+   // what to run
+   QVector<Method> methods;
+   for( auto name : parser.value( methodsOption ).split( ',', QString::SkipEmptyParts ) ){
+      Method method;
+      if( !MethodFromName( name, method ) || method == Method::EulerMaruyama || method == Method::Milstein )
+         Fail( QString( "unknown method \"%1\"" ).arg( name ) );
+      methods.push_back( method );
+   }
+   QVector<Precision> precisions;
+   for( auto name : parser.value( precisionsOption ).split( ',', QString::SkipEmptyParts ) ){
+      Precision precision;
+      if( !PrecisionFromName( name, precision ) )
+         Fail( QString( "unknown precision \"%1\"" ).arg( name ) );
+      precisions.push_back( precision );
+   }
+   if( precisions.isEmpty() )
+      precisions.push_back( bench.ProblemPrecision() );
+
+   QVector<double> steps;
+   if( parser.isSet( dtOption ) ){
+      steps = NumberList( parser.value( dtOption ), "dt" );
+   } else {
+      for( int k = 0; k < std::max( 1, parser.value( levelsOption ).toInt() ); k++ )
+         steps.push_back( std::ldexp( bench.Dt(), -k ) );
+   }
+   QVector<double> tolerances = NumberList( parser.value( tolerancesOption ), "tolerances" );
+   if( steps.isEmpty() || tolerances.isEmpty() )
+      Fail( "nothing to run" );
+   int repeats = parser.value( repeatsOption ).toInt();
+   qint64 maxSteps = parser.value( maxStepsOption ).toLongLong();
+   double span = bench.TimeEnd() - bench.TimeInit();
+
+   if( !bench.ComputeReference( *std::min_element( steps.begin(), steps.end() ), error ) )
+      Fail( error );
+
+   QVector<WorkPrecisionRun> runs;
+   for( Precision precision : precisions ){
+      for( Method method : methods ){
+         if( bench.HasDelays() && ( method == Method::Taylor || precision != Precision::Double ) ){
+            qDebug() << "WARNING: Skipping" << MethodName( method ) << "in" << PrecisionName( precision )
+                     << ": delay terms need the double precision Runge-Kutta stepper.";
+            continue;
+         }
+         if( method == Method::Taylor ){
+            for( double tolerance : tolerances )
+               runs.push_back( bench.Run( method, precision, bench.Dt(), tolerance, repeats ) );
+            continue;
+         }
+         for( double dt : steps ){
+            if( span / dt > maxSteps ){
+               qDebug() << "WARNING: Skipping" << MethodName( method ) << "with dt" << dt << ": more than" << maxSteps << "steps.";
+               continue;
+            }
+            runs.push_back( bench.Run( method, precision, dt, 0.0, repeats ) );
+         }
+      }
+   }
+
+   // errors near the reference error only say the run is at least as good
+   double limit = 10 * bench.ReferenceError();
+   for( auto run : runs ){
+      if( run.error < limit ){
+         qDebug() << "WARNING: Errors below" << limit << "are not resolved by the reference solution.";
+         break;
+      }
+   }
+
+   // cheapest configuration within the accuracy budget
+   int cheapest = -1;
+   double budget = parser.value( budgetOption ).toDouble();
+   if( parser.isSet( budgetOption ) ){
+      for( int i = 0; i < runs.size(); i++ ){
+         if( !( runs[i].error <= budget ) )
+            continue;
+         if( cheapest < 0 || runs[i].seconds < runs[cheapest].seconds )
+            cheapest = i;
+      }
+      if( cheapest < 0 )
+         qDebug() << "WARNING: No configuration has an error of at most" << budget;
+   }
+
+   QFile outputFile;
+   if( parser.isSet( outputOption ) ){
+      outputFile.setFileName( parser.value( outputOption ) );
+      if( !outputFile.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+         Fail( QString( "can't write %1: %2" ).arg( outputFile.fileName(), outputFile.errorString() ) );
+   } else {
+      outputFile.open( stdout, QIODevice::WriteOnly | QIODevice::Text );
+   }
+   QTextStream out( &outputFile );
+
+   if( format == "json" ){
+      QJsonObject reference;
+      reference["solver"]         = bench.ReferenceName();
+      reference["error_estimate"] = bench.ReferenceError();
+      QJsonArray results;
+      for( auto run : runs )
+         results.append( JsonRun( run ) );
+
+      QJsonObject document;
+      document["problem"]   = parser.positionalArguments()[0];
+      document["t_init"]    = bench.TimeInit();
+      document["t_end"]     = bench.TimeEnd();
+      document["reference"] = reference;
+      document["runs"]      = results;
+      if( parser.isSet( budgetOption ) ){
+         document["budget"]   = budget;
+         document["cheapest"] = cheapest < 0 ? QJsonValue() : QJsonValue( JsonRun( runs[cheapest] ) );
+      }
+      out << QJsonDocument( document ).toJson();
+   } else {
+      out << "method,precision,dt,tolerance,steps,evaluations,seconds,error,relative_error\n";
+      for( auto run : runs ){
+         out << MethodName( run.method ) << ',' << PrecisionName( run.precision ) << ','
+             << QString::number( run.dt, 'g', 10 ) << ',' << QString::number( run.tolerance, 'g', 3 ) << ','
+             << run.steps << ',' << run.evaluations << ',' << QString::number( run.seconds, 'g', 6 ) << ','
+             << QString::number( run.error, 'g', 6 ) << ',' << QString::number( run.relativeError, 'g', 6 ) << '\n';
+      }
+      if( cheapest >= 0 ){
+         const WorkPrecisionRun &run = runs[cheapest];
+         std::cerr << "Fastest with error <= " << budget << ": " << MethodName( run.method ).toStdString()
+                   << ", " << PrecisionName( run.precision ).toStdString() << ", dt " << run.dt;
+         if( run.method == Method::Taylor )
+            std::cerr << ", tolerance " << run.tolerance;
+         std::cerr << " (" << run.seconds << " s, error " << run.error << ")" << std::endl;
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
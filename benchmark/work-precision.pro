@@ -0,0 +1,64 @@
+#-------------------------------------------------
+#
+# Work-precision benchmark of the integrators,
+# built separately from the plot window
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+QT       -= gui
+
+TARGET = work-precision
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES += \
+   main.cpp \
+   work_precision.cpp \
+   ../stepper.cpp \
+   ../runge_kutta_stepper.cpp \
+   ../precision_stepper.cpp \
+   ../taylor_stepper.cpp \
+   ../butcher_tableau.cpp \
+   ../delay_history.cpp \
+   ../expression.cpp \
+   ../double_double.cpp \
+   ../symbol_table.cpp \
+   ../parallel_evaluator.cpp
+
+HEADERS  += \
+   work_precision.hpp \
+   ../stepper.hpp \
+   ../runge_kutta_stepper.hpp \
+   ../precision_stepper.hpp \
+   ../taylor_stepper.hpp \
+   ../butcher_tableau.hpp \
+   ../delay_history.hpp \
+   ../expression.hpp \
+   ../double_double.hpp \
+   ../symbol_table.hpp \
+   ../parallel_evaluator.hpp \
+   ../ode_pathtracer.hpp
+
+# include muParser
+# TODO: rewrite this to no longer be system-specific :/
+
+compiling {
+   win32:CONFIG(release, debug|release): LIBS += -LE:/Coding/libraries/qt-libs/muparser-2.2.5/lib/ -lmuparser
+   else:win32:CONFIG(debug, debug|release): LIBS += -LE:/Coding/libraries/qt-libs/muparser-2.2.5/lib/ -lmuparserd
+
+   QMAKE_CXXFLAGS += -isystem E:/Coding/libraries/qt-libs/muparser-2.2.5/include
+   DEPENDPATH += E:/Coding/libraries/qt-libs/muparser-2.2.5/include
+
+   win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += E:/Coding/libraries/qt-libs/muparser-2.2.5/lib/libmuparser.a
+   else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += E:/Coding/libraries/qt-libs/muparser-2.2.5/lib/libmuparserd.a
+   else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += E:/Coding/libraries/qt-libs/muparser-2.2.5/lib/muparser.lib
+   else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += E:/Coding/libraries/qt-libs/muparser-2.2.5/lib/muparserd.lib
+}
+
+INCLUDEPATH += E:/Coding/libraries/qt-libs/muparser-2.2.5/include
@@ -0,0 +1,224 @@
+#include "work_precision.hpp"
+
+bool WorkPrecision::Load(
+   QString problemFile
+ , QString &error
+){
+   if( !QFileInfo( problemFile ).isReadable() ){
+      error = QString( "can't read %1" ).arg( problemFile );
+      return false;
+   }
+   QSettings inputFile( problemFile, QSettings::IniFormat );
+
+   if( inputFile.childGroups().contains( SECTION_VAR_DIFF ) ){
+      error = "stochastic problems have no single reference solution";
+      return false;
+   }
+
+   QStringList paramNames = inputFile.value( QString(SECTION_NAMES) + "/parameter_names", QStringList() ).toStringList();
+   QStringList varNames   = inputFile.value( QString(SECTION_NAMES) + "/variable_names",  QStringList() ).toStringList();
+   if( varNames.isEmpty() ){
+      error = "the problem has no variables";
+      return false;
+   }
+
+   // equations and initial values, as the plot window reads them
+   paramRules.resize( paramNames.size() );
+   for( int i = 0; i < paramRules.size(); i++ ){
+      paramRules[i].first  = paramNames[i];
+      paramRules[i].second = inputFile.value( QString(SECTION_PARAM_EQ) + "/" + paramNames[i], "0" ).toString();
+   }
+   varRules.resize( varNames.size() );
+   init.Val.clear();
+   for( int i = 0; i < varRules.size(); i++ ){
+      varRules[i].first  = varNames[i];
+      varRules[i].second = inputFile.value( QString(SECTION_VAR_DERIV) + "/" + varNames[i], "0" ).toString();
+      init.Val.push_back( inputFile.value( QString(SECTION_VAR_INIT) + "/" + varNames[i], 0.0 ).toDouble() );
+   }
+
+   rateGroups.clear();
+   inputFile.beginGroup( SECTION_RATES );
+   for( auto name : inputFile.childKeys() ){
+      rateGroups[name] = inputFile.value( name, 1 ).toInt();
+   }
+   inputFile.endGroup();
+
+   init.T = inputFile.value( QString(SECTION_TIME) + "/t_init", 0.0 ).toDouble();
+   dt     = inputFile.value( QString(SECTION_TIME) + "/dt",     0.1 ).toDouble();
+   tEnd   = inputFile.value( QString(SECTION_TIME) + "/t_end",  init.T + 100*dt ).toDouble();
+   if( !( dt > 0.0 ) ){
+      error = "dt must be positive";
+      return false;
+   }
+
+   problemPrecision = Precision::Double;
+   QString precisionName = inputFile.value( QString(SECTION_SOLVER) + "/precision", "double" ).toString();
+   if( !PrecisionFromName( precisionName, problemPrecision ) ){
+      qDebug() << "WARNING: Unknown precision" << precisionName << ", using double.";
+   }
+
+   delays = ContainsDelayTerms( varRules, paramRules );
+
+   return true;
+}
+
+double WorkPrecision::TimeInit(
+){
+   return init.T;
+}
+
+double WorkPrecision::TimeEnd(
+){
+   return tEnd;
+}
+
+void WorkPrecision::SetTimeEnd(
+   double t_end
+){
+   tEnd = t_end;
+}
+
+double WorkPrecision::Dt(
+){
+   return dt;
+}
+
+Precision WorkPrecision::ProblemPrecision(
+){
+   return problemPrecision;
+}
+
+bool WorkPrecision::HasDelays(
+){
+   return delays;
+}
+
+bool WorkPrecision::ComputeReference(
+   double smallestDt
+ , QString &error
+){
+   if( !( tEnd > init.T ) ){
+      error = "t_end must be after t_init";
+      return false;
+   }
+
+   // the reference is not multi-rate, rate groups are part of the error
+   qint64 steps, evaluations;
+   double seconds;
+   PointValues fine, coarse;
+   if( delays ){
+      double h = smallestDt / 16;
+      fine = Integrate( Method::RungeKutta6, Precision::Double, h, 0.0, QMap<QString, int>(), steps, evaluations, seconds );
+      referenceName = QString( "rk6, double, %1 steps" ).arg( steps );
+      coarse = Integrate( Method::RungeKutta6, Precision::Double, 2*h, 0.0, QMap<QString, int>(), steps, evaluations, seconds );
+   } else {
+      double span = tEnd - init.T;
+      fine   = Integrate( Method::Taylor, Precision::DoubleDouble, span, 1e-32, QMap<QString, int>(), steps, evaluations, seconds );
+      coarse = Integrate( Method::Taylor, Precision::DoubleDouble, span, 1e-28, QMap<QString, int>(), steps, evaluations, seconds );
+      referenceName = "taylor, double-double, tolerance 1e-32";
+   }
+
+   reference = fine.Val;
+   referenceError = 0.0;
+   for( int i = 0; i < reference.size(); i++ ){
+      double difference = std::abs( fine.Val[i] - coarse.Val[i] );
+      if( !( difference <= referenceError ) )
+         referenceError = difference;
+   }
+   if( !std::isfinite( referenceError ) ){
+      error = "the reference solution does not reach t_end";
+      return false;
+   }
+
+   return true;
+}
+
+QString WorkPrecision::ReferenceName(
+){
+   return referenceName;
+}
+
+double WorkPrecision::ReferenceError(
+){
+   return referenceError;
+}
+
+WorkPrecisionRun WorkPrecision::Run(
+   Method method
+ , Precision precision
+ , double step
+ , double tolerance
+ , int repeats
+){
+   WorkPrecisionRun run;
+   run.method    = method;
+   run.precision = precision;
+   run.tolerance = method == Method::Taylor ? tolerance : 0.0;
+   run.seconds   = std::numeric_limits<double>::infinity();
+
+   // the stepper is set up again for every repeat, only stepping is timed
+   PointValues last;
+   for( int r = 0; r < std::max( 1, repeats ); r++ ){
+      double seconds;
+      last = Integrate( method, precision, step, tolerance, rateGroups, run.steps, run.evaluations, seconds );
+      run.seconds = std::min( run.seconds, seconds );
+   }
+   run.dt = method == Method::Taylor ? step : ( tEnd - init.T ) / run.steps;
+
+   run.error         = 0.0;
+   run.relativeError = 0.0;
+   for( int i = 0; i < reference.size(); i++ ){
+      double difference = std::abs( last.Val.value( i, NAN ) - reference[i] );
+      double relative   = reference[i] != 0.0 ? difference / std::abs( reference[i] ) : difference;
+      if( !std::isfinite( difference ) )
+         difference = relative = std::numeric_limits<double>::infinity();
+      run.error         = std::max( run.error,         difference );
+      run.relativeError = std::max( run.relativeError, relative );
+   }
+
+   return run;
+}
+
+PointValues WorkPrecision::Integrate(
+   Method method
+ , Precision precision
+ , double step
+ , double tolerance
+ , QMap<QString, int> rates
+ , qint64 &steps
+ , qint64 &evaluations
+ , double &seconds
+){
+   // explicit methods take equal steps ending exactly on t_end
+   bool adaptive = method == Method::Taylor;
+   double span = tEnd - init.T;
+   qint64 count = adaptive ? 0 : std::max<qint64>( 1, std::llround( span / step ) );
+   double h = adaptive ? step : span / count;
+
+   Stepper *stepper = CreateStepper( precision, method, tolerance );
+   stepper->SetConditions( varRules, paramRules, init, h, rates );
+   qint64 before = stepper->Evaluations();
+
+   PointValues last;
+   QElapsedTimer timer;
+   timer.start();
+   if( adaptive ){
+      steps = 0;
+      do {
+         stepper->CalculateStep();
+         steps++;
+      } while( stepper->DenseEndTime() < tEnd && steps < MaxAdaptiveSteps );
+      last = stepper->DenseOutput( tEnd );
+      if( stepper->DenseEndTime() < tEnd )
+         last.Val.fill( NAN );
+   } else {
+      for( steps = 0; steps < count; steps++ )
+         last = stepper->CalculateStep();
+   }
+   seconds = timer.nsecsElapsed() * 1e-9;
+   evaluations = stepper->Evaluations() - before;
+
+   delete stepper;
+
+   return last;
+}
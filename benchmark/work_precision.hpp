@@ -0,0 +1,99 @@
+#ifndef WORK_PRECISION_HPP
+#define WORK_PRECISION_HPP
+
+// Qt headers
+#include <QSettings>
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QtDebug>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+#include <limits>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "stepper.hpp"
+#include "delay_history.hpp"
+
+// One integrator configuration, run from t_init to t_end.
+typedef struct {
+   Method    method;
+   Precision precision;
+   double    dt;             // step, or the longest step of taylor
+   double    tolerance;      // taylor only, 0 otherwise
+   qint64    steps;
+   qint64    evaluations;    // right-hand side evaluations
+   double    seconds;        // fastest of the repeats
+   double    error;          // largest absolute error at t_end
+   double    relativeError;  // largest error relative to the reference
+} WorkPrecisionRun;
+
+// Cost against accuracy of the integrators on a problem file.
+// The reference solution at t_end is the Taylor method in double-double
+// precision at a tolerance far below double rounding; computing it again
+// at a looser tolerance estimates its own error. Delay problems can only
+// be solved by the double precision Runge-Kutta stepper, so their
+// reference is rk6 with a sixteenth of the smallest step measured, checked
+// against an eighth.
+// Explicit methods take a whole number of equal steps to t_end, the step
+// closest to the one requested; taylor ends on its dense output.
+class WorkPrecision
+{
+public:
+   bool Load( QString problemFile
+            , QString &error );
+
+   double TimeInit();
+   double TimeEnd();
+   void SetTimeEnd( double t_end );
+   double Dt();
+   Precision ProblemPrecision();
+   bool HasDelays();
+
+   bool ComputeReference( double smallestDt
+                        , QString &error );
+   QString ReferenceName();
+   double ReferenceError();
+
+   WorkPrecisionRun Run( Method method
+                       , Precision precision
+                       , double dt
+                       , double tolerance
+                       , int repeats );
+
+private:
+   DerivationVector varRules;
+   EquationVector paramRules;
+   QMap<QString, int> rateGroups;
+   PointValues init;
+   double tEnd;
+   double dt;
+   Precision problemPrecision;
+   bool delays;
+
+   QVector<double> reference;
+   QString referenceName;
+   double referenceError;
+
+   // gives up on adaptive runs whose step collapses
+   static const qint64 MaxAdaptiveSteps = 100000000;
+
+   PointValues Integrate( Method method
+                        , Precision precision
+                        , double step
+                        , double tolerance
+                        , QMap<QString, int> rates
+                        , qint64 &steps
+                        , qint64 &evaluations
+                        , double &seconds );
+};
+
+#endif // WORK_PRECISION_HPP
@@ -0,0 +1,26 @@
+#include "butcher_tableau.hpp"
+
+// storage for the coefficients, which are also used at run time
+constexpr Fraction EulerTableau::A[1][1];
+constexpr Fraction EulerTableau::B[1];
+constexpr Fraction EulerTableau::C[1];
+
+constexpr Fraction HeunTableau::A[2][2];
+constexpr Fraction HeunTableau::B[2];
+constexpr Fraction HeunTableau::C[2];
+
+constexpr Fraction RungeKutta3Tableau::A[3][3];
+constexpr Fraction RungeKutta3Tableau::B[3];
+constexpr Fraction RungeKutta3Tableau::C[3];
+
+constexpr Fraction RungeKutta4Tableau::A[4][4];
+constexpr Fraction RungeKutta4Tableau::B[4];
+constexpr Fraction RungeKutta4Tableau::C[4];
+
+constexpr Fraction RungeKutta38Tableau::A[4][4];
+constexpr Fraction RungeKutta38Tableau::B[4];
+constexpr Fraction RungeKutta38Tableau::C[4];
+
+constexpr Fraction RungeKutta6Tableau::A[7][7];
+constexpr Fraction RungeKutta6Tableau::B[7];
+constexpr Fraction RungeKutta6Tableau::C[7];
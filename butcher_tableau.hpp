@@ -0,0 +1,179 @@
+#ifndef BUTCHER_TABLEAU_HPP
+#define BUTCHER_TABLEAU_HPP
+
+// Explicit Runge-Kutta methods, given by their Butcher tableaus.
+// A tableau has Stages, the stage matrix A (only below the diagonal is
+// used), the weights B and the nodes C. Steps are generated from it at
+// compile time: the stage loops are unrolled and zero coefficients
+// leave no code behind.
+// Coefficients are kept as fractions and divided out in the precision of
+// the step, so that weights like 1/6 are not rounded to double first.
+
+struct Fraction
+{
+   constexpr Fraction( long numerator, long denominator = 1 )
+      : num( numerator ), den( denominator ) {}
+   long num;
+   long den;
+};
+
+// a coefficient in Scalar precision
+template <typename Scalar>
+inline Scalar Coefficient( const Fraction &f ){
+   if( f.den == 1 )
+      return Scalar( (double)f.num );
+   return Scalar( (double)f.num ) / Scalar( (double)f.den );
+}
+
+struct EulerTableau
+{
+   static const int Stages = 1;
+   static constexpr Fraction A[1][1] = { { 0 } };
+   static constexpr Fraction B[1]    = { 1 };
+   static constexpr Fraction C[1]    = { 0 };
+};
+
+struct HeunTableau
+{
+   static const int Stages = 2;
+   static constexpr Fraction A[2][2] = { { 0, 0 }
+                                       , { 1, 0 } };
+   static constexpr Fraction B[2]    = { { 1, 2 }, { 1, 2 } };
+   static constexpr Fraction C[2]    = { 0, 1 };
+};
+
+// Kutta's third order method
+struct RungeKutta3Tableau
+{
+   static const int Stages = 3;
+   static constexpr Fraction A[3][3] = { {  0,        0, 0 }
+                                       , {  { 1, 2 }, 0, 0 }
+                                       , { -1,        2, 0 } };
+   static constexpr Fraction B[3]    = { { 1, 6 }, { 2, 3 }, { 1, 6 } };
+   static constexpr Fraction C[3]    = { 0, { 1, 2 }, 1 };
+};
+
+struct RungeKutta4Tableau
+{
+   static const int Stages = 4;
+   static constexpr Fraction A[4][4] = { { 0,        0,        0, 0 }
+                                       , { { 1, 2 }, 0,        0, 0 }
+                                       , { 0,        { 1, 2 }, 0, 0 }
+                                       , { 0,        0,        1, 0 } };
+   static constexpr Fraction B[4]    = { { 1, 6 }, { 1, 3 }, { 1, 3 }, { 1, 6 } };
+   static constexpr Fraction C[4]    = { 0, { 1, 2 }, { 1, 2 }, 1 };
+};
+
+// Kutta's 3/8 rule, fourth order
+struct RungeKutta38Tableau
+{
+   static const int Stages = 4;
+   static constexpr Fraction A[4][4] = { { 0,          0, 0, 0 }
+                                       , { { 1, 3 },   0, 0, 0 }
+                                       , { { -1, 3 },  1, 0, 0 }
+                                       , { 1,         -1, 1, 0 } };
+   static constexpr Fraction B[4]    = { { 1, 8 }, { 3, 8 }, { 3, 8 }, { 1, 8 } };
+   static constexpr Fraction C[4]    = { 0, { 1, 3 }, { 2, 3 }, 1 };
+};
+
+// Butcher's sixth order method with seven stages
+struct RungeKutta6Tableau
+{
+   static const int Stages = 7;
+   static constexpr Fraction A[7][7] = { { 0,          0,          0,          0,          0,        0,           0 }
+                                       , { { 1, 3 },   0,          0,          0,          0,        0,           0 }
+                                       , { 0,          { 2, 3 },   0,          0,          0,        0,           0 }
+                                       , { { 1, 12 },  { 1, 3 },   { -1, 12 }, 0,          0,        0,           0 }
+                                       , { { -1, 16 }, { 9, 8 },   { -3, 16 }, { -3, 8 },  0,        0,           0 }
+                                       , { 0,          { 9, 8 },   { -3, 8 },  { -3, 4 },  { 1, 2 }, 0,           0 }
+                                       , { { 9, 44 },  { -9, 11 }, { 63, 44 }, { 18, 11 }, 0,        { -16, 11 }, 0 } };
+   static constexpr Fraction B[7]    = { { 11, 120 }, 0, { 27, 40 }, { 27, 40 }, { -4, 15 }, { -4, 15 }, { 11, 120 } };
+   static constexpr Fraction C[7]    = { 0, { 1, 3 }, { 2, 3 }, { 1, 3 }, { 1, 2 }, { 1, 2 }, 1 };
+};
+
+namespace rk_detail {
+
+template <class T, int I, int J>
+struct IsZero {
+   static constexpr bool value = ( I < T::Stages ? T::A[I][J] : T::B[J] ).num == 0;
+};
+
+template <class T, int I>
+struct IsZero<T, I, -1> {
+   static constexpr bool value = true;
+};
+
+// sum over j <= J of A[I][j] * k[j][i]; row I == Stages holds the weights
+template <class T, int I, int J, bool Zero = IsZero<T, I, J>::value>
+struct Combination {
+   template <typename Scalar>
+   static Scalar Sum( const Scalar *const *k, int i ){
+      return Combination<T, I, J-1>::Sum( k, i )
+           + Coefficient<Scalar>( I < T::Stages ? T::A[I][J] : T::B[J] ) * k[J][i];
+   }
+};
+
+template <class T, int I, int J>
+struct Combination<T, I, J, true> {
+   template <typename Scalar>
+   static Scalar Sum( const Scalar *const *k, int i ){
+      return Combination<T, I, J-1>::Sum( k, i );
+   }
+};
+
+template <class T, int I>
+struct Combination<T, I, -1, true> {
+   template <typename Scalar>
+   static Scalar Sum( const Scalar *const *, int ){
+      return Scalar( 0 );
+   }
+};
+
+// stages I and up
+template <class T, int I, bool Done = ( I == T::Stages )>
+struct Stage {
+   template <typename Scalar, class Derive>
+   static void Run( Derive &derive
+                  , const Scalar &t
+                  , const Scalar &h
+                  , int n
+                  , const Scalar *y
+                  , Scalar *const *k
+                  , Scalar *stage ){
+      for( int i = 0; i < n; i++ )
+         stage[i] = y[i] + h * Combination<T, I, I-1>::Sum( k, i );
+      derive( t + Coefficient<Scalar>( T::C[I] ) * h, stage, k[I] );
+      Stage<T, I+1>::Run( derive, t, h, n, y, k, stage );
+   }
+};
+
+template <class T, int I>
+struct Stage<T, I, true> {
+   template <typename Scalar, class Derive>
+   static void Run( Derive &, const Scalar &, const Scalar &, int, const Scalar *, Scalar *const *, Scalar * ){
+   }
+};
+
+} // namespace rk_detail
+
+// One step of size h from (t, y) with n variables.
+// k[0] must hold the slope at (t, y), the other Stages-1 slope vectors
+// are filled in. derive( time, stage, slope ) evaluates the slopes at a
+// stage point; stage is scratch space for n values.
+template <class T, typename Scalar, class Derive>
+void ExplicitRungeKuttaStep(
+   Derive &derive
+ , const Scalar &t
+ , const Scalar &h
+ , int n
+ , const Scalar *y
+ , Scalar *const *k
+ , Scalar *stage
+ , Scalar *result
+){
+   rk_detail::Stage<T, 1>::Run( derive, t, h, n, y, k, stage );
+   for( int i = 0; i < n; i++ )
+      result[i] = y[i] + h * rk_detail::Combination<T, T::Stages, T::Stages-1>::Sum( k, i );
+}
+
+#endif // BUTCHER_TABLEAU_HPP
@@ -0,0 +1,110 @@
+#include "coordinate_transform.hpp"
+
+CoordinateTransform::CoordinateTransform(
+   QString transformationX
+ , QString transformationY
+ , QStringList paramNames
+){
+   t = 0.0;
+
+   // initialize parser
+   try {
+      // register parameters
+      paramVals.resize( paramNames.size() );
+      symbols.Reserve( paramVals.size() + 1 );
+      symbols.Define( "t", &t );
+      for( int i = 0; i < paramVals.size(); i++  ){
+         symbols.Define( paramNames[i], &(paramVals[i]) );
+      }
+      symbols.Bind( parserX );
+      symbols.Bind( parserY );
+
+      // set coordinate transformation
+      parserX.SetExpr( transformationX.toStdString() );
+      parserY.SetExpr( transformationY.toStdString() );
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+}
+
+CoordinateTransform::~CoordinateTransform(
+){
+   // stub
+}
+
+QPointF CoordinateTransform::Map(
+   const PointValues &point
+){
+   double x = 0, y = 0;
+
+   t = point.T;
+   for( int i = 0; i < paramVals.size(); i++  ){
+      paramVals[i] = point.Param[i];
+   }
+   try {
+      x = parserX.Eval();
+      y = parserY.Eval();
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return QPointF( x, y );
+}
+
+QPointF CoordinateTransform::Map(
+   double time
+ , const double *values
+ , const QVector<int> &paramIndices
+){
+   double x = 0, y = 0;
+
+   // parameters not listed keep their old values, the expressions
+   // don't use them
+   t = time;
+   for( int i = 0; i < paramIndices.size(); i++ ){
+      paramVals[paramIndices[i]] = values[i];
+   }
+   try {
+      x = parserX.Eval();
+      y = parserY.Eval();
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return QPointF( x, y );
+}
+
+QVector<int> CoordinateTransform::UsedParams(
+){
+   QVector<int> used;
+
+   // symbols resolve to their addresses in paramVals
+   try {
+      mu::varmap_type varsX = parserX.GetUsedVar();
+      mu::varmap_type varsY = parserY.GetUsedVar();
+      for( int i = 0; i < paramVals.size(); i++ ){
+         const double *address = &paramVals[i];
+         bool inX = std::any_of( varsX.begin(), varsX.end(), [address]( const mu::varmap_type::value_type &v ){ return v.second == address; } );
+         bool inY = std::any_of( varsY.begin(), varsY.end(), [address]( const mu::varmap_type::value_type &v ){ return v.second == address; } );
+         if( inX || inY )
+            used.append( i );
+      }
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return used;
+}
+
+void CoordinateTransform::ParserError(
+   mu::ParserBase::exception_type &e
+){
+   std::cerr << std::endl << "Parsing error:" << std::endl;
+   std::cerr << "------" << std::endl;
+   std::cerr << "Message:  " << e.GetMsg()   << std::endl;
+   std::cerr << "Formula:  " << e.GetExpr()  << std::endl;
+   std::cerr << "Token:    " << e.GetToken() << std::endl;
+   std::cerr << "Position: " << e.GetPos()   << std::endl;
+   std::cerr << "Errcode:  " << e.GetCode()  << std::endl;
+   exit( EXIT_FAILURE );
+}
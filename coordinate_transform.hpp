@@ -0,0 +1,53 @@
+#ifndef COORDINATE_TRANSFORM_HPP
+#define COORDINATE_TRANSFORM_HPP
+
+// Qt headers
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// C headers
+#include <cstdlib>
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+
+// math expression parsing header
+#include "muParser.h"
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "symbol_table.hpp"
+
+// Maps a point of the trajectory to plot coordinates using the
+// x_transform and y_transform expressions.
+// Parsers are not thread safe, so every thread needs its own instance.
+class CoordinateTransform
+{
+public:
+   CoordinateTransform( QString transformationX
+                      , QString transformationY
+                      , QStringList paramNames );
+   ~CoordinateTransform();
+
+   QPointF Map( const PointValues &point );
+   QPointF Map( double time
+              , const double *values
+              , const QVector<int> &paramIndices );
+
+   // parameters the transformation depends on
+   QVector<int> UsedParams();
+
+private:
+   double t;
+   QVector<double> paramVals;
+   mu::Parser parserX;
+   mu::Parser parserY;
+   SymbolTable symbols;
+
+   void ParserError( mu::Parser::exception_type &e );
+};
+
+#endif // COORDINATE_TRANSFORM_HPP
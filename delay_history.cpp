@@ -0,0 +1,234 @@
+#include "delay_history.hpp"
+
+QString ExtractDelayTerms(
+   QString expression
+ , const QStringList &varNames
+ , QVector<DelayTerm> &terms
+){
+   QString result;
+   int pos = 0;
+   while( pos < expression.size() ){
+      // copy anything that isn't a name
+      QChar c = expression[pos];
+      if( !c.isLetter() && c != '_' ){
+         result += c;
+         pos++;
+         continue;
+      }
+
+      int start = pos;
+      while( pos < expression.size() && ( expression[pos].isLetterOrNumber() || expression[pos] == '_' ) )
+         pos++;
+      QString name = expression.mid( start, pos - start );
+      int var = varNames.indexOf( name );
+
+      // a variable called like a function, with t - lag as its argument
+      int open = pos;
+      while( open < expression.size() && expression[open].isSpace() )
+         open++;
+      if( var < 0 || open >= expression.size() || expression[open] != '(' ){
+         result += name;
+         continue;
+      }
+      int close = open + 1;
+      for( int depth = 1; close < expression.size(); close++ ){
+         if( expression[close] == '(' )
+            depth++;
+         if( expression[close] == ')' && --depth == 0 )
+            break;
+      }
+      QString argument = expression.mid( open + 1, close - open - 1 ).trimmed();
+      if( close >= expression.size() || !argument.startsWith( 't' ) ){
+         result += name;
+         continue;
+      }
+      QString lag = argument.mid( 1 ).trimmed();
+      if( !lag.startsWith( '-' ) ){
+         result += name;
+         continue;
+      }
+      lag = lag.mid( 1 ).trimmed();
+
+      // same variable and lag, same term
+      int found = -1;
+      for( int k = 0; k < terms.size() && found < 0; k++ )
+         if( terms[k].var == var && terms[k].lag == lag )
+            found = k;
+      if( found < 0 ){
+         DelayTerm term;
+         term.var    = var;
+         term.column = -1;
+         for( const DelayTerm &other : terms )
+            if( other.var == var )
+               term.column = other.column;
+         if( term.column < 0 ){
+            term.column = 0;
+            for( const DelayTerm &other : terms )
+               term.column = std::max( term.column, other.column + 1 );
+         }
+         term.lag    = lag;
+         term.symbol = QString( "_delay%1" ).arg( terms.size() );
+         terms.push_back( term );
+         found = terms.size() - 1;
+      }
+
+      result += terms[found].symbol;
+      pos = close + 1;
+   }
+
+   return result;
+}
+
+bool ContainsDelayTerms(
+   const DerivationVector &ddt_rules
+ , const EquationVector &param_rules
+){
+   QStringList varNames;
+   for( const Derivation &rule : ddt_rules )
+      varNames << rule.first;
+
+   QVector<DelayTerm> terms;
+   for( const Derivation &rule : ddt_rules )
+      ExtractDelayTerms( rule.second, varNames, terms );
+   for( const Equation &rule : param_rules )
+      ExtractDelayTerms( rule.second, varNames, terms );
+
+   return !terms.isEmpty();
+}
+
+DelayHistory::DelayHistory(
+){
+   startTime = 0.0;
+}
+
+void DelayHistory::Reset(
+   QVector<int> columnVars
+ , double t_init
+ , const QVector<double> &val_init
+){
+   vars      = columnVars;
+   startTime = t_init;
+   initial.resize( vars.size() );
+   for( int c = 0; c < vars.size(); c++ )
+      initial[c] = val_init[vars[c]];
+
+   stride   = 2 + 4 * vars.size();
+   capacity = 64;
+   segments.fill( 0.0, capacity * stride );
+   first = 0;
+   count = 0;
+}
+
+void DelayHistory::Append(
+   double t0
+ , double h
+ , const double *y0
+ , const double *y1
+ , const double *f0
+ , const double *f1
+){
+   if( capacity == 0 )
+      return;
+
+   // a jump in time, e.g. after seeking, starts a new past
+   double end = EndTime();
+   if( std::abs( t0 - end ) > 1e-9 * std::max( 1.0, std::abs( end ) ) ){
+      startTime = t0;
+      for( int c = 0; c < vars.size(); c++ )
+         initial[c] = y0[vars[c]];
+      first += count;
+      count = 0;
+   }
+
+   if( count == capacity )
+      Grow();
+
+   double *segment = segments.data() + ( ( first + count ) % capacity ) * stride;
+   segment[0] = t0;
+   segment[1] = h;
+   for( int c = 0; c < vars.size(); c++ ){
+      double *column = segment + 2 + 4*c;
+      column[0] = y0[vars[c]];
+      column[1] = y1[vars[c]];
+      column[2] = f0[vars[c]];
+      column[3] = f1[vars[c]];
+   }
+   count++;
+}
+
+void DelayHistory::Trim(
+   double horizon
+){
+   // the oldest segment stays as long as it reaches the horizon
+   while( count > 1 ){
+      const double *segment = Segment( first );
+      if( segment[0] + segment[1] >= horizon )
+         break;
+      first++;
+      count--;
+   }
+}
+
+double DelayHistory::Value(
+   int column
+ , double time
+ , qint64 &cursor
+) const {
+   if( count == 0 || time <= startTime )
+      return initial[column];
+
+   // walk from the last segment found; the lag is fixed or changes
+   // slowly, so this is usually one or two comparisons
+   cursor = std::max( first, std::min( cursor, first + count - 1 ) );
+   const double *segment = Segment( cursor );
+   while( time < segment[0] && cursor > first )
+      segment = Segment( --cursor );
+   while( time > segment[0] + segment[1] && cursor < first + count - 1 )
+      segment = Segment( ++cursor );
+   if( time < segment[0] )
+      return segment[2 + 4*column];
+
+   // cubic Hermite interpolation, as the steppers' dense output
+   const double *y = segment + 2 + 4*column;
+   double H = segment[1];
+   double theta = ( time - segment[0] ) / H;
+   double a = 1.0 - theta;
+   double dy = y[1] - y[0];
+
+   return a*y[0] + theta*y[1]
+        + theta*(theta-1.0) * ( (1.0-2.0*theta)*dy
+                              + (theta-1.0)*H*y[2]
+                              + theta*H*y[3] );
+}
+
+int DelayHistory::Count(
+) const {
+   return (int)count;
+}
+
+double DelayHistory::EndTime(
+) const {
+   if( count == 0 )
+      return startTime;
+
+   const double *segment = Segment( first + count - 1 );
+   return segment[0] + segment[1];
+}
+
+const double *DelayHistory::Segment(
+   qint64 serial
+) const {
+   return segments.constData() + ( serial % capacity ) * stride;
+}
+
+void DelayHistory::Grow(
+){
+   // twice the size; segments keep their serials, so cursors stay valid
+   int grownCapacity = 2 * capacity;
+   QVector<double> grown( grownCapacity * stride );
+   for( qint64 s = first; s < first + count; s++ )
+      std::copy( Segment( s ), Segment( s ) + stride, grown.data() + ( s % grownCapacity ) * stride );
+
+   segments = grown;
+   capacity = grownCapacity;
+}
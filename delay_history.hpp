@@ -0,0 +1,88 @@
+#ifndef DELAY_HISTORY_HPP
+#define DELAY_HISTORY_HPP
+
+// Qt headers
+#include <QVector>
+#include <QString>
+#include <QStringList>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+
+// Delayed value of a variable, written x(t - lag) in the equations.
+// The term is replaced by symbol, which the stepper sets to the value of
+// variable var lag time units ago, kept in history column column.
+typedef struct {
+   int var;
+   int column;
+   QString lag;
+   QString symbol;
+} DelayTerm;
+
+// Rewrites the delay terms of expression to their symbols. Terms already
+// in terms are reused, new ones are appended.
+QString ExtractDelayTerms( QString expression
+                         , const QStringList &varNames
+                         , QVector<DelayTerm> &terms );
+bool ContainsDelayTerms( const DerivationVector &ddt_rules
+                       , const EquationVector &param_rules );
+
+// Past of the delayed variables, as the dense output segments of the
+// steps taken, one cubic Hermite segment per step in a contiguous ring.
+// Segments older than the horizon passed to Trim() are dropped, so memory
+// is bounded by the largest delay, not by the length of the run.
+// Before the first segment, variables keep their initial values; after
+// the last one, the last segment is extrapolated.
+class DelayHistory
+{
+public:
+   DelayHistory( void );
+
+   // columns are the variables that are kept
+   void Reset( QVector<int> columnVars
+             , double t_init
+             , const QVector<double> &val_init );
+
+   // appends the step from t0 to t0 + h; all arguments hold every
+   // variable, only the columns are kept. A step that doesn't continue
+   // the history restarts it from y0.
+   void Append( double t0
+              , double h
+              , const double *y0
+              , const double *y1
+              , const double *f0
+              , const double *f1 );
+   void Trim( double horizon );
+
+   // value of column at time; cursor remembers the segment of the last
+   // lookup, so lookups that move along with the solution are O(1)
+   double Value( int column
+               , double time
+               , qint64 &cursor ) const;
+
+   int Count() const;
+   double EndTime() const;
+
+private:
+   QVector<int> vars;
+   QVector<double> initial;
+   double startTime;
+
+   // segment s is in slot s % capacity: t0, h, then y0 y1 f0 f1 per column
+   QVector<double> segments;
+   int capacity = 0;
+   int stride = 2;
+   qint64 first = 0;
+   qint64 count = 0;
+
+   const double *Segment( qint64 serial ) const;
+   void Grow();
+};
+
+#endif // DELAY_HISTORY_HPP
@@ -0,0 +1,234 @@
+#include "dense_linear.hpp"
+
+bool SolveLinear(
+   QVector<double> a
+ , QVector<double> &b
+ , int n
+){
+   // forward elimination
+   for( int c = 0; c < n; c++ ){
+      int pivot = c;
+      for( int r = c+1; r < n; r++ )
+         if( std::abs( a[r*n+c] ) > std::abs( a[pivot*n+c] ) )
+            pivot = r;
+      if( a[pivot*n+c] == 0.0 )
+         return false;
+
+      if( pivot != c ){
+         for( int j = c; j < n; j++ )
+            std::swap( a[c*n+j], a[pivot*n+j] );
+         std::swap( b[c], b[pivot] );
+      }
+
+      for( int r = c+1; r < n; r++ ){
+         double factor = a[r*n+c] / a[c*n+c];
+         if( factor == 0.0 )
+            continue;
+         for( int j = c+1; j < n; j++ )
+            a[r*n+j] -= factor * a[c*n+j];
+         b[r] -= factor * b[c];
+      }
+   }
+
+   // back substitution
+   for( int r = n-1; r >= 0; r-- ){
+      double sum = b[r];
+      for( int j = r+1; j < n; j++ )
+         sum -= a[r*n+j] * b[j];
+      b[r] = sum / a[r*n+r];
+   }
+
+   return true;
+}
+
+bool Eigenvalues(
+   QVector<double> a
+ , int n
+ , QVector<double> &re
+ , QVector<double> &im
+){
+   auto A = [&a, n]( int i, int j ) -> double & { return a[i*n+j]; };
+   auto sign = []( double x, double y ){ return y >= 0.0 ? std::abs( x ) : -std::abs( x ); };
+   const double eps = std::numeric_limits<double>::epsilon();
+
+   re.fill( 0.0, n );
+   im.fill( 0.0, n );
+
+   // reduction to upper Hessenberg form by elimination with pivoting
+   for( int m = 1; m < n-1; m++ ){
+      double x = 0.0;
+      int pivot = m;
+      for( int j = m; j < n; j++ ){
+         if( std::abs( A( j, m-1 ) ) > std::abs( x ) ){
+            x = A( j, m-1 );
+            pivot = j;
+         }
+      }
+      if( pivot != m ){
+         for( int j = m-1; j < n; j++ )
+            std::swap( A( pivot, j ), A( m, j ) );
+         for( int j = 0; j < n; j++ )
+            std::swap( A( j, pivot ), A( j, m ) );
+      }
+      if( x != 0.0 ){
+         for( int i = m+1; i < n; i++ ){
+            double y = A( i, m-1 );
+            if( y == 0.0 )
+               continue;
+            y /= x;
+            A( i, m-1 ) = 0.0;
+            for( int j = m; j < n; j++ )
+               A( i, j ) -= y * A( m, j );
+            for( int j = 0; j < n; j++ )
+               A( j, m ) += y * A( j, i );
+         }
+      }
+   }
+
+   // shifted QR iteration on the Hessenberg matrix, deflating one real
+   // eigenvalue or a pair at a time from the bottom
+   double norm = 0.0;
+   for( int i = 0; i < n; i++ )
+      for( int j = std::max( i-1, 0 ); j < n; j++ )
+         norm += std::abs( A( i, j ) );
+
+   int nn = n-1;
+   double t = 0.0;
+   while( nn >= 0 ){
+      int its = 0;
+      int l;
+      do {
+         // look for a small subdiagonal element
+         for( l = nn; l > 0; l-- ){
+            double s = std::abs( A( l-1, l-1 ) ) + std::abs( A( l, l ) );
+            if( s == 0.0 )
+               s = norm;
+            if( std::abs( A( l, l-1 ) ) <= eps * s ){
+               A( l, l-1 ) = 0.0;
+               break;
+            }
+         }
+
+         double x = A( nn, nn );
+         if( l == nn ){
+            // one root
+            re[nn] = x + t;
+            nn--;
+         } else {
+            double y = A( nn-1, nn-1 );
+            double w = A( nn, nn-1 ) * A( nn-1, nn );
+            if( l == nn-1 ){
+               // two roots
+               double p = 0.5 * ( y - x );
+               double q = p*p + w;
+               double z = std::sqrt( std::abs( q ) );
+               x += t;
+               if( q >= 0.0 ){
+                  z = p + sign( z, p );
+                  re[nn-1] = re[nn] = x + z;
+                  if( z != 0.0 )
+                     re[nn] = x - w / z;
+               } else {
+                  re[nn-1] = re[nn] = x + p;
+                  im[nn-1] = z;
+                  im[nn]   = -z;
+               }
+               nn -= 2;
+            } else {
+               if( its == 30 )
+                  return false;
+               if( its == 10 || its == 20 ){
+                  // exceptional shift
+                  t += x;
+                  for( int i = 0; i <= nn; i++ )
+                     A( i, i ) -= x;
+                  double s = std::abs( A( nn, nn-1 ) ) + std::abs( A( nn-1, nn-2 ) );
+                  y = x = 0.75 * s;
+                  w = -0.4375 * s * s;
+               }
+               its++;
+
+               // two consecutive small subdiagonal elements
+               int m;
+               double p = 0.0, q = 0.0, r = 0.0, z;
+               for( m = nn-2; m >= l; m-- ){
+                  z = A( m, m );
+                  r = x - z;
+                  double s = y - z;
+                  p = ( r*s - w ) / A( m+1, m ) + A( m, m+1 );
+                  q = A( m+1, m+1 ) - z - r - s;
+                  r = A( m+2, m+1 );
+                  s = std::abs( p ) + std::abs( q ) + std::abs( r );
+                  p /= s;
+                  q /= s;
+                  r /= s;
+                  if( m == l )
+                     break;
+                  double u = std::abs( A( m, m-1 ) ) * ( std::abs( q ) + std::abs( r ) );
+                  double v = std::abs( p ) * ( std::abs( A( m-1, m-1 ) ) + std::abs( z ) + std::abs( A( m+1, m+1 ) ) );
+                  if( u <= eps * v )
+                     break;
+               }
+               for( int i = m; i < nn-1; i++ ){
+                  A( i+2, i ) = 0.0;
+                  if( i != m )
+                     A( i+2, i-1 ) = 0.0;
+               }
+
+               // double QR step on rows l to nn and columns m to nn
+               for( int k = m; k < nn; k++ ){
+                  if( k != m ){
+                     p = A( k, k-1 );
+                     q = A( k+1, k-1 );
+                     r = 0.0;
+                     if( k+1 != nn )
+                        r = A( k+2, k-1 );
+                     x = std::abs( p ) + std::abs( q ) + std::abs( r );
+                     if( x != 0.0 ){
+                        p /= x;
+                        q /= x;
+                        r /= x;
+                     }
+                  }
+                  double s = sign( std::sqrt( p*p + q*q + r*r ), p );
+                  if( s == 0.0 )
+                     continue;
+                  if( k == m ){
+                     if( l != m )
+                        A( k, k-1 ) = -A( k, k-1 );
+                  } else {
+                     A( k, k-1 ) = -s * x;
+                  }
+                  p += s;
+                  x = p / s;
+                  y = q / s;
+                  z = r / s;
+                  q /= p;
+                  r /= p;
+                  for( int j = k; j <= nn; j++ ){
+                     p = A( k, j ) + q * A( k+1, j );
+                     if( k+1 != nn ){
+                        p += r * A( k+2, j );
+                        A( k+2, j ) -= p * z;
+                     }
+                     A( k+1, j ) -= p * y;
+                     A( k, j ) -= p * x;
+                  }
+                  int last = std::min( nn, k+3 );
+                  for( int i = l; i <= last; i++ ){
+                     p = x * A( i, k ) + y * A( i, k+1 );
+                     if( k+1 != nn ){
+                        p += z * A( i, k+2 );
+                        A( i, k+2 ) -= p * r;
+                     }
+                     A( i, k+1 ) -= p * q;
+                     A( i, k ) -= p;
+                  }
+               }
+            }
+         }
+      } while( l+1 < nn );
+   }
+
+   return true;
+}
@@ -0,0 +1,31 @@
+#ifndef DENSE_LINEAR_HPP
+#define DENSE_LINEAR_HPP
+
+// Qt headers
+#include <QVector>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <limits>
+#include <algorithm>
+
+// Small dense matrix routines for the Newton-type solvers.
+// Matrices are n x n, row major: element (i, j) is at i*n + j.
+
+// Solves a x = b by Gaussian elimination with partial pivoting; b is
+// replaced by x. Returns false if a is singular.
+bool SolveLinear( QVector<double> a
+                , QVector<double> &b
+                , int n );
+
+// Eigenvalues of a general real matrix, by reduction to Hessenberg form
+// and the shifted QR algorithm. Complex pairs come out next to each
+// other. Returns false if the iteration doesn't converge.
+bool Eigenvalues( QVector<double> a
+                , int n
+                , QVector<double> &re
+                , QVector<double> &im );
+
+#endif // DENSE_LINEAR_HPP
@@ -0,0 +1,162 @@
+#include "density_histogram.hpp"
+
+DensityHistogram::DensityHistogram(
+   QRectF histogramArea
+ , int histogramWidth
+ , int histogramHeight
+){
+   area   = histogramArea.normalized();
+   width  = std::max( 1, histogramWidth );
+   height = std::max( 1, histogramHeight );
+   counts.fill( 0, width*height );
+}
+
+void DensityHistogram::Clear(
+){
+   QMutexLocker lock( &mutex );
+   counts.fill( 0 );
+   total = 0;
+   maxCount = 0;
+}
+
+quint64 DensityHistogram::Total(
+){
+   QMutexLocker lock( &mutex );
+   return total;
+}
+
+QRectF DensityHistogram::Area(
+){
+   return area;
+}
+
+void DensityHistogram::MergeFrom(
+   QVector<quint32> &partial
+ , QVector<int> &bins
+ , int points
+){
+   QMutexLocker lock( &mutex );
+
+   // only the bins hit since the last merge, which also resets them
+   for( int bin : bins ){
+      quint64 count = counts[bin] + partial[bin];
+      counts[bin] = count;
+      maxCount = std::max( maxCount, count );
+      partial[bin] = 0;
+   }
+   total += points;
+}
+
+// white for no hits, through red to black at the maximum
+static QRgb ToneColor(
+   double v
+){
+   int r  = 255 * ( 1.0 - std::max( 0.0, 2.0*v - 1.0 ) );
+   int gb = 255 * ( 1.0 - std::min( 1.0, 2.0*v ) );
+   return qRgb( r, gb, gb );
+}
+
+// tone of a count before scaling to the maximum
+double DensityHistogram::Tone(
+   quint64 count
+ , ToneMapping mode
+ , double gamma
+){
+   if( mode == ToneMapping::Log )
+      return std::log1p( (double)count );
+   return std::pow( (double)count, 1.0 / gamma );
+}
+
+QImage DensityHistogram::Render(
+   ToneMapping mode
+ , double gamma
+){
+   QImage image( width, height, QImage::Format_RGB32 );
+
+   QMutexLocker renderLock( &renderMutex );
+   quint64 peak;
+   {
+      QMutexLocker lock( &mutex );
+      peak = maxCount;
+      if( peak > 0 ){
+         renderCounts.resize( counts.size() );
+         std::copy( counts.constBegin(), counts.constEnd(), renderCounts.begin() );
+      }
+   }
+   if( peak == 0 ){
+      image.fill( Qt::white );
+      return image;
+   }
+
+   // tones of the low counts, which cover most of the image
+   if( toneTable.isEmpty() || mode != tableMode || gamma != tableGamma ){
+      toneTable.resize( ToneTableSize );
+      for( int i = 0; i < ToneTableSize; i++ )
+         toneTable[i] = Tone( i, mode, gamma );
+      tableMode  = mode;
+      tableGamma = gamma;
+   }
+   if( palette.isEmpty() ){
+      palette.resize( PaletteSize );
+      for( int i = 0; i < PaletteSize; i++ )
+         palette[i] = ToneColor( (double)i / ( PaletteSize - 1 ) );
+   }
+
+   double scale = ( PaletteSize - 1 ) / Tone( peak, mode, gamma );
+   for( int row = 0; row < height; row++ ){
+      QRgb *line = reinterpret_cast<QRgb *>( image.scanLine( row ) );
+      const quint64 *source = renderCounts.constData() + row*width;
+      for( int col = 0; col < width; col++ ){
+         quint64 count = source[col];
+         double tone = count < (quint64)ToneTableSize ? toneTable[count] : Tone( count, mode, gamma );
+         line[col] = palette[std::min( PaletteSize - 1, (int)( tone * scale + 0.5 ) )];
+      }
+   }
+
+   return image;
+}
+
+DensityHistogram::Accumulator::Accumulator(
+   DensityHistogram *histogram
+ , QString transformationX
+ , QString transformationY
+ , QStringList paramNames
+) :
+   transform( transformationX, transformationY, paramNames )
+{
+   target = histogram;
+   counts.fill( 0, target->width*target->height );
+}
+
+DensityHistogram::Accumulator::~Accumulator(
+){
+   Merge();
+}
+
+void DensityHistogram::Accumulator::Add(
+   const PointValues &point
+){
+   // points outside the area are counted in the total only
+   QPointF p = transform.Map( point );
+   const QRectF &area = target->area;
+   double col = ( p.x() - area.left() ) / area.width()  * target->width;
+   double row = ( area.bottom() - p.y() ) / area.height() * target->height;
+   if( col >= 0 && col < target->width && row >= 0 && row < target->height ){
+      int bin = (int)row * target->width + (int)col;
+      if( counts[bin]++ == 0 )
+         touched.append( bin );
+   }
+
+   if( ++pending >= MergePoints )
+      Merge();
+}
+
+void DensityHistogram::Accumulator::Merge(
+){
+   if( pending == 0 )
+      return;
+
+   target->MergeFrom( counts, touched, pending );
+   touched.clear();
+   pending = 0;
+}
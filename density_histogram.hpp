@@ -0,0 +1,99 @@
+#ifndef DENSITY_HISTOGRAM_HPP
+#define DENSITY_HISTOGRAM_HPP
+
+// Qt headers
+#include <QRectF>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "coordinate_transform.hpp"
+
+enum class ToneMapping { Log, Gamma };
+
+// Hit counts of trajectory points over the plot area, for showing the
+// invariant measure of attractors. Memory depends on the resolution only.
+// Producing threads add points to their own Accumulator, which is merged
+// into the shared counts every MergePoints points or on Merge(), so the
+// shared counts are locked once per batch instead of once per point.
+// Row 0 is the top of the area.
+// Rendering copies the counts and works on the copy, so producers are
+// only held for the copy. The tone of a count is looked up in a table of
+// the low counts, rebuilt when the tone mapping or gamma changes, and
+// scaled to the maximum; the palette is a table over the tone.
+class DensityHistogram
+{
+public:
+   DensityHistogram( QRectF area
+                   , int width
+                   , int height );
+
+   // partial histogram of one thread
+   class Accumulator
+   {
+   public:
+      Accumulator( DensityHistogram *histogram
+                 , QString transformationX
+                 , QString transformationY
+                 , QStringList paramNames );
+      ~Accumulator();
+
+      void Add( const PointValues &point );
+      void Merge();
+
+   private:
+      static const int MergePoints = 65536;
+
+      DensityHistogram *target;
+      CoordinateTransform transform;
+      QVector<quint32> counts;
+      QVector<int> touched;    // bins with nonzero counts
+      int pending = 0;
+   };
+
+   void Clear();
+   quint64 Total();
+   QRectF Area();
+   QImage Render( ToneMapping mode
+                , double gamma );
+
+private:
+   QRectF area;
+   int width;
+   int height;
+
+   QMutex mutex;
+   QVector<quint64> counts;
+   quint64 total = 0;
+   quint64 maxCount = 0;
+
+   // renderer state
+   static const int ToneTableSize = 4096;
+   static const int PaletteSize   = 4096;
+   QMutex renderMutex;
+   QVector<quint64> renderCounts;
+   QVector<double> toneTable;
+   ToneMapping tableMode = ToneMapping::Log;
+   double tableGamma = 0.0;
+   QVector<QRgb> palette;
+
+   double Tone( quint64 count
+              , ToneMapping mode
+              , double gamma );
+
+   void MergeFrom( QVector<quint32> &partial
+                 , QVector<int> &bins
+                 , int points );
+};
+
+#endif // DENSITY_HISTOGRAM_HPP
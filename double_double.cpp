@@ -0,0 +1,399 @@
+#include "double_double.hpp"
+
+// C headers
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+
+static const DoubleDouble Ln2(     0.6931471805599453, 2.3190468138462996e-17 );
+static const DoubleDouble Ln10(    2.302585092994046, -2.1707562233822494e-16 );
+static const DoubleDouble TwoPi(   6.283185307179586,  2.4492935982947064e-16 );
+static const DoubleDouble PiOver2( 1.5707963267948966, 6.123233995736766e-17 );
+
+static const double Epsilon = 4.93038065763132e-32; // 2^-104
+
+static DoubleDouble Nan(
+){
+   return DoubleDouble( std::numeric_limits<double>::quiet_NaN() );
+}
+
+static DoubleDouble Ldexp(
+   const DoubleDouble &a
+ , int exponent
+){
+   return DoubleDouble( std::ldexp( a.hi, exponent ), std::ldexp( a.lo, exponent ) );
+}
+
+static DoubleDouble IntegerPower(
+   DoubleDouble a
+ , long long n
+){
+   bool invert = n < 0;
+   n = invert ? -n : n;
+
+   DoubleDouble result( 1.0 );
+   while( n > 0 ){
+      if( n & 1 )
+         result *= a;
+      a *= a;
+      n >>= 1;
+   }
+
+   return invert ? DoubleDouble( 1.0 ) / result : result;
+}
+
+DoubleDouble DoubleDouble::FromString(
+   const std::string &text
+){
+   // digits are accumulated exactly, then scaled by a power of ten
+   const char *p = text.c_str();
+   while( std::isspace( (unsigned char)*p ) )
+      p++;
+
+   bool negative = false;
+   if( *p == '+' || *p == '-' )
+      negative = ( *p++ == '-' );
+
+   DoubleDouble value;
+   int exponent = 0;
+   bool point = false;
+   for( ; std::isdigit( (unsigned char)*p ) || ( *p == '.' && !point ); p++ ){
+      if( *p == '.' ){
+         point = true;
+         continue;
+      }
+      value = value * 10.0 + DoubleDouble( *p - '0' );
+      if( point )
+         exponent--;
+   }
+   if( *p == 'e' || *p == 'E' )
+      exponent += std::atoi( p + 1 );
+
+   if( exponent > 0 )
+      value = value * IntegerPower( DoubleDouble( 10.0 ), exponent );
+   else if( exponent < 0 )
+      value = value / IntegerPower( DoubleDouble( 10.0 ), -exponent );
+
+   return negative ? -value : value;
+}
+
+DoubleDouble abs(
+   const DoubleDouble &a
+){
+   return a.hi < 0.0 ? -a : a;
+}
+
+DoubleDouble fabs(
+   const DoubleDouble &a
+){
+   return abs( a );
+}
+
+DoubleDouble floor(
+   const DoubleDouble &a
+){
+   double hi = std::floor( a.hi );
+   if( hi != a.hi )
+      return DoubleDouble( hi );
+
+   // integral high part, the low part decides
+   double lo = std::floor( a.lo );
+   hi = dd_detail::QuickTwoSum( hi, lo, lo );
+   return DoubleDouble( hi, lo );
+}
+
+DoubleDouble rint(
+   const DoubleDouble &a
+){
+   double hi = std::rint( a.hi );
+   if( hi == a.hi ){
+      double lo = std::rint( a.lo );
+      hi = dd_detail::QuickTwoSum( hi, lo, lo );
+      return DoubleDouble( hi, lo );
+   }
+
+   // a tie in the high part is broken by the low part
+   if( hi - a.hi == -0.5 && a.lo > 0.0 )
+      hi += 1.0;
+   else if( hi - a.hi == 0.5 && a.lo < 0.0 )
+      hi -= 1.0;
+   return DoubleDouble( hi );
+}
+
+DoubleDouble sqrt(
+   const DoubleDouble &a
+){
+   if( a.hi <= 0.0 )
+      return a.hi == 0.0 ? DoubleDouble() : Nan();
+
+   // one Newton step from the double result
+   double x = std::sqrt( a.hi );
+   DoubleDouble x2 = DoubleDouble( x ) * x;
+   return DoubleDouble( x ) + ( a - x2 ).hi / ( 2.0 * x );
+}
+
+DoubleDouble exp(
+   const DoubleDouble &a
+){
+   if( a.hi > 709.7 )
+      return DoubleDouble( HUGE_VAL );
+   if( a.hi < -745.0 )
+      return DoubleDouble();
+   if( a.hi != a.hi )
+      return a;
+
+   // exp(a) = 2^m * exp(r)^512, |r| <= ln2/1024
+   double m = std::floor( a.hi / Ln2.hi + 0.5 );
+   DoubleDouble r = Ldexp( a - Ln2 * m, -9 );
+
+   // series of exp(r) - 1
+   DoubleDouble term = r;
+   DoubleDouble sum  = r;
+   for( int i = 2; i < 20 && std::abs( term.hi ) > Epsilon * 1e-3; i++ ){
+      term = term * r / DoubleDouble( i );
+      sum += term;
+   }
+
+   // (1 + s)^2 - 1 = s * (2 + s), keeps small values accurate
+   for( int i = 0; i < 9; i++ )
+      sum = sum * ( sum + 2.0 );
+
+   return Ldexp( sum + 1.0, (int)m );
+}
+
+DoubleDouble log(
+   const DoubleDouble &a
+){
+   if( a.hi <= 0.0 )
+      return a.hi == 0.0 ? DoubleDouble( -HUGE_VAL ) : Nan();
+   if( a.hi == HUGE_VAL || a.hi != a.hi )
+      return a;
+
+   // one Newton step for exp(x) = a
+   double x = std::log( a.hi );
+   return DoubleDouble( x ) + a * exp( DoubleDouble( -x ) ) - 1.0;
+}
+
+DoubleDouble log2(
+   const DoubleDouble &a
+){
+   return log( a ) / Ln2;
+}
+
+DoubleDouble log10(
+   const DoubleDouble &a
+){
+   return log( a ) / Ln10;
+}
+
+DoubleDouble pow(
+   const DoubleDouble &a
+ , const DoubleDouble &b
+){
+   // integer exponents by squaring, which also covers negative bases
+   if( b.lo == 0.0 && b.hi == std::rint( b.hi ) && std::abs( b.hi ) < 1e9 )
+      return IntegerPower( a, (long long)b.hi );
+
+   return exp( b * log( a ) );
+}
+
+// sin and cos series for |r| <= pi/4
+static void SinCosReduced(
+   const DoubleDouble &r
+ , DoubleDouble &s
+ , DoubleDouble &c
+){
+   DoubleDouble r2 = r * r;
+
+   DoubleDouble term = r;
+   s = r;
+   for( int i = 1; i < 30 && std::abs( term.hi ) > Epsilon * 1e-3; i++ ){
+      term = -term * r2 / DoubleDouble( ( 2.0*i ) * ( 2.0*i + 1.0 ) );
+      s += term;
+   }
+
+   term = DoubleDouble( 1.0 );
+   c = term;
+   for( int i = 1; i < 30 && std::abs( term.hi ) > Epsilon * 1e-3; i++ ){
+      term = -term * r2 / DoubleDouble( ( 2.0*i - 1.0 ) * ( 2.0*i ) );
+      c += term;
+   }
+}
+
+// reduces a to r + j*pi/2, |r| <= pi/4, and returns sin(r), cos(r), j mod 4
+static int SinCosQuadrant(
+   const DoubleDouble &a
+ , DoubleDouble &s
+ , DoubleDouble &c
+){
+   DoubleDouble r = a - TwoPi * std::rint( a.hi / TwoPi.hi );
+   double j = std::rint( r.hi / PiOver2.hi );
+   r = r - PiOver2 * j;
+   SinCosReduced( r, s, c );
+
+   return ( (int)j + 4 ) % 4;
+}
+
+DoubleDouble sin(
+   const DoubleDouble &a
+){
+   DoubleDouble s, c;
+   switch( SinCosQuadrant( a, s, c ) ){
+   case 0:  return s;
+   case 1:  return c;
+   case 2:  return -s;
+   default: return -c;
+   }
+}
+
+DoubleDouble cos(
+   const DoubleDouble &a
+){
+   DoubleDouble s, c;
+   switch( SinCosQuadrant( a, s, c ) ){
+   case 0:  return c;
+   case 1:  return -s;
+   case 2:  return -c;
+   default: return s;
+   }
+}
+
+DoubleDouble tan(
+   const DoubleDouble &a
+){
+   DoubleDouble s, c;
+   switch( SinCosQuadrant( a, s, c ) ){
+   case 0:
+   case 2:  return s / c;
+   default: return -c / s;
+   }
+}
+
+DoubleDouble atan2(
+   const DoubleDouble &y
+ , const DoubleDouble &x
+){
+   if( x.hi == 0.0 && y.hi == 0.0 )
+      return DoubleDouble();
+
+   // one Newton step from the double angle, on the unit circle
+   DoubleDouble r  = sqrt( x * x + y * y );
+   DoubleDouble xx = x / r;
+   DoubleDouble yy = y / r;
+   DoubleDouble z( std::atan2( y.hi, x.hi ) );
+   DoubleDouble s = sin( z );
+   DoubleDouble c = cos( z );
+
+   return z + ( yy * c - xx * s ) / ( xx * c + yy * s );
+}
+
+DoubleDouble atan(
+   const DoubleDouble &a
+){
+   return atan2( a, DoubleDouble( 1.0 ) );
+}
+
+DoubleDouble asin(
+   const DoubleDouble &a
+){
+   if( std::abs( a.hi ) > 1.0 )
+      return Nan();
+   return atan2( a, sqrt( ( 1.0 - a ) * ( 1.0 + a ) ) );
+}
+
+DoubleDouble acos(
+   const DoubleDouble &a
+){
+   if( std::abs( a.hi ) > 1.0 )
+      return Nan();
+   return atan2( sqrt( ( 1.0 - a ) * ( 1.0 + a ) ), a );
+}
+
+DoubleDouble sinh(
+   const DoubleDouble &a
+){
+   // the series avoids cancellation near zero
+   if( std::abs( a.hi ) < 0.5 ){
+      DoubleDouble a2 = a * a;
+      DoubleDouble term = a;
+      DoubleDouble sum  = a;
+      for( int i = 1; i < 30 && std::abs( term.hi ) > Epsilon * 1e-3; i++ ){
+         term = term * a2 / DoubleDouble( ( 2.0*i ) * ( 2.0*i + 1.0 ) );
+         sum += term;
+      }
+      return sum;
+   }
+
+   DoubleDouble e = exp( a );
+   return Ldexp( e - 1.0 / e, -1 );
+}
+
+DoubleDouble cosh(
+   const DoubleDouble &a
+){
+   DoubleDouble e = exp( a );
+   return Ldexp( e + 1.0 / e, -1 );
+}
+
+DoubleDouble tanh(
+   const DoubleDouble &a
+){
+   if( std::abs( a.hi ) > 40.0 )
+      return DoubleDouble( a.hi > 0.0 ? 1.0 : -1.0 );
+   return sinh( a ) / cosh( a );
+}
+
+DoubleDouble asinh(
+   const DoubleDouble &a
+){
+   // near zero the logarithm of a value close to one cancels, the
+   // series sum (-1)^n (2n)! / (4^n (n!)^2) a^(2n+1) / (2n+1) does not
+   if( std::abs( a.hi ) < 0.25 ){
+      DoubleDouble a2 = a * a;
+      DoubleDouble power = a;
+      DoubleDouble term  = a;
+      DoubleDouble sum   = a;
+      for( int i = 1; i < 40 && std::abs( term.hi ) > Epsilon * 1e-3; i++ ){
+         power = -power * a2 * DoubleDouble( 2.0*i - 1.0 ) / DoubleDouble( 2.0*i );
+         term  = power / DoubleDouble( 2.0*i + 1.0 );
+         sum  += term;
+      }
+      return sum;
+   }
+
+   // odd function; the positive branch has no cancellation
+   DoubleDouble x = abs( a );
+   DoubleDouble y = log( x + sqrt( x * x + 1.0 ) );
+   return a.hi < 0.0 ? -y : y;
+}
+
+DoubleDouble acosh(
+   const DoubleDouble &a
+){
+   if( a.hi < 1.0 )
+      return Nan();
+   return log( a + sqrt( a * a - 1.0 ) );
+}
+
+DoubleDouble atanh(
+   const DoubleDouble &a
+){
+   if( std::abs( a.hi ) > 1.0 )
+      return Nan();
+
+   // the series sum a^(2n+1) / (2n+1) avoids cancellation near zero
+   if( std::abs( a.hi ) < 0.25 ){
+      DoubleDouble a2 = a * a;
+      DoubleDouble power = a;
+      DoubleDouble term  = a;
+      DoubleDouble sum   = a;
+      for( int i = 1; i < 40 && std::abs( term.hi ) > Epsilon * 1e-3; i++ ){
+         power = power * a2;
+         term  = power / DoubleDouble( 2.0*i + 1.0 );
+         sum  += term;
+      }
+      return sum;
+   }
+
+   return Ldexp( log( ( 1.0 + a ) / ( 1.0 - a ) ), -1 );
+}
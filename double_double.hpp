@@ -0,0 +1,126 @@
+#ifndef DOUBLE_DOUBLE_HPP
+#define DOUBLE_DOUBLE_HPP
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <string>
+
+// Unevaluated sum of two doubles, hi + lo with |lo| <= ulp(hi)/2,
+// giving about 106 bits of mantissa with hardware arithmetic.
+// Based on the algorithms of Dekker and of Hida, Li and Bailey (QD).
+struct DoubleDouble
+{
+   double hi;
+   double lo;
+
+   DoubleDouble() : hi( 0.0 ), lo( 0.0 ) {}
+   DoubleDouble( double x ) : hi( x ), lo( 0.0 ) {}
+   DoubleDouble( int x ) : hi( x ), lo( 0.0 ) {}
+   DoubleDouble( double h, double l ) : hi( h ), lo( l ) {} // must be normalised
+
+   explicit operator double() const { return hi; }
+
+   static DoubleDouble FromString( const std::string &text );
+};
+
+namespace dd_detail {
+
+inline double QuickTwoSum( double a, double b, double &err ){
+   double s = a + b;
+   err = b - ( s - a );
+   return s;
+}
+
+inline double TwoSum( double a, double b, double &err ){
+   double s  = a + b;
+   double bb = s - a;
+   err = ( a - ( s - bb ) ) + ( b - bb );
+   return s;
+}
+
+inline double TwoProd( double a, double b, double &err ){
+   double p = a * b;
+   err = std::fma( a, b, -p );
+   return p;
+}
+
+} // namespace dd_detail
+
+inline DoubleDouble operator+( const DoubleDouble &a, const DoubleDouble &b ){
+   double s2, t2;
+   double s1 = dd_detail::TwoSum( a.hi, b.hi, s2 );
+   double t1 = dd_detail::TwoSum( a.lo, b.lo, t2 );
+   s2 += t1;
+   s1 = dd_detail::QuickTwoSum( s1, s2, s2 );
+   s2 += t2;
+   s1 = dd_detail::QuickTwoSum( s1, s2, s2 );
+   return DoubleDouble( s1, s2 );
+}
+
+inline DoubleDouble operator-( const DoubleDouble &a ){
+   return DoubleDouble( -a.hi, -a.lo );
+}
+
+inline DoubleDouble operator-( const DoubleDouble &a, const DoubleDouble &b ){
+   return a + ( -b );
+}
+
+inline DoubleDouble operator*( const DoubleDouble &a, const DoubleDouble &b ){
+   double p2;
+   double p1 = dd_detail::TwoProd( a.hi, b.hi, p2 );
+   p2 += a.hi * b.lo + a.lo * b.hi;
+   p1 = dd_detail::QuickTwoSum( p1, p2, p2 );
+   return DoubleDouble( p1, p2 );
+}
+
+inline DoubleDouble operator/( const DoubleDouble &a, const DoubleDouble &b ){
+   // long division, three partial quotients
+   double q1 = a.hi / b.hi;
+   DoubleDouble r = a - b * q1;
+   double q2 = r.hi / b.hi;
+   r = r - b * q2;
+   double q3 = r.hi / b.hi;
+   q1 = dd_detail::QuickTwoSum( q1, q2, q2 );
+   return DoubleDouble( q1, q2 ) + q3;
+}
+
+inline DoubleDouble &operator+=( DoubleDouble &a, const DoubleDouble &b ){ return a = a + b; }
+inline DoubleDouble &operator-=( DoubleDouble &a, const DoubleDouble &b ){ return a = a - b; }
+inline DoubleDouble &operator*=( DoubleDouble &a, const DoubleDouble &b ){ return a = a * b; }
+inline DoubleDouble &operator/=( DoubleDouble &a, const DoubleDouble &b ){ return a = a / b; }
+
+inline bool operator==( const DoubleDouble &a, const DoubleDouble &b ){ return a.hi == b.hi && a.lo == b.lo; }
+inline bool operator!=( const DoubleDouble &a, const DoubleDouble &b ){ return !( a == b ); }
+inline bool operator< ( const DoubleDouble &a, const DoubleDouble &b ){ return a.hi < b.hi || ( a.hi == b.hi && a.lo < b.lo ); }
+inline bool operator> ( const DoubleDouble &a, const DoubleDouble &b ){ return b < a; }
+inline bool operator<=( const DoubleDouble &a, const DoubleDouble &b ){ return !( b < a ); }
+inline bool operator>=( const DoubleDouble &a, const DoubleDouble &b ){ return !( a < b ); }
+
+// math functions, found by argument-dependent lookup next to the std ones
+DoubleDouble abs( const DoubleDouble &a );
+DoubleDouble fabs( const DoubleDouble &a );
+DoubleDouble floor( const DoubleDouble &a );
+DoubleDouble rint( const DoubleDouble &a );
+DoubleDouble sqrt( const DoubleDouble &a );
+DoubleDouble exp( const DoubleDouble &a );
+DoubleDouble log( const DoubleDouble &a );
+DoubleDouble log2( const DoubleDouble &a );
+DoubleDouble log10( const DoubleDouble &a );
+DoubleDouble pow( const DoubleDouble &a, const DoubleDouble &b );
+DoubleDouble sin( const DoubleDouble &a );
+DoubleDouble cos( const DoubleDouble &a );
+DoubleDouble tan( const DoubleDouble &a );
+DoubleDouble asin( const DoubleDouble &a );
+DoubleDouble acos( const DoubleDouble &a );
+DoubleDouble atan( const DoubleDouble &a );
+DoubleDouble atan2( const DoubleDouble &y, const DoubleDouble &x );
+DoubleDouble sinh( const DoubleDouble &a );
+DoubleDouble cosh( const DoubleDouble &a );
+DoubleDouble tanh( const DoubleDouble &a );
+DoubleDouble asinh( const DoubleDouble &a );
+DoubleDouble acosh( const DoubleDouble &a );
+DoubleDouble atanh( const DoubleDouble &a );
+
+#endif // DOUBLE_DOUBLE_HPP
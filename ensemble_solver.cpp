@@ -0,0 +1,159 @@
+#include "ensemble_solver.hpp"
+
+EnsembleSolver::EnsembleSolver(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , DerivationVector diffusion_rules
+ , PointValues val_init
+ , double timeStep
+ , Method scheme
+ , quint64 seed
+ , int pathCount
+ , QString transformationX
+ , QString transformationY
+ , QStringList paramNames
+ , QVector<double> quantileLevels
+){
+   paths  = std::max( 1, pathCount );
+   blocks = ( paths + BlockPaths - 1 ) / BlockPaths;
+   outputSteps = 1;
+   steps  = 0;
+   tInit  = val_init.T;
+   h      = timeStep;
+   aborted = false;
+
+   levels = quantileLevels;
+   for( auto &level : levels )
+      level = std::max( 0.0, std::min( 1.0, level ) );
+   std::sort( levels.begin(), levels.end() );
+
+   stepper.resize( blocks );
+   transform.resize( blocks );
+   for( int b = 0; b < blocks; b++ ){
+      stepper[b] = new SdeStepper( scheme, diffusion_rules, seed );
+      stepper[b]->SetConditions( ddt_rules, param_rules, val_init, h );
+      transform[b] = new CoordinateTransform( transformationX, transformationY, paramNames );
+   }
+
+   state.fill( stepper[0]->InitialValues(), paths );
+   plotX.fill( 0.0, paths );
+   plotY.fill( 0.0, paths );
+}
+
+EnsembleSolver::~EnsembleSolver(
+){
+   for( auto s : stepper ){
+      delete s;
+   }
+   for( auto tr : transform ){
+      delete tr;
+   }
+}
+
+void EnsembleSolver::SetOutput(
+   int skipSteps
+ , double outputSpacing
+){
+   if( outputSpacing > 0 )
+      outputSteps = std::max( 1LL, std::llround( outputSpacing / h ) );
+   else
+      outputSteps = skipSteps + 1;
+}
+
+PointValues EnsembleSolver::Advance(
+   EnsembleBand &band
+){
+   long long targetStep = steps + outputSteps;
+
+   QVector<int> pending;
+   for( int b = 0; b < blocks; b++ )
+      pending.push_back( b );
+   QtConcurrent::blockingMap( pending, [this, targetStep]( int &b ){ AdvanceBlock( b, targetStep ); } );
+   steps = targetStep;
+
+   // mean point, summed in path order
+   PointValues mean;
+   mean.T = tInit + steps * h;
+   mean.Val.fill( 0.0, state[0].Val.size() );
+   mean.Param.fill( 0.0, state[0].Param.size() );
+   for( const PointValues &pv : state ){
+      for( int i = 0; i < mean.Val.size(); i++ )
+         mean.Val[i] += pv.Val[i];
+      for( int i = 0; i < mean.Param.size(); i++ )
+         mean.Param[i] += pv.Param[i];
+   }
+   for( auto &value : mean.Val )
+      value /= paths;
+   for( auto &value : mean.Param )
+      value /= paths;
+
+   // band in plot coordinates; two passes for the variance
+   double sumX = 0.0, sumY = 0.0;
+   for( int p = 0; p < paths; p++ ){
+      sumX += plotX[p];
+      sumY += plotY[p];
+   }
+   double meanX = sumX / paths;
+   double meanY = sumY / paths;
+   double varX = 0.0, varY = 0.0;
+   for( int p = 0; p < paths; p++ ){
+      varX += ( plotX[p] - meanX ) * ( plotX[p] - meanX );
+      varY += ( plotY[p] - meanY ) * ( plotY[p] - meanY );
+   }
+   if( paths > 1 ){
+      varX /= paths - 1;
+      varY /= paths - 1;
+   }
+
+   band.T = mean.T;
+   band.Mean = QPointF( meanX, meanY );
+   band.Deviation = QPointF( std::sqrt( varX ), std::sqrt( varY ) );
+
+   // nearest rank quantiles; levels are sorted, so each selection only
+   // searches above the previous one
+   QVector<double> sorted( plotY );
+   band.Quantiles.resize( levels.size() );
+   int lowest = 0;
+   for( int q = 0; q < levels.size(); q++ ){
+      int rank = std::min( paths - 1, (int)std::floor( levels[q] * paths ) );
+      rank = std::max( rank, lowest );
+      std::nth_element( sorted.begin() + lowest, sorted.begin() + rank, sorted.end() );
+      band.Quantiles[q] = sorted[rank];
+      lowest = rank;
+   }
+
+   return mean;
+}
+
+void EnsembleSolver::Abort(
+){
+   aborted = true;
+}
+
+int EnsembleSolver::PathCount(
+){
+   return paths;
+}
+
+QVector<double> EnsembleSolver::QuantileLevels(
+){
+   return levels;
+}
+
+void EnsembleSolver::AdvanceBlock(
+   int block
+ , long long targetStep
+){
+   int first = block * BlockPaths;
+   int last  = std::min( paths, first + BlockPaths );
+
+   for( int p = first; p < last; p++ ){
+      PointValues &pv = state[p];
+      for( long long n = steps; n < targetStep && !aborted; n++ )
+         pv = stepper[block]->Step( pv, (quint32)p, n );
+
+      QPointF mapped = transform[block]->Map( pv );
+      plotX[p] = mapped.x();
+      plotY[p] = mapped.y();
+   }
+}
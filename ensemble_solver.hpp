@@ -0,0 +1,90 @@
+#ifndef ENSEMBLE_SOLVER_HPP
+#define ENSEMBLE_SOLVER_HPP
+
+// Qt headers
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QMetaType>
+#include <QtConcurrent>
+
+// C++ headers
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "sde_stepper.hpp"
+#include "coordinate_transform.hpp"
+
+// Spread of the ensemble at one output time, in plot coordinates.
+// Quantiles are of y, at the levels of the solver, lowest first.
+typedef struct {
+   double T;
+   QPointF Mean;
+   QPointF Deviation;
+   QVector<double> Quantiles;
+} EnsembleBand;
+Q_DECLARE_METATYPE( EnsembleBand )
+
+// Monte Carlo ensemble of a stochastic problem. All paths start from the
+// same initial values and are advanced in blocks on the thread pool.
+// Every path has its own noise (see SdeStepper) and its own slot for the
+// results, and the statistics are summed in path order, so the output
+// doesn't depend on the number of threads. Only the current state of the
+// paths is kept; each output reduces them to the mean point and a band.
+class EnsembleSolver
+{
+public:
+   EnsembleSolver( DerivationVector ddt_rules
+                 , EquationVector param_rules
+                 , DerivationVector diffusion_rules
+                 , PointValues val_init
+                 , double timeStep
+                 , Method scheme
+                 , quint64 seed
+                 , int pathCount
+                 , QString transformationX
+                 , QString transformationY
+                 , QStringList paramNames
+                 , QVector<double> quantileLevels );
+   ~EnsembleSolver();
+
+   // outputs fall on whole steps, every skipSteps+1 steps or the number
+   // of steps closest to outputSpacing
+   void SetOutput( int skipSteps, double outputSpacing );
+   PointValues Advance( EnsembleBand &band );
+   void Abort();
+
+   int PathCount();
+   QVector<double> QuantileLevels();
+
+private:
+   // paths per work item
+   static const int BlockPaths = 64;
+
+   int paths;
+   int blocks;
+   int outputSteps;
+   long long steps;
+   double tInit;
+   double h;
+   QVector<double> levels;
+   std::atomic<bool> aborted;
+
+   // one stepper and transformation per block, as parsers aren't
+   // thread safe
+   QVector<SdeStepper *> stepper;
+   QVector<CoordinateTransform *> transform;
+
+   QVector<PointValues> state;
+   QVector<double> plotX;
+   QVector<double> plotY;
+
+   void AdvanceBlock( int block
+                    , long long targetStep );
+};
+
+#endif // ENSEMBLE_SOLVER_HPP
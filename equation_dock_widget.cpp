@@ -0,0 +1,81 @@
+#include "equation_dock_widget.hpp"
+
+EquationDockWidget::EquationDockWidget(
+   DerivationVector varRules
+ , EquationVector paramRules
+ , QWidget *parent
+) : QWidget(parent){
+   this->varRules   = varRules;
+   this->paramRules = paramRules;
+
+   // create layout
+   QVBoxLayout *mainLayout = new QVBoxLayout( this );
+   QFormLayout *varLayout   = new QFormLayout;
+   QFormLayout *paramLayout = new QFormLayout;
+
+   for( auto rule : varRules ){
+      QLineEdit *edit = new QLineEdit( rule.second );
+      connect( edit, &QLineEdit::editingFinished, this, &EquationDockWidget::collectEdits );
+      varLayout->addRow( "d" + rule.first + "/dt =", edit );
+      varEdits.push_back( edit );
+   }
+   for( auto rule : paramRules ){
+      QLineEdit *edit = new QLineEdit( rule.second );
+      connect( edit, &QLineEdit::editingFinished, this, &EquationDockWidget::collectEdits );
+      paramLayout->addRow( rule.first + " =", edit );
+      paramEdits.push_back( edit );
+   }
+
+   // add items
+   mainLayout->addWidget( new QLabel( tr("<b>Variable derivations</b>") ) );
+   mainLayout->addLayout( varLayout );
+   mainLayout->addWidget( new QLabel( tr("<b>Parameter equations</b>") ) );
+   mainLayout->addLayout( paramLayout );
+   mainLayout->addStretch( 1 );
+
+   // finalize
+   setLayout( mainLayout );
+}
+
+EquationDockWidget::~EquationDockWidget(
+){
+   // stub
+}
+
+void EquationDockWidget::setEquations(
+   DerivationVector varRules
+ , EquationVector paramRules
+){
+   if( varRules.size() != varEdits.size() || paramRules.size() != paramEdits.size() )
+      return;
+
+   this->varRules   = varRules;
+   this->paramRules = paramRules;
+
+   for( int i = 0; i < varEdits.size(); i++ ){
+      varEdits[i]->blockSignals( true );
+      varEdits[i]->setText( varRules[i].second );
+      varEdits[i]->blockSignals( false );
+   }
+   for( int i = 0; i < paramEdits.size(); i++ ){
+      paramEdits[i]->blockSignals( true );
+      paramEdits[i]->setText( paramRules[i].second );
+      paramEdits[i]->blockSignals( false );
+   }
+}
+
+void EquationDockWidget::collectEdits(
+){
+   DerivationVector editedVars( varRules );
+   EquationVector   editedParams( paramRules );
+   for( int i = 0; i < varEdits.size(); i++ )
+      editedVars[i].second = varEdits[i]->text().trimmed();
+   for( int i = 0; i < paramEdits.size(); i++ )
+      editedParams[i].second = paramEdits[i]->text().trimmed();
+
+   // editingFinished also fires on focus loss without changes
+   if( editedVars == varRules && editedParams == paramRules )
+      return;
+
+   emit equationsEdited( editedVars, editedParams );
+}
@@ -0,0 +1,44 @@
+#ifndef EQUATION_DOCK_WIDGET_HPP
+#define EQUATION_DOCK_WIDGET_HPP
+
+// Qt headers
+#include <QtDebug>
+#include <QWidget>
+#include <QLayout>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLineEdit>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+
+// Editable list of derivations and parameter equations of the running
+// problem. Finished edits are passed on as a whole set of equations.
+class EquationDockWidget : public QWidget
+{
+   Q_OBJECT
+public:
+   explicit EquationDockWidget( DerivationVector varRules
+                              , EquationVector paramRules
+                              , QWidget *parent = 0 );
+   ~EquationDockWidget();
+
+   void setEquations( DerivationVector varRules
+                    , EquationVector paramRules );
+
+signals:
+   void equationsEdited( DerivationVector varRules
+                       , EquationVector paramRules );
+
+private:
+   DerivationVector varRules;
+   EquationVector   paramRules;
+
+   // Elements, in rule order
+   QVector<QLineEdit *> varEdits;
+   QVector<QLineEdit *> paramEdits;
+
+   void collectEdits();
+};
+
+#endif // EQUATION_DOCK_WIDGET_HPP
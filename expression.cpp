@@ -0,0 +1,898 @@
+#include "expression.hpp"
+
+// C headers
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// C++ headers
+#include <algorithm>
+
+// Local headers
+#include "double_double.hpp"
+
+ExpressionError::ExpressionError(
+   const std::string &message
+ , const std::string &expression
+ , const std::string &token
+ , int position
+){
+   this->message    = message;
+   this->expression = expression;
+   this->token      = token;
+   this->position   = position;
+}
+
+const std::string &ExpressionError::GetMsg(
+) const {
+   return message;
+}
+
+const std::string &ExpressionError::GetExpr(
+) const {
+   return expression;
+}
+
+const std::string &ExpressionError::GetToken(
+) const {
+   return token;
+}
+
+int ExpressionError::GetPos(
+) const {
+   return position;
+}
+
+template <typename Scalar>
+const int Expression<Scalar>::MaxSeriesOrder;
+template <typename Scalar>
+const int Expression<Scalar>::SeriesLength;
+
+template <typename Scalar>
+void ExpressionSymbols<Scalar>::Clear(
+){
+   table.clear();
+}
+
+template <typename Scalar>
+void ExpressionSymbols<Scalar>::Define(
+   const std::string &name
+ , Scalar *value
+){
+   table[name] = value;
+}
+
+template <typename Scalar>
+Scalar *ExpressionSymbols<Scalar>::Find(
+   const std::string &name
+) const {
+   auto it = table.find( name );
+   return it == table.end() ? nullptr : it->second;
+}
+
+// literals are read at the full precision of the scalar
+template <typename Scalar>
+static Scalar NumberValue(
+   const std::string &text
+){
+   return Scalar( std::strtold( text.c_str(), nullptr ) );
+}
+
+template <>
+DoubleDouble NumberValue<DoubleDouble>(
+   const std::string &text
+){
+   return DoubleDouble::FromString( text );
+}
+
+template <typename Scalar>
+Expression<Scalar>::Expression(
+){
+   position    = 0;
+   foldBarrier = 0;
+   depth       = 0;
+   maxDepth    = 0;
+}
+
+template <typename Scalar>
+void Expression<Scalar>::SetSymbols(
+   const ExpressionSymbols<Scalar> *symbols
+){
+   this->symbols = symbols;
+}
+
+template <typename Scalar>
+void Expression<Scalar>::SetExpr(
+   const std::string &expression
+){
+   source = expression;
+   code.clear();
+   position    = 0;
+   foldBarrier = 0;
+   depth       = 0;
+   maxDepth    = 0;
+
+   ParseTernary();
+   SkipSpace();
+   if( position < source.size() )
+      Fail( "Unexpected token.", source.substr( position, 1 ) );
+
+   stack.resize( std::max( maxDepth, 1 ) );
+}
+
+template <typename Scalar>
+const std::string &Expression<Scalar>::GetExpr(
+) const {
+   return source;
+}
+
+template <typename Scalar>
+bool Expression<Scalar>::IsConstant(
+) const {
+   return code.size() == 1 && code[0].op == Op::Const;
+}
+
+template <typename Scalar>
+Scalar Expression<Scalar>::Eval(
+) const {
+   Scalar *s = stack.data();
+   int sp = -1;
+
+   const size_t size = code.size();
+   for( size_t pc = 0; pc < size; pc++ ){
+      const Instruction &in = code[pc];
+      switch( in.op ){
+      case Op::Const:
+         s[++sp] = in.value;
+         break;
+      case Op::Var:
+         s[++sp] = *in.var;
+         break;
+      case Op::Neg:
+         s[sp] = -s[sp];
+         break;
+      case Op::Add:
+         sp--;
+         s[sp] = s[sp] + s[sp+1];
+         break;
+      case Op::Sub:
+         sp--;
+         s[sp] = s[sp] - s[sp+1];
+         break;
+      case Op::Mul:
+         sp--;
+         s[sp] = s[sp] * s[sp+1];
+         break;
+      case Op::Div:
+         sp--;
+         s[sp] = s[sp] / s[sp+1];
+         break;
+      case Op::Jump:
+         pc = in.count - 1;
+         break;
+      case Op::JumpIfFalse:
+         if( s[sp--] == Scalar( 0 ) )
+            pc = in.count - 1;
+         break;
+      default:
+         sp -= in.count - 1;
+         s[sp] = Apply( in.op, s + sp, in.count );
+         break;
+      }
+   }
+
+   return s[0];
+}
+
+template <typename Scalar>
+Scalar Expression<Scalar>::Apply(
+   Op op
+ , const Scalar *args
+ , int count
+){
+   using std::abs;   using std::rint;  using std::sqrt;  using std::pow;
+   using std::exp;   using std::log;   using std::log2;  using std::log10;
+   using std::sin;   using std::cos;   using std::tan;
+   using std::asin;  using std::acos;  using std::atan;
+   using std::sinh;  using std::cosh;  using std::tanh;
+   using std::asinh; using std::acosh; using std::atanh;
+
+   const Scalar zero( 0 );
+   const Scalar one( 1 );
+   const Scalar &a = args[0];
+
+   switch( op ){
+   case Op::Neg:          return -a;
+   case Op::Add:          return a + args[1];
+   case Op::Sub:          return a - args[1];
+   case Op::Mul:          return a * args[1];
+   case Op::Div:          return a / args[1];
+   case Op::Pow:          return pow( a, args[1] );
+   case Op::Less:         return a <  args[1] ? one : zero;
+   case Op::Greater:      return a >  args[1] ? one : zero;
+   case Op::LessEqual:    return a <= args[1] ? one : zero;
+   case Op::GreaterEqual: return a >= args[1] ? one : zero;
+   case Op::Equal:        return a == args[1] ? one : zero;
+   case Op::NotEqual:     return a != args[1] ? one : zero;
+   case Op::And:          return ( a != zero && args[1] != zero ) ? one : zero;
+   case Op::Or:           return ( a != zero || args[1] != zero ) ? one : zero;
+   case Op::Sin:          return sin( a );
+   case Op::Cos:          return cos( a );
+   case Op::Tan:          return tan( a );
+   case Op::Asin:         return asin( a );
+   case Op::Acos:         return acos( a );
+   case Op::Atan:         return atan( a );
+   case Op::Sinh:         return sinh( a );
+   case Op::Cosh:         return cosh( a );
+   case Op::Tanh:         return tanh( a );
+   case Op::Asinh:        return asinh( a );
+   case Op::Acosh:        return acosh( a );
+   case Op::Atanh:        return atanh( a );
+   case Op::Log2:         return log2( a );
+   case Op::Log10:        return log10( a );
+   case Op::Ln:           return log( a );
+   case Op::Exp:          return exp( a );
+   case Op::Sqrt:         return sqrt( a );
+   case Op::Sign:         return a > zero ? one : ( a < zero ? -one : zero );
+   case Op::Rint:         return rint( a );
+   case Op::Abs:          return abs( a );
+   case Op::Min:
+   case Op::Max:
+   case Op::Sum:
+   case Op::Avg: {
+      Scalar result = a;
+      for( int i = 1; i < count; i++ ){
+         if( op == Op::Min )
+            result = args[i] < result ? args[i] : result;
+         else if( op == Op::Max )
+            result = args[i] > result ? args[i] : result;
+         else
+            result = result + args[i];
+      }
+      return op == Op::Avg ? result / Scalar( count ) : result;
+   }
+   default:
+      return zero;
+   }
+}
+
+// Taylor coefficient recurrences, for order k > 0. a and b are the
+// arguments, y the result and u, v auxiliary series.
+
+// (a*b)_k
+template <typename Scalar>
+static Scalar Convolution(
+   const Scalar *a
+ , const Scalar *b
+ , int k
+){
+   Scalar sum( 0 );
+   for( int j = 0; j <= k; j++ )
+      sum += a[j] * b[k-j];
+   return sum;
+}
+
+// y' = a' * u
+template <typename Scalar>
+static Scalar ProductCoefficient(
+   const Scalar *a
+ , const Scalar *u
+ , int k
+){
+   Scalar sum( 0 );
+   for( int j = 1; j <= k; j++ )
+      sum += Scalar( (double)j ) * a[j] * u[k-j];
+   return sum / Scalar( (double)k );
+}
+
+// y' = sign * a' / v
+template <typename Scalar>
+static Scalar QuotientCoefficient(
+   const Scalar *a
+ , const Scalar *y
+ , const Scalar *v
+ , int k
+ , const Scalar &sign
+){
+   Scalar sum( 0 );
+   for( int j = 1; j < k; j++ )
+      sum += Scalar( (double)j ) * y[j] * v[k-j];
+   return ( sign * a[k] - sum / Scalar( (double)k ) ) / v[0];
+}
+
+// y = sqrt(a)
+template <typename Scalar>
+static Scalar SqrtCoefficient(
+   const Scalar *a
+ , const Scalar *y
+ , int k
+){
+   Scalar sum( 0 );
+   for( int j = 1; j < k; j++ )
+      sum += y[j] * y[k-j];
+   return ( a[k] - sum ) / ( Scalar( 2 ) * y[0] );
+}
+
+template <typename Scalar>
+Scalar Expression<Scalar>::EvalCoefficient(
+   int order
+) const {
+   if( order == 0 ){
+      series.resize( code.size() * 3 * SeriesLength );
+      producers.resize( stack.size() );
+   }
+
+   // same walk as Eval(), with instructions in place of values
+   int *s = producers.data();
+   int sp = -1;
+
+   const size_t size = code.size();
+   for( size_t pc = 0; pc < size; pc++ ){
+      const Instruction &in = code[pc];
+      switch( in.op ){
+      case Op::Const:
+         Coefficients( pc, 0 )[order] = order == 0 ? in.value : Scalar( 0 );
+         s[++sp] = pc;
+         break;
+      case Op::Var:
+         Coefficients( pc, 0 )[order] = in.var[order];
+         s[++sp] = pc;
+         break;
+      case Op::Jump:
+         pc = in.count - 1;
+         break;
+      case Op::JumpIfFalse:
+         if( Coefficients( s[sp--], 0 )[0] == Scalar( 0 ) )
+            pc = in.count - 1;
+         break;
+      default:
+         sp -= in.count - 1;
+         SeriesStep( pc, s + sp, order );
+         s[sp] = pc;
+         break;
+      }
+   }
+
+   return Coefficients( s[0], 0 )[order];
+}
+
+template <typename Scalar>
+Scalar *Expression<Scalar>::Coefficients(
+   size_t pc
+ , int slot
+) const {
+   return series.data() + ( pc*3 + slot ) * SeriesLength;
+}
+
+template <typename Scalar>
+void Expression<Scalar>::SeriesStep(
+   size_t pc
+ , const int *args
+ , int k
+) const {
+   using std::sqrt;  using std::log;  using std::rint;
+   using std::sin;   using std::cos;  using std::sinh;  using std::cosh;
+
+   const Instruction &in = code[pc];
+   Scalar *y = Coefficients( pc, 0 );
+   Scalar *u = Coefficients( pc, 1 );
+   Scalar *v = Coefficients( pc, 2 );
+   const Scalar *a = Coefficients( args[0], 0 );
+   const Scalar *b = in.count > 1 ? Coefficients( args[1], 0 ) : nullptr;
+   const Scalar zero( 0 );
+   const Scalar one( 1 );
+
+   // order zero is the value, plus the starting points of the
+   // auxiliary series
+   if( k == 0 ){
+      Scalar *values = stack.data();
+      for( int i = 0; i < in.count; i++ )
+         values[i] = Coefficients( args[i], 0 )[0];
+      y[0] = Apply( in.op, values, in.count );
+
+      switch( in.op ){
+      case Op::Sin:   u[0] = cos( a[0] );  break;
+      case Op::Cos:   u[0] = sin( a[0] );  break;
+      case Op::Sinh:  u[0] = cosh( a[0] ); break;
+      case Op::Cosh:  u[0] = sinh( a[0] ); break;
+      case Op::Tan:   u[0] = one + y[0]*y[0]; break;
+      case Op::Tanh:  u[0] = one - y[0]*y[0]; break;
+      case Op::Atan:  u[0] = one + a[0]*a[0]; break;
+      case Op::Atanh: u[0] = one - a[0]*a[0]; break;
+      case Op::Asin:
+      case Op::Acos:  u[0] = one - a[0]*a[0]; v[0] = sqrt( u[0] ); break;
+      case Op::Asinh: u[0] = a[0]*a[0] + one; v[0] = sqrt( u[0] ); break;
+      case Op::Acosh: u[0] = a[0]*a[0] - one; v[0] = sqrt( u[0] ); break;
+      case Op::Ln:    u[0] = a[0]; break;
+      case Op::Log2:  u[0] = log( Scalar( 2 ) ) * a[0]; break;
+      case Op::Log10: u[0] = log( Scalar( 10 ) ) * a[0]; break;
+      case Op::Pow:
+         // a^b = exp(b*ln(a)), unless b is a constant
+         if( code[args[1]].op != Op::Const ){
+            u[0] = log( a[0] );
+            v[0] = b[0] * u[0];
+         } else {
+            u[0] = a[0] * a[0];
+         }
+         break;
+      default:
+         break;
+      }
+      return;
+   }
+
+   switch( in.op ){
+   case Op::Neg:
+      y[k] = -a[k];
+      break;
+   case Op::Add:
+      y[k] = a[k] + b[k];
+      break;
+   case Op::Sub:
+      y[k] = a[k] - b[k];
+      break;
+   case Op::Mul:
+      y[k] = Convolution( a, b, k );
+      break;
+   case Op::Div: {
+      Scalar sum( 0 );
+      for( int j = 1; j <= k; j++ )
+         sum += b[j] * y[k-j];
+      y[k] = ( a[k] - sum ) / b[0];
+      break;
+   }
+   case Op::Pow: {
+      if( code[args[1]].op != Op::Const ){
+         u[k] = QuotientCoefficient( a, u, a, k, one );
+         v[k] = Convolution( b, u, k );
+         y[k] = ProductCoefficient( v, y, k );
+         break;
+      }
+      const Scalar &r = b[0];
+      if( r == Scalar( 2 ) ){
+         // small whole powers as products, which stay accurate when
+         // the base passes through zero
+         y[k] = Convolution( a, a, k );
+      } else if( r == Scalar( 3 ) || r == Scalar( 4 ) ){
+         u[k] = Convolution( a, a, k );
+         y[k] = r == Scalar( 3 ) ? Convolution( u, a, k ) : Convolution( u, u, k );
+      } else if( r == one || r == zero ){
+         y[k] = r == one ? a[k] : zero;
+      } else if( a[0] != zero ){
+         // y' a = r a' y
+         Scalar sum( 0 );
+         for( int j = 0; j < k; j++ )
+            sum += ( r * Scalar( (double)( k - j ) ) - Scalar( (double)j ) ) * a[k-j] * y[j];
+         y[k] = sum / ( Scalar( (double)k ) * a[0] );
+      } else if( r >= zero && rint( r ) == r ){
+         // zero base, whole power: repeated products, the lowest
+         // term is at order r or above
+         int n = r > Scalar( (double)MaxSeriesOrder ) ? SeriesLength : (int)static_cast<double>( r );
+         if( k < n ){
+            y[k] = zero;
+            break;
+         }
+         for( int j = 0; j <= k; j++ )
+            u[j] = j == 0 ? one : zero;
+         for( int i = 0; i < n; i++ ){
+            for( int j = 0; j <= k; j++ )
+               v[j] = Convolution( u, a, j );
+            for( int j = 0; j <= k; j++ )
+               u[j] = v[j];
+         }
+         y[k] = u[k];
+      } else {
+         y[k] = zero / zero;
+      }
+      break;
+   }
+   case Op::Exp:
+      y[k] = ProductCoefficient( a, y, k );
+      break;
+   case Op::Ln:
+   case Op::Log2:
+   case Op::Log10:
+      u[k] = u[0] / a[0] * a[k];
+      y[k] = QuotientCoefficient( a, y, u, k, one );
+      break;
+   case Op::Sqrt:
+      y[k] = SqrtCoefficient( a, y, k );
+      break;
+   case Op::Sin:
+   case Op::Sinh:
+      y[k] = ProductCoefficient( a, u, k );
+      u[k] = in.op == Op::Sin ? -ProductCoefficient( a, y, k ) : ProductCoefficient( a, y, k );
+      break;
+   case Op::Cos:
+   case Op::Cosh:
+      y[k] = in.op == Op::Cos ? -ProductCoefficient( a, u, k ) : ProductCoefficient( a, u, k );
+      u[k] = ProductCoefficient( a, y, k );
+      break;
+   case Op::Tan:
+      y[k] = ProductCoefficient( a, u, k );
+      u[k] = Convolution( y, y, k );
+      break;
+   case Op::Tanh:
+      y[k] = ProductCoefficient( a, u, k );
+      u[k] = -Convolution( y, y, k );
+      break;
+   case Op::Atan:
+      u[k] = Convolution( a, a, k );
+      y[k] = QuotientCoefficient( a, y, u, k, one );
+      break;
+   case Op::Atanh:
+      u[k] = -Convolution( a, a, k );
+      y[k] = QuotientCoefficient( a, y, u, k, one );
+      break;
+   case Op::Asin:
+   case Op::Acos:
+      u[k] = -Convolution( a, a, k );
+      v[k] = SqrtCoefficient( u, v, k );
+      y[k] = QuotientCoefficient( a, y, v, k, in.op == Op::Asin ? one : -one );
+      break;
+   case Op::Asinh:
+   case Op::Acosh:
+      u[k] = Convolution( a, a, k );
+      v[k] = SqrtCoefficient( u, v, k );
+      y[k] = QuotientCoefficient( a, y, v, k, one );
+      break;
+   case Op::Abs:
+      y[k] = a[0] < zero ? -a[k] : a[k];
+      break;
+   case Op::Min:
+   case Op::Max: {
+      int pick = 0;
+      for( int i = 1; i < in.count; i++ ){
+         const Scalar &candidate = Coefficients( args[i], 0 )[0];
+         const Scalar &best      = Coefficients( args[pick], 0 )[0];
+         if( in.op == Op::Min ? candidate < best : candidate > best )
+            pick = i;
+      }
+      y[k] = Coefficients( args[pick], 0 )[k];
+      break;
+   }
+   case Op::Sum:
+   case Op::Avg: {
+      Scalar sum( 0 );
+      for( int i = 0; i < in.count; i++ )
+         sum += Coefficients( args[i], 0 )[k];
+      y[k] = in.op == Op::Avg ? sum / Scalar( in.count ) : sum;
+      break;
+   }
+   default:
+      // comparisons, logic, sign and rint are piecewise constant
+      y[k] = zero;
+      break;
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseTernary(
+){
+   ParseOr();
+   if( !Accept( "?" ) )
+      return;
+
+   // cond ? a : b  ->  cond, JumpIfFalse else, a, Jump end, else: b, end:
+   EmitOperation( Op::JumpIfFalse, 1 );
+   size_t jumpElse = code.size() - 1;
+   depth--;
+
+   ParseTernary();
+   Expect( ":" );
+   EmitOperation( Op::Jump, 0 );
+   size_t jumpEnd = code.size() - 1;
+   code[jumpElse].count = code.size();
+   depth--;
+
+   ParseTernary();
+   code[jumpEnd].count = code.size();
+   foldBarrier = code.size();
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseOr(
+){
+   ParseAnd();
+   while( Accept( "||" ) ){
+      ParseAnd();
+      EmitOperation( Op::Or, 2 );
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseAnd(
+){
+   ParseComparison();
+   while( Accept( "&&" ) ){
+      ParseComparison();
+      EmitOperation( Op::And, 2 );
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseComparison(
+){
+   ParseAdditive();
+   while( true ){
+      Op op;
+      if( Accept( "<=" ) )      op = Op::LessEqual;
+      else if( Accept( ">=" ) ) op = Op::GreaterEqual;
+      else if( Accept( "==" ) ) op = Op::Equal;
+      else if( Accept( "!=" ) ) op = Op::NotEqual;
+      else if( Accept( "<" ) )  op = Op::Less;
+      else if( Accept( ">" ) )  op = Op::Greater;
+      else return;
+
+      ParseAdditive();
+      EmitOperation( op, 2 );
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseAdditive(
+){
+   ParseMultiplicative();
+   while( true ){
+      Op op;
+      if( Accept( "+" ) )      op = Op::Add;
+      else if( Accept( "-" ) ) op = Op::Sub;
+      else return;
+
+      ParseMultiplicative();
+      EmitOperation( op, 2 );
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseMultiplicative(
+){
+   ParseUnary();
+   while( true ){
+      Op op;
+      if( Accept( "*" ) )      op = Op::Mul;
+      else if( Accept( "/" ) ) op = Op::Div;
+      else return;
+
+      ParseUnary();
+      EmitOperation( op, 2 );
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParseUnary(
+){
+   // as in muParser, -a^b = -(a^b)
+   if( Accept( "-" ) ){
+      ParseUnary();
+      EmitOperation( Op::Neg, 1 );
+   } else if( Accept( "+" ) ){
+      ParseUnary();
+   } else {
+      ParsePower();
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParsePower(
+){
+   // right associative, a^b^c = a^(b^c)
+   ParsePrimary();
+   if( Accept( "^" ) ){
+      ParseUnary();
+      EmitOperation( Op::Pow, 2 );
+   }
+}
+
+template <typename Scalar>
+void Expression<Scalar>::ParsePrimary(
+){
+   SkipSpace();
+   if( position >= source.size() )
+      Fail( "Unexpected end of expression.", "" );
+
+   size_t start = position;
+   char c = source[position];
+
+   // parenthesis
+   if( c == '(' ){
+      position++;
+      ParseTernary();
+      Expect( ")" );
+      return;
+   }
+
+   // number
+   if( std::isdigit( (unsigned char)c ) || c == '.' ){
+      while( position < source.size() && ( std::isdigit( (unsigned char)source[position] ) || source[position] == '.' ) )
+         position++;
+      if( position < source.size() && ( source[position] == 'e' || source[position] == 'E' ) ){
+         size_t mark = position++;
+         if( position < source.size() && ( source[position] == '+' || source[position] == '-' ) )
+            position++;
+         if( position < source.size() && std::isdigit( (unsigned char)source[position] ) ){
+            while( position < source.size() && std::isdigit( (unsigned char)source[position] ) )
+               position++;
+         } else {
+            position = mark;
+         }
+      }
+      std::string text = source.substr( start, position - start );
+      if( std::count( text.begin(), text.end(), '.' ) > 1 || text == "." )
+         Fail( "Invalid number.", text );
+      EmitValue( Op::Const, NumberValue<Scalar>( text ), nullptr );
+      return;
+   }
+
+   // name of a symbol, constant or function
+   if( !std::isalpha( (unsigned char)c ) && c != '_' )
+      Fail( "Unexpected token.", std::string( 1, c ) );
+   while( position < source.size() && ( std::isalnum( (unsigned char)source[position] ) || source[position] == '_' ) )
+      position++;
+   std::string name = source.substr( start, position - start );
+
+   if( !Accept( "(" ) ){
+      using std::acos;
+      using std::exp;
+      if( name == "_pi" ){
+         EmitValue( Op::Const, acos( Scalar( -1 ) ), nullptr );
+      } else if( name == "_e" ){
+         EmitValue( Op::Const, exp( Scalar( 1 ) ), nullptr );
+      } else {
+         const Scalar *var = symbols != nullptr ? symbols->Find( name ) : nullptr;
+         if( var == nullptr ){
+            position = start;
+            Fail( "Undefined symbol.", name );
+         }
+         EmitValue( Op::Var, Scalar( 0 ), var );
+      }
+      return;
+   }
+
+   static const struct {
+      const char *name;
+      Op op;
+      bool variadic;
+   } functions[] = {
+      { "sin",   Op::Sin,   false }, { "cos",   Op::Cos,   false }, { "tan",   Op::Tan,   false },
+      { "asin",  Op::Asin,  false }, { "acos",  Op::Acos,  false }, { "atan",  Op::Atan,  false },
+      { "sinh",  Op::Sinh,  false }, { "cosh",  Op::Cosh,  false }, { "tanh",  Op::Tanh,  false },
+      { "asinh", Op::Asinh, false }, { "acosh", Op::Acosh, false }, { "atanh", Op::Atanh, false },
+      { "log2",  Op::Log2,  false }, { "log10", Op::Log10, false },
+      { "log",   Op::Ln,    false }, { "ln",    Op::Ln,    false },
+      { "exp",   Op::Exp,   false }, { "sqrt",  Op::Sqrt,  false }, { "sign",  Op::Sign,  false },
+      { "rint",  Op::Rint,  false }, { "abs",   Op::Abs,   false },
+      { "min",   Op::Min,   true  }, { "max",   Op::Max,   true  },
+      { "sum",   Op::Sum,   true  }, { "avg",   Op::Avg,   true  },
+   };
+
+   for( const auto &function : functions ){
+      if( name != function.name )
+         continue;
+
+      int arguments = 0;
+      SkipSpace();
+      if( position < source.size() && source[position] != ')' ){
+         do {
+            ParseTernary();
+            arguments++;
+         } while( Accept( "," ) );
+      }
+      Expect( ")" );
+
+      if( arguments == 0 )
+         Fail( "Too few arguments for function.", name );
+      if( arguments > 1 && !function.variadic )
+         Fail( "Too many arguments for function.", name );
+
+      EmitOperation( function.op, arguments );
+      return;
+   }
+
+   position = start;
+   Fail( "Unknown function.", name );
+}
+
+template <typename Scalar>
+void Expression<Scalar>::SkipSpace(
+){
+   while( position < source.size() && std::isspace( (unsigned char)source[position] ) )
+      position++;
+}
+
+template <typename Scalar>
+bool Expression<Scalar>::Accept(
+   const char *token
+){
+   SkipSpace();
+   size_t length = std::strlen( token );
+   if( source.compare( position, length, token ) != 0 )
+      return false;
+
+   position += length;
+   return true;
+}
+
+template <typename Scalar>
+void Expression<Scalar>::Expect(
+   const char *token
+){
+   if( Accept( token ) )
+      return;
+
+   if( position >= source.size() )
+      Fail( std::string( "Missing \"" ) + token + "\".", "" );
+   Fail( std::string( "Expected \"" ) + token + "\".", source.substr( position, 1 ) );
+}
+
+template <typename Scalar>
+void Expression<Scalar>::Fail(
+   const std::string &message
+ , const std::string &token
+){
+   throw ExpressionError( message, source, token, (int)position );
+}
+
+template <typename Scalar>
+void Expression<Scalar>::EmitValue(
+   Op op
+ , Scalar value
+ , const Scalar *var
+){
+   Instruction in;
+   in.op    = op;
+   in.count = 0;
+   in.value = value;
+   in.var   = var;
+   code.push_back( in );
+
+   depth++;
+   maxDepth = std::max( maxDepth, depth );
+}
+
+template <typename Scalar>
+void Expression<Scalar>::EmitOperation(
+   Op op
+ , int arguments
+){
+   bool jump = ( op == Op::Jump || op == Op::JumpIfFalse );
+
+   // fold operations on constants, but never across a jump target
+   bool constant = !jump && code.size() >= foldBarrier + arguments;
+   for( int i = 0; constant && i < arguments; i++ )
+      constant = code[code.size() - 1 - i].op == Op::Const;
+   if( constant ){
+      std::vector<Scalar> args( arguments );
+      for( int i = 0; i < arguments; i++ )
+         args[i] = code[code.size() - arguments + i].value;
+      Scalar value = Apply( op, args.data(), arguments );
+      code.resize( code.size() - arguments );
+      depth -= arguments;
+      EmitValue( Op::Const, value, nullptr );
+      return;
+   }
+
+   Instruction in;
+   in.op    = op;
+   in.count = arguments;
+   in.value = Scalar( 0 );
+   in.var   = nullptr;
+   code.push_back( in );
+
+   if( jump )
+      foldBarrier = code.size();
+   else
+      depth -= arguments - 1;
+}
+
+// one evaluator per supported precision
+template class ExpressionSymbols<float>;
+template class ExpressionSymbols<double>;
+template class ExpressionSymbols<long double>;
+template class ExpressionSymbols<DoubleDouble>;
+
+template class Expression<float>;
+template class Expression<double>;
+template class Expression<long double>;
+template class Expression<DoubleDouble>;
@@ -0,0 +1,132 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+// C headers
+#include <cstddef>
+
+// C++ headers
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Parse error, with the same accessors as mu::Parser::exception_type
+class ExpressionError
+{
+public:
+   ExpressionError( const std::string &message
+                  , const std::string &expression
+                  , const std::string &token
+                  , int position );
+
+   const std::string &GetMsg() const;
+   const std::string &GetExpr() const;
+   const std::string &GetToken() const;
+   int GetPos() const;
+
+private:
+   std::string message;
+   std::string expression;
+   std::string token;
+   int position;
+};
+
+// Names of the values expressions may refer to, shared by all expressions
+// of a problem.
+template <typename Scalar>
+class ExpressionSymbols
+{
+public:
+   void Clear();
+   void Define( const std::string &name
+              , Scalar *value );
+   Scalar *Find( const std::string &name ) const;
+
+private:
+   std::unordered_map<std::string, Scalar *> table;
+};
+
+// Math expression compiled to a stack program and evaluated in Scalar.
+// Accepts the muParser syntax used by problem files: numbers, symbols,
+// + - * / ^, comparisons, && || and ?:, the built-in functions and
+// the constants _pi and _e. Constant subexpressions are folded when
+// compiling.
+template <typename Scalar>
+class Expression
+{
+public:
+   Expression();
+
+   void SetSymbols( const ExpressionSymbols<Scalar> *symbols );
+   void SetExpr( const std::string &expression );
+   const std::string &GetExpr() const;
+   bool IsConstant() const;
+
+   Scalar Eval() const;
+
+   // Taylor coefficient `order` of the expression in time, for series
+   // integrators. Symbols must point to SeriesLength coefficients each,
+   // and orders be requested as 0, 1, 2, ...; order 0 starts a new series.
+   // The branch of ?: and the argument picked by min and max are the ones
+   // chosen at order 0.
+   static const int MaxSeriesOrder = 48;
+   static const int SeriesLength   = MaxSeriesOrder + 1;
+   Scalar EvalCoefficient( int order ) const;
+
+private:
+   enum class Op : unsigned char {
+      Const, Var
+    , Neg, Add, Sub, Mul, Div, Pow
+    , Less, Greater, LessEqual, GreaterEqual, Equal, NotEqual, And, Or
+    , Jump, JumpIfFalse
+    , Sin, Cos, Tan, Asin, Acos, Atan, Sinh, Cosh, Tanh, Asinh, Acosh, Atanh
+    , Log2, Log10, Ln, Exp, Sqrt, Sign, Rint, Abs
+    , Min, Max, Sum, Avg
+   };
+
+   struct Instruction {
+      Op op;
+      int count;         // arguments of Min..Avg, target of jumps
+      Scalar value;
+      const Scalar *var;
+   };
+
+   const ExpressionSymbols<Scalar> *symbols = nullptr;
+   std::string source;
+   std::vector<Instruction> code;
+   mutable std::vector<Scalar> stack;
+
+   // series evaluation: coefficients of every instruction, with two
+   // auxiliary series each, and the producers of the stack entries
+   mutable std::vector<Scalar> series;
+   mutable std::vector<int> producers;
+
+   // compiler state
+   size_t position;
+   size_t foldBarrier;
+   int depth;
+   int maxDepth;
+
+   void ParseTernary();
+   void ParseOr();
+   void ParseAnd();
+   void ParseComparison();
+   void ParseAdditive();
+   void ParseMultiplicative();
+   void ParseUnary();
+   void ParsePower();
+   void ParsePrimary();
+
+   void SkipSpace();
+   bool Accept( const char *token );
+   void Expect( const char *token );
+   void Fail( const std::string &message, const std::string &token );
+
+   void EmitValue( Op op, Scalar value, const Scalar *var );
+   void EmitOperation( Op op, int arguments );
+   static Scalar Apply( Op op, const Scalar *args, int count );
+
+   Scalar *Coefficients( size_t pc, int slot ) const;
+   void SeriesStep( size_t pc, const int *args, int order ) const;
+};
+
+#endif // EXPRESSION_HPP
@@ -0,0 +1,156 @@
+#include "frame_exporter.hpp"
+
+FrameExporter::FrameExporter(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , QMap<QString, int> rate_groups
+ , PointValues val_init
+ , double timeSlice
+ , Precision solverPrecision
+ , Method solverMethod
+ , double solverTolerance
+ , QRect viewportArea
+ , QString transformationX
+ , QString transformationY
+ , QStringList paramNames
+ , int maxPathLength
+ , ExportSettings exportSettings
+ , QObject */*parent*/ // unused
+){
+   varRules      = ddt_rules;
+   paramRules    = param_rules;
+   rateGroups    = rate_groups;
+   initialValues = val_init;
+   dt            = timeSlice;
+   precision     = solverPrecision;
+   method        = solverMethod;
+   tolerance     = solverTolerance;
+
+   viewport    = viewportArea;
+   transformX  = transformationX;
+   transformY  = transformationY;
+   params      = paramNames;
+   maxSegments = maxPathLength;
+
+   settings  = exportSettings;
+   stateExit = false;
+}
+
+void FrameExporter::run(
+){
+   // a private stepper, so the live run is untouched
+   QScopedPointer<Stepper> stepper( CreateStepper( precision, method, tolerance ) );
+   stepper->SetConditions( varRules, paramRules, initialValues, dt, rateGroups );
+   CoordinateTransform transform( transformX, transformY, params );
+
+   // plot points on the frame time grid
+   QVector<QPointF> points( settings.frames );
+   double tStart = stepper->InitialValues().T;
+   for( int k = 0; k < settings.frames; k++ ){
+      double tOut = tStart + ( k + 1 ) * settings.spacing;
+      while( stepper->DenseEndTime() < tOut ){
+         stepper->CalculateStep();
+         if( stateExit )
+            return;
+      }
+      points[k] = transform.Map( stepper->DenseOutput( tOut ) );
+   }
+
+   // open output
+   QFile rawFile;
+   QDir  pngDir( settings.target );
+   if( settings.raw ){
+      bool opened;
+      if( settings.target == "-" ){
+         opened = rawFile.open( stdout, QIODevice::WriteOnly );
+      } else {
+         rawFile.setFileName( settings.target );
+         opened = rawFile.open( QIODevice::WriteOnly );
+      }
+      if( !opened ){
+         emit failed( tr("Can't open %1: %2").arg( settings.target ).arg( rawFile.errorString() ) );
+         return;
+      }
+   } else if( !pngDir.mkpath( "." ) ){
+      emit failed( tr("Can't create directory %1").arg( settings.target ) );
+      return;
+   }
+
+   FrameRenderer renderer;
+   renderer.points      = &points;
+   renderer.colors      = RenderView::pathColors( maxSegments );
+   renderer.viewRect    = RenderView::fitViewRect( viewport, settings.size );
+   renderer.size        = settings.size;
+   renderer.maxSegments = maxSegments;
+   renderer.raw         = settings.raw;
+
+   // rasterise in batches; results are taken in order,
+   // each one as soon as it is done
+   int batch = 4 * QThreadPool::globalInstance()->maxThreadCount();
+   for( int first = 0; first < settings.frames; first += batch ){
+      QVector<int> frames;
+      for( int k = first; k < std::min( first + batch, settings.frames ); k++ )
+         frames.push_back( k );
+
+      QFuture<QByteArray> future = QtConcurrent::mapped( frames, renderer );
+      for( int i = 0; i < frames.size(); i++ ){
+         QByteArray data = future.resultAt( i );
+         if( settings.raw ){
+            rawFile.write( data );
+         } else {
+            QFile png( pngDir.filePath( QString( "frame_%1.png" ).arg( frames[i], 6, 10, QChar('0') ) ) );
+            if( !png.open( QIODevice::WriteOnly ) || png.write( data ) != data.size() ){
+               future.cancel();
+               future.waitForFinished();
+               emit failed( tr("Can't write %1: %2").arg( png.fileName() ).arg( png.errorString() ) );
+               return;
+            }
+         }
+      }
+
+      emit progress( first + frames.size(), settings.frames );
+      if( stateExit )
+         return;
+   }
+
+   if( settings.raw )
+      rawFile.flush();
+}
+
+void FrameExporter::stop(
+){
+   stateExit = true;
+}
+
+QByteArray FrameExporter::FrameRenderer::operator()(
+   int frame
+) const {
+   QImage image( size, QImage::Format_RGB32 );
+   QPainter painter( &image );
+   painter.setRenderHint( QPainter::Antialiasing );
+   painter.fillRect( image.rect(), QBrush(Qt::white) );
+
+   // path ending at this frame, newest segment first
+   QVector<QLineF> segments;
+   int oldest = std::max( 0, frame - maxSegments + 1 );
+   for( int k = frame; k > oldest; k-- )
+      segments.append( QLineF( (*points)[k-1], (*points)[k] ) );
+
+   RenderView::paintScene( painter, viewRect, segments, colors );
+   painter.end();
+
+   QByteArray data;
+   if( raw ){
+      // tightly packed RGB24 rows
+      QImage rgb = image.convertToFormat( QImage::Format_RGB888 );
+      data.reserve( rgb.width() * rgb.height() * 3 );
+      for( int y = 0; y < rgb.height(); y++ )
+         data.append( reinterpret_cast<const char *>( rgb.constScanLine( y ) ), rgb.width() * 3 );
+   } else {
+      QBuffer buffer( &data );
+      buffer.open( QIODevice::WriteOnly );
+      image.save( &buffer, "PNG" );
+   }
+
+   return data;
+}
@@ -0,0 +1,101 @@
+#ifndef FRAME_EXPORTER_HPP
+#define FRAME_EXPORTER_HPP
+
+// Qt headers
+#include <QThread>
+#include <QImage>
+#include <QPainter>
+#include <QFile>
+#include <QBuffer>
+#include <QDir>
+#include <QSize>
+#include <QVector>
+#include <QScopedPointer>
+#include <QtConcurrent>
+
+// C headers
+#include <cstdio>
+
+// C++ headers
+#include <atomic>
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "stepper.hpp"
+#include "coordinate_transform.hpp"
+#include "render_view.hpp"
+
+typedef struct {
+   QSize   size;        // frame size in pixels
+   double  spacing;     // simulated time between frames
+   int     frames;      // frame count
+   bool    raw;         // raw RGB24 stream instead of PNG files
+   QString target;      // directory for PNG, file or pipe for raw ("-" = stdout)
+} ExportSettings;
+
+// Renders a run offscreen, independent of the window and of real time.
+// A separate stepper produces points on a uniform time grid; frames are
+// rasterised concurrently on the global thread pool and written in order.
+class FrameExporter : public QThread
+{
+   Q_OBJECT
+
+public:
+   explicit FrameExporter( DerivationVector ddt_rules
+                         , EquationVector param_rules
+                         , QMap<QString, int> rate_groups
+                         , PointValues val_init
+                         , double timeSlice
+                         , Precision solverPrecision
+                         , Method solverMethod
+                         , double solverTolerance
+                         , QRect viewportArea
+                         , QString transformationX
+                         , QString transformationY
+                         , QStringList paramNames
+                         , int maxPathLength
+                         , ExportSettings exportSettings
+                         , QObject *parent = 0 );
+   void run() Q_DECL_OVERRIDE;
+   void stop();
+
+signals:
+   void progress( int done, int total );
+   void failed( QString message );
+
+private:
+   DerivationVector varRules;
+   EquationVector   paramRules;
+   QMap<QString, int> rateGroups;
+   PointValues initialValues;
+   double dt;
+   Precision precision;
+   Method method;
+   double tolerance;
+
+   QRect   viewport;
+   QString transformX;
+   QString transformY;
+   QStringList params;
+   int maxSegments;
+
+   ExportSettings settings;
+   std::atomic<bool> stateExit;
+
+   // rasterises and encodes one frame from the shared list of plot points
+   struct FrameRenderer {
+      typedef QByteArray result_type;
+
+      const QVector<QPointF> *points;
+      QVector<QColor> colors;
+      QRect viewRect;
+      QSize size;
+      int maxSegments;
+      bool raw;
+
+      QByteArray operator()( int frame ) const;
+   };
+};
+
+#endif // FRAME_EXPORTER_HPP
@@ -29,6 +29,11 @@ LabelDockWidget::LabelDockWidget(
 
    // finalize
    setLayout( labelLayout );
+
+   // labels are refreshed at their own rate, not per frame
+   refreshTimer = new QTimer( this );
+   connect( refreshTimer, &QTimer::timeout, this, &LabelDockWidget::refreshLabels );
+   setRefreshRate( 10 );
 }
 
 LabelDockWidget::~LabelDockWidget(
@@ -75,11 +80,25 @@ void LabelDockWidget::addParamLabel(
    QLabel *titleLabel = new QLabel( name, labelLayout->parentWidget() );
    labelLayout->addWidget( titleLabel, rows-2, 0 );
 
-   // add new label - value
-   QLabel *valueLabel = new QLabel( "---", labelLayout->parentWidget() );
+   // add new label - value, with statistics below it
+   QWidget *valueBox = new QWidget( labelLayout->parentWidget() );
+   QVBoxLayout *valueLayout = new QVBoxLayout( valueBox );
+   valueLayout->setContentsMargins( 0, 0, 0, 0 );
+   valueLayout->setSpacing( 0 );
+
+   QLabel *valueLabel = new QLabel( "---", valueBox );
    valueLabel->setAlignment( Qt::AlignRight | Qt::AlignCenter );
    valueLabel->setTextInteractionFlags( Qt::TextInteractionFlag::TextSelectableByMouse | Qt::TextInteractionFlag::TextSelectableByKeyboard );
-   labelLayout->addWidget( valueLabel, rows-2, 1 );
+   valueLayout->addWidget( valueLabel );
+
+   QLabel *statsLabel = new QLabel( "", valueBox );
+   statsLabel->setAlignment( Qt::AlignRight | Qt::AlignCenter );
+   statsLabel->setTextInteractionFlags( Qt::TextInteractionFlag::TextSelectableByMouse | Qt::TextInteractionFlag::TextSelectableByKeyboard );
+   statsLabel->setStyleSheet( "color: gray; font-size: small;" );
+   statsLabel->setVisible( labelParamIndex[name] >= 0 );
+   valueLayout->addWidget( statsLabel );
+
+   labelLayout->addWidget( valueBox, rows-2, 1 );
 
    // add new label - remove box
    if( removable ){
@@ -90,21 +109,84 @@ void LabelDockWidget::addParamLabel(
 
    labelNames.push_back( name );
    valueLabels[name] = valueLabel;
+
+   labelIndex.push_back( labelParamIndex[name] );
+   valueLabelList.push_back( valueLabel );
+   statsLabelList.push_back( statsLabel );
+   valueText.push_back( valueLabel->text() );
+}
+
+void LabelDockWidget::setRefreshRate(
+   int maxFPS
+){
+   refreshTimer->start( 1000 / ( maxFPS > 0 ? maxFPS : 1 ) );
+}
+
+QVector<int> LabelDockWidget::statisticsIndices(
+){
+   // parameters with statistics, in label order; time has none
+   QVector<int> indices;
+   for( int pi : labelIndex ){
+      if( pi >= 0 )
+         indices.push_back( pi );
+   }
+
+   return indices;
 }
 
 void LabelDockWidget::updateParamLabels(
    PointValues values
 ){
-   QString val;
-   for( auto name : labelNames ){
-      int pi = labelParamIndex[name];
-      if( pi < 0 ){
-         // time
-         val = QString::number( values.T );
-      } else {
-         val = QString::number( values.Param[pi] );
+   // only keep the values, text is updated by refreshLabels()
+   latestValues  = values;
+   valuesChanged = true;
+}
+
+void LabelDockWidget::updateStatistics(
+   StatisticsVector statistics
+){
+   latestStats  = statistics;
+   statsChanged = true;
+}
+
+void LabelDockWidget::refreshLabels(
+){
+   if( valuesChanged ){
+      valuesChanged = false;
+
+      QString val;
+      for( int l = 0; l < labelIndex.size(); l++ ){
+         int pi = labelIndex[l];
+         if( pi < 0 ){
+            // time
+            val = QString::number( latestValues.T );
+         } else {
+            val = QString::number( latestValues.Param[pi] );
+         }
+
+         // skip unchanged text, setText triggers a relayout
+         if( val != valueText[l] ){
+            valueText[l] = val;
+            valueLabelList[l]->setText( val );
+         }
+      }
+   }
+
+   if( statsChanged ){
+      statsChanged = false;
+
+      int si = 0;
+      for( int l = 0; l < labelIndex.size() && si < latestStats.size(); l++ ){
+         if( labelIndex[l] < 0 )
+            continue;
+
+         const RunningStatistics &stat = latestStats[si++];
+         statsLabelList[l]->setText( tr("%1 .. %2, mean %3, rms %4")
+                                        .arg( stat.min,   0, 'g', 4 )
+                                        .arg( stat.max,   0, 'g', 4 )
+                                        .arg( stat.mean,  0, 'g', 4 )
+                                        .arg( stat.Rms(), 0, 'g', 4 ) );
       }
-      valueLabels[name]->setText( val );
    }
 }
 
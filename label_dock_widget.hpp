@@ -8,12 +8,14 @@
 #include <QLabel>
 #include <QComboBox>
 #include <QResizeEvent>
+#include <QTimer>
 
 // C++ headers
 #include <iostream>
 
 // Local headers
 #include "ode_pathtracer.hpp"
+#include "running_statistics.hpp"
 
 class LabelDockWidget : public QWidget
 {
@@ -25,11 +27,14 @@ public:
 
    void addParamLabel( QString name
                      , bool    removable = true );
+   void setRefreshRate( int maxFPS );
+   QVector<int> statisticsIndices();
 
 signals:
 
 public slots:
    void updateParamLabels( PointValues values );
+   void updateStatistics( StatisticsVector statistics );
 
 private:
    // Elements
@@ -43,6 +48,21 @@ private:
    QMap<QString, int> labelParamIndex;
    QMap<QString, QLabel*> valueLabels;
 
+   // Per label, in labelNames order
+   QVector<int>      labelIndex;
+   QVector<QLabel *> valueLabelList;
+   QVector<QLabel *> statsLabelList;
+   QVector<QString>  valueText;
+
+   // Latest values, shown at the refresh rate
+   QTimer *refreshTimer;
+   PointValues latestValues;
+   StatisticsVector latestStats;
+   bool valuesChanged = false;
+   bool statsChanged  = false;
+
+   void refreshLabels();
+
 protected:
    void resizeEvent( QResizeEvent *event ) override;
 };
@@ -1,4 +1,4 @@
-#include "plot_window.hpp"
+#include "workspace.hpp"
 #include <QApplication>
 
 int main(
@@ -6,7 +6,7 @@ int main(
  , char *argv[]
 ){
    QApplication app( argc, argv );
-   PlotWindow w;
+   Workspace w;
 
    QCoreApplication::setOrganizationName( "UEC" );
    QCoreApplication::setApplicationName( "PDE PathTracer" );
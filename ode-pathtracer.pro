@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -26,18 +26,74 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
    main.cpp \
    plot_window.cpp \
+   workspace.cpp \
    runge_kutta_stepper.cpp \
+   stepper.cpp \
+   precision_stepper.cpp \
+   taylor_stepper.cpp \
+   butcher_tableau.cpp \
+   delay_history.cpp \
+   sde_stepper.cpp \
+   ensemble_solver.cpp \
+   expression.cpp \
+   double_double.cpp \
    render_view.cpp \
    simulation_loop.cpp \
-   label_dock_widget.cpp
+   label_dock_widget.cpp \
+   equation_dock_widget.cpp \
+   symbol_table.cpp \
+   parareal_solver.cpp \
+   parallel_evaluator.cpp \
+   trajectory_store.cpp \
+   xor_codec.cpp \
+   problem_cache.cpp \
+   coordinate_transform.cpp \
+   frame_exporter.cpp \
+   trajectory_publisher.cpp \
+   shared_memory_ring.cpp \
+   density_histogram.cpp \
+   path_history.cpp \
+   segment_index.cpp \
+   orbit_finder.cpp \
+   parameter_fitter.cpp \
+   dense_linear.cpp
 
 HEADERS  += \
    plot_window.hpp \
+   workspace.hpp \
    runge_kutta_stepper.hpp \
+   stepper.hpp \
+   precision_stepper.hpp \
+   taylor_stepper.hpp \
+   butcher_tableau.hpp \
+   delay_history.hpp \
+   sde_stepper.hpp \
+   ensemble_solver.hpp \
+   philox.hpp \
+   expression.hpp \
+   double_double.hpp \
    render_view.hpp \
    simulation_loop.hpp \
    ode_pathtracer.hpp \
-   label_dock_widget.hpp
+   label_dock_widget.hpp \
+   equation_dock_widget.hpp \
+   symbol_table.hpp \
+   parareal_solver.hpp \
+   parallel_evaluator.hpp \
+   trajectory_store.hpp \
+   xor_codec.hpp \
+   problem_cache.hpp \
+   running_statistics.hpp \
+   coordinate_transform.hpp \
+   frame_exporter.hpp \
+   trajectory_publisher.hpp \
+   shared_memory_ring.hpp \
+   density_histogram.hpp \
+   path_history.hpp \
+   segment_index.hpp \
+   orbit_finder.hpp \
+   parameter_fitter.hpp \
+   dense_linear.hpp
 
 FORMS    += plot_window.ui
 
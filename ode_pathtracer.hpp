@@ -19,4 +19,23 @@ typedef QVector<Equation> EquationVector;
 typedef QPair<QString, QString> Derivation; // variable name and d/dt
 typedef QVector<Derivation> DerivationVector;
 
+// Ini file sections
+#define SECTION_NAMES     "names"
+#define SECTION_PARAM_EQ  "parameter equations"
+#define SECTION_VAR_DERIV "variable derivations"
+#define SECTION_VAR_INIT  "variable initial"
+#define SECTION_VAR_DIFF  "variable diffusion"
+#define SECTION_TIME      "time"
+#define SECTION_PLOT      "plot"
+#define SECTION_RATES     "rate groups"
+#define SECTION_PARAREAL  "parareal"
+#define SECTION_RECORD    "record"
+#define SECTION_STREAM    "stream"
+#define SECTION_SHARED    "shared memory"
+#define SECTION_SOLVER    "solver"
+#define SECTION_ENSEMBLE  "ensemble"
+#define SECTION_ORBIT     "orbit"
+#define SECTION_FIT       "fit"
+#define SECTION_FIT_PARAM "fit parameters"
+
 #endif // ODE_PATH_TRACER_HPP
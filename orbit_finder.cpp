@@ -0,0 +1,449 @@
+#include "orbit_finder.hpp"
+
+OrbitFinder::OrbitFinder(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , double timeSlice
+ , OrbitKind orbitKind
+ , PointValues seedPoint
+ , OrbitSettings orbitSettings
+ , QObject */*parent*/ // unused
+){
+   dt       = timeSlice;
+   kind     = orbitKind;
+   seed     = seedPoint;
+   settings = orbitSettings;
+   stateExit = false;
+
+   n = ddt_rules.size();
+   m = kind == OrbitKind::Periodic ? std::max( 1, settings.segments ) : 1;
+   period = 0.0;
+
+   // private steppers, so the live run is untouched
+   shooter.resize( m );
+   for( int j = 0; j < m; j++ ){
+      shooter[j] = new RungeKuttaStepper;
+      shooter[j]->SetConditions( ddt_rules, param_rules, seed, dt );
+   }
+
+   result.kind       = kind;
+   result.converged  = false;
+   result.iterations = 0;
+   result.residual   = std::numeric_limits<double>::infinity();
+   result.period     = 0.0;
+   result.point      = seed;
+}
+
+OrbitFinder::~OrbitFinder(
+){
+   for( auto stepper : shooter ){
+      delete stepper;
+   }
+   shooter.clear();
+}
+
+void OrbitFinder::run(
+){
+   if( kind == OrbitKind::Equilibrium )
+      FindEquilibrium();
+   else
+      FindPeriodicOrbit();
+}
+
+void OrbitFinder::stop(
+){
+   stateExit = true;
+}
+
+OrbitResult OrbitFinder::Result(
+){
+   return result;
+}
+
+QString OrbitFinder::Summary(
+   const OrbitResult &result
+){
+   QString text;
+   bool stable = true;
+   if( result.kind == OrbitKind::Equilibrium ){
+      text = tr("Equilibrium");
+      for( auto re : result.eigenReal )
+         stable = stable && re < 0.0;
+   } else {
+      text = tr("Periodic orbit, period %1,").arg( result.period );
+      // leave out the trivial multiplier, the one closest to 1
+      int trivial = -1;
+      double closest = std::numeric_limits<double>::infinity();
+      for( int i = 0; i < result.eigenReal.size(); i++ ){
+         double distance = std::hypot( result.eigenReal[i] - 1.0, result.eigenImag[i] );
+         if( distance < closest ){
+            closest = distance;
+            trivial = i;
+         }
+      }
+      for( int i = 0; i < result.eigenReal.size(); i++ )
+         if( i != trivial )
+            stable = stable && std::hypot( result.eigenReal[i], result.eigenImag[i] ) < 1.0;
+   }
+   text += result.converged ? tr(" %1").arg( stable ? tr("stable") : tr("unstable") )
+                            : tr(" not converged");
+   text += tr(" (residual %1 after %2 iterations);").arg( result.residual ).arg( result.iterations );
+   text += result.kind == OrbitKind::Equilibrium ? tr(" eigenvalues") : tr(" multipliers");
+   for( int i = 0; i < result.eigenReal.size(); i++ ){
+      if( result.eigenImag[i] == 0.0 )
+         text += QString(" %1").arg( result.eigenReal[i] );
+      else
+         text += QString(" %1%2%3i").arg( result.eigenReal[i] )
+                                   .arg( result.eigenImag[i] < 0.0 ? "-" : "+" )
+                                   .arg( std::abs( result.eigenImag[i] ) );
+   }
+
+   return text;
+}
+
+void OrbitFinder::FindEquilibrium(
+){
+   RungeKuttaStepper *stepper = shooter[0];
+   QVector<double> x = seed.Val;
+   QVector<double> f = Rhs( x );
+   QVector<double> jacobian( n*n );
+
+   int iteration = 0;
+   for( ; iteration < settings.iterations && MaxNorm( f ) > settings.tolerance; iteration++ ){
+      if( stateExit )
+         return;
+
+      // Jacobian, one column per variable
+      for( int c = 0; c < n; c++ ){
+         double eps = Step( x[c] );
+         QVector<double> xp( x ), xm( x );
+         xp[c] += eps;
+         xm[c] -= eps;
+         QVector<double> fp = Rhs( xp );
+         QVector<double> fm = Rhs( xm );
+         for( int r = 0; r < n; r++ )
+            jacobian[r*n+c] = ( fp[r] - fm[r] ) / ( 2.0*eps );
+      }
+
+      QVector<double> dx( f );
+      for( auto &value : dx )
+         value = -value;
+      if( !SolveLinear( jacobian, dx, n ) ){
+         emit failed( tr("Equilibrium search stopped: singular Jacobian.") );
+         return;
+      }
+
+      // halve the step until the residual decreases
+      double norm = MaxNorm( f );
+      double lambda = 1.0;
+      QVector<double> xn( n );
+      QVector<double> fn;
+      for( int halving = 0; halving < 20; halving++, lambda *= 0.5 ){
+         for( int i = 0; i < n; i++ )
+            xn[i] = x[i] + lambda * dx[i];
+         fn = Rhs( xn );
+         if( MaxNorm( fn ) < norm )
+            break;
+      }
+      x = xn;
+      f = fn;
+   }
+
+   // stability from the Jacobian at the final point
+   for( int c = 0; c < n; c++ ){
+      double eps = Step( x[c] );
+      QVector<double> xp( x ), xm( x );
+      xp[c] += eps;
+      xm[c] -= eps;
+      QVector<double> fp = Rhs( xp );
+      QVector<double> fm = Rhs( xm );
+      for( int r = 0; r < n; r++ )
+         jacobian[r*n+c] = ( fp[r] - fm[r] ) / ( 2.0*eps );
+   }
+   Eigenvalues( jacobian, n, result.eigenReal, result.eigenImag );
+
+   result.iterations = iteration;
+   result.residual   = MaxNorm( f );
+   result.converged  = result.residual <= settings.tolerance;
+   result.point      = stepper->Point( seed.T, x );
+   result.orbit      = { result.point };
+}
+
+void OrbitFinder::FindPeriodicOrbit(
+){
+   if( !EstimatePeriod() )
+      return;
+
+   // first guess: consecutive segments of the estimated period
+   segmentStart.resize( m );
+   segmentEnd.resize( m );
+   endSlope.resize( m );
+   block.resize( m );
+   path.resize( m );
+   segmentStart[0] = seed.Val;
+   for( int j = 0; j+1 < m; j++ ){
+      Shoot( j, false, false );
+      segmentStart[j+1] = segmentEnd[j];
+      if( stateExit )
+         return;
+   }
+
+   int N = n*m + 1;
+   int iteration = 0;
+   QVector<double> F;
+   while( true ){
+      ShootAll( true );
+      if( stateExit )
+         return;
+      F = ShootingResidual();
+      if( MaxNorm( F ) <= settings.tolerance || iteration >= settings.iterations )
+         break;
+      iteration++;
+
+      // Newton matrix: segment blocks, the -I coupling to the next
+      // segment, the period column and the phase condition
+      QVector<double> J( N*N, 0.0 );
+      for( int j = 0; j < m; j++ ){
+         int next = ( j+1 ) % m;
+         for( int r = 0; r < n; r++ ){
+            int row = j*n + r;
+            for( int c = 0; c < n; c++ )
+               J[row*N + j*n + c] += block[j][r*n+c];
+            J[row*N + next*n + r] -= 1.0;
+            J[row*N + N-1] = endSlope[j][r] / m;
+         }
+      }
+      for( int c = 0; c < n; c++ )
+         J[(N-1)*N + c] = normal[c];
+
+      QVector<double> dz( F );
+      for( auto &value : dz )
+         value = -value;
+      if( !SolveLinear( J, dz, N ) ){
+         emit failed( tr("Periodic orbit search stopped: singular shooting matrix.") );
+         return;
+      }
+
+      // damped update; the period may at most halve or double per
+      // iteration
+      QVector<QVector<double>> oldStart( segmentStart );
+      double oldPeriod = period;
+      double norm = MaxNorm( F );
+      double lambda = 1.0;
+      while( oldPeriod + lambda * dz[N-1] < 0.5 * oldPeriod
+          || oldPeriod + lambda * dz[N-1] > 2.0 * oldPeriod )
+         lambda *= 0.5;
+      for( int halving = 0; halving < 20; halving++, lambda *= 0.5 ){
+         for( int j = 0; j < m; j++ )
+            for( int i = 0; i < n; i++ )
+               segmentStart[j][i] = oldStart[j][i] + lambda * dz[j*n+i];
+         period = oldPeriod + lambda * dz[N-1];
+         ShootAll( false );
+         if( stateExit )
+            return;
+         if( MaxNorm( ShootingResidual() ) < norm )
+            break;
+      }
+   }
+
+   // an equilibrium solves the shooting equations for any period
+   if( MaxNorm( Rhs( segmentStart[0] ) ) <= 1e-6 * MaxNorm( normal ) ){
+      emit failed( tr("Periodic orbit search stopped: the orbit shrank to an equilibrium.") );
+      return;
+   }
+
+   // Floquet multipliers: monodromy is the product of the segment blocks
+   QVector<double> monodromy( block[0] );
+   for( int j = 1; j < m; j++ ){
+      QVector<double> product( n*n, 0.0 );
+      for( int r = 0; r < n; r++ )
+         for( int k = 0; k < n; k++ )
+            for( int c = 0; c < n; c++ )
+               product[r*n+c] += block[j][r*n+k] * monodromy[k*n+c];
+      monodromy = product;
+   }
+   Eigenvalues( monodromy, n, result.eigenReal, result.eigenImag );
+
+   ShootAll( false, true );
+   result.orbit.clear();
+   for( auto &points : path )
+      result.orbit += points;
+
+   result.iterations = iteration;
+   result.residual   = MaxNorm( F );
+   result.converged  = result.residual <= settings.tolerance;
+   result.period     = period;
+   result.point      = result.orbit.isEmpty() ? seed : result.orbit.first();
+}
+
+bool OrbitFinder::EstimatePeriod(
+){
+   RungeKuttaStepper *stepper = shooter[0];
+   reference = seed.Val;
+   normal    = Rhs( reference );
+   if( MaxNorm( normal ) == 0.0 ){
+      emit failed( tr("Periodic orbit search stopped: the seed point is an equilibrium.") );
+      return false;
+   }
+
+   // signed distance from the plane; it grows at first, so returns are
+   // crossings from below
+   auto side = [this]( const QVector<double> &x ){
+      double s = 0.0;
+      for( int i = 0; i < n; i++ )
+         s += ( x[i] - reference[i] ) * normal[i];
+      return s;
+   };
+
+   // symmetric orbits can cross the plane far from the seed first, so
+   // the period is the first return about as close as the closest one
+   QVector<double> returnTime;
+   QVector<double> returnDistance;
+   stepper->Reset();
+   stepper->SetTimeSlice( dt );
+   PointValues val = stepper->Point( seed.T, seed.Val );
+   double previous = 0.0;
+   for( long long steps = 1; steps * dt <= settings.maxPeriod; steps++ ){
+      PointValues next = stepper->Step( val );
+      if( stateExit )
+         return false;
+
+      double current = side( next.Val );
+      if( previous < 0.0 && current >= 0.0 ){
+         double theta = -previous / ( current - previous );
+         double distance = 0.0;
+         for( int i = 0; i < n; i++ ){
+            double x = val.Val[i] + theta * ( next.Val[i] - val.Val[i] );
+            distance = std::max( distance, std::abs( x - reference[i] ) );
+         }
+         returnTime.push_back( ( steps - 1 + theta ) * dt );
+         returnDistance.push_back( distance );
+      }
+      previous = current;
+      val = next;
+   }
+
+   if( returnTime.isEmpty() ){
+      emit failed( tr("Periodic orbit search stopped: no return to the seed within %1.").arg( settings.maxPeriod ) );
+      return false;
+   }
+   double closest = *std::min_element( returnDistance.begin(), returnDistance.end() );
+   for( int k = 0; k < returnTime.size(); k++ ){
+      if( returnDistance[k] <= 2.0 * closest ){
+         period = returnTime[k];
+         break;
+      }
+   }
+   return true;
+}
+
+PointValues OrbitFinder::Integrate(
+   RungeKuttaStepper *stepper
+ , double t0
+ , const QVector<double> &x
+ , double length
+ , QVector<PointValues> *points
+){
+   // whole steps close to dt, so the result is smooth in the length
+   long long steps = std::max( 1LL, (long long)std::ceil( length / dt ) );
+   stepper->Reset();
+   stepper->SetTimeSlice( length / steps );
+
+   PointValues val = stepper->Point( t0, x );
+   if( points != NULL )
+      points->push_back( val );
+   for( long long k = 0; k < steps && !stateExit; k++ ){
+      val = stepper->Step( val );
+      if( points != NULL )
+         points->push_back( val );
+   }
+
+   return val;
+}
+
+void OrbitFinder::Shoot(
+   int segment
+ , bool jacobian
+ , bool record
+){
+   RungeKuttaStepper *stepper = shooter[segment];
+   double length = period / m;
+   double t0 = seed.T + segment * length;
+   const QVector<double> &x = segmentStart[segment];
+
+   path[segment].clear();
+   PointValues val = Integrate( stepper, t0, x, length, record ? &path[segment] : NULL );
+   segmentEnd[segment] = val.Val;
+   endSlope[segment].resize( n );
+   stepper->Derivatives( val, endSlope[segment].data() );
+
+   if( !jacobian )
+      return;
+
+   // sensitivity of the end to the start, one column per variable
+   QVector<double> &matrix = block[segment];
+   matrix.resize( n*n );
+   for( int c = 0; c < n; c++ ){
+      double eps = Step( x[c] );
+      QVector<double> xp( x ), xm( x );
+      xp[c] += eps;
+      xm[c] -= eps;
+      QVector<double> fp = Integrate( stepper, t0, xp, length, NULL ).Val;
+      QVector<double> fm = Integrate( stepper, t0, xm, length, NULL ).Val;
+      for( int r = 0; r < n; r++ )
+         matrix[r*n+c] = ( fp[r] - fm[r] ) / ( 2.0*eps );
+   }
+}
+
+void OrbitFinder::ShootAll(
+   bool jacobian
+ , bool record
+){
+   QVector<int> pending;
+   for( int j = 0; j < m; j++ )
+      pending.push_back( j );
+   QtConcurrent::blockingMap( pending, [this, jacobian, record]( int &j ){ Shoot( j, jacobian, record ); } );
+}
+
+QVector<double> OrbitFinder::ShootingResidual(
+){
+   // segment ends against the next starts, and the phase condition
+   QVector<double> F( n*m + 1 );
+   for( int j = 0; j < m; j++ )
+      for( int i = 0; i < n; i++ )
+         F[j*n+i] = segmentEnd[j][i] - segmentStart[( j+1 ) % m][i];
+
+   double phase = 0.0;
+   for( int i = 0; i < n; i++ )
+      phase += ( segmentStart[0][i] - reference[i] ) * normal[i];
+   F[n*m] = phase;
+
+   return F;
+}
+
+QVector<double> OrbitFinder::Rhs(
+   const QVector<double> &x
+){
+   QVector<double> f( n );
+   RungeKuttaStepper *stepper = shooter[0];
+   stepper->Derivatives( stepper->Point( seed.T, x ), f.data() );
+   return f;
+}
+
+double OrbitFinder::MaxNorm(
+   const QVector<double> &v
+){
+   // NaN stays NaN, so a diverged search doesn't pass as converged
+   double norm = 0.0;
+   for( auto value : v )
+      if( !( std::abs( value ) <= norm ) )
+         norm = std::abs( value );
+   return norm;
+}
+
+double OrbitFinder::Step(
+   double x
+){
+   // central differences: error balance at the cube root of epsilon
+   return std::cbrt( std::numeric_limits<double>::epsilon() ) * std::max( 1.0, std::abs( x ) );
+}
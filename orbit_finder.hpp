@@ -0,0 +1,123 @@
+#ifndef ORBIT_FINDER_HPP
+#define ORBIT_FINDER_HPP
+
+// Qt headers
+#include <QThread>
+#include <QVector>
+#include <QString>
+#include <QtConcurrent>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <atomic>
+#include <limits>
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "runge_kutta_stepper.hpp"
+#include "dense_linear.hpp"
+
+enum class OrbitKind { Equilibrium, Periodic };
+
+typedef struct {
+   int    segments;    // shooting segments of a periodic orbit
+   int    iterations;  // Newton iteration limit
+   double tolerance;   // largest residual accepted
+   double maxPeriod;   // longest first return searched for
+} OrbitSettings;
+
+// Stability is given by the eigenvalues of the Jacobian for an
+// equilibrium, and by the Floquet multipliers (eigenvalues of the
+// monodromy matrix) for a periodic orbit; one multiplier is always 1.
+typedef struct {
+   OrbitKind kind;
+   bool   converged;
+   int    iterations;
+   double residual;
+   double period;
+   PointValues point;           // equilibrium, or start of the orbit
+   QVector<PointValues> orbit;  // one period, for drawing
+   QVector<double> eigenReal;
+   QVector<double> eigenImag;
+} OrbitResult;
+
+// Locates an equilibrium or a periodic orbit of an autonomous problem
+// near a seed point, by damped Newton iteration with Jacobians taken by
+// central differences.
+// Equilibria solve f(x) = 0. For periodic orbits the period is first
+// estimated by the return of the seed to the plane through it normal to
+// f, then multiple shooting splits the orbit into segments, integrated
+// concurrently, and Newton matches the segment ends and the period; the
+// first segment stays on that plane.
+class OrbitFinder : public QThread
+{
+   Q_OBJECT
+
+public:
+   explicit OrbitFinder( DerivationVector ddt_rules
+                       , EquationVector param_rules
+                       , double timeSlice
+                       , OrbitKind orbitKind
+                       , PointValues seedPoint
+                       , OrbitSettings orbitSettings
+                       , QObject *parent = 0 );
+   ~OrbitFinder();
+   void run() Q_DECL_OVERRIDE;
+   void stop();
+
+   OrbitResult Result();
+   static QString Summary( const OrbitResult &result );
+
+signals:
+   void failed( QString message );
+
+private:
+   double dt;
+   OrbitKind kind;
+   PointValues seed;
+   OrbitSettings settings;
+   std::atomic<bool> stateExit;
+   OrbitResult result;
+
+   int n;
+   int m;
+
+   // one stepper per segment, so segments can run concurrently
+   QVector<RungeKuttaStepper *> shooter;
+
+   // shooting state: segment start values and period, and what the
+   // segments give for them
+   double period;
+   QVector<double> reference;
+   QVector<double> normal;
+   QVector<QVector<double>> segmentStart;
+   QVector<QVector<double>> segmentEnd;
+   QVector<QVector<double>> endSlope;
+   QVector<QVector<double>> block;    // d end / d start, n x n
+   QVector<QVector<PointValues>> path;
+
+   void FindEquilibrium();
+   void FindPeriodicOrbit();
+   bool EstimatePeriod();
+
+   PointValues Integrate( RungeKuttaStepper *stepper
+                        , double t0
+                        , const QVector<double> &x
+                        , double length
+                        , QVector<PointValues> *points );
+   void Shoot( int segment
+             , bool jacobian
+             , bool record );
+   void ShootAll( bool jacobian
+                , bool record = false );
+   QVector<double> ShootingResidual();
+   QVector<double> Rhs( const QVector<double> &x );
+
+   static double MaxNorm( const QVector<double> &v );
+   static double Step( double x );
+};
+
+#endif // ORBIT_FINDER_HPP
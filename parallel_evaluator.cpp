@@ -0,0 +1,129 @@
+#include "parallel_evaluator.hpp"
+
+ParallelEvaluator::ParallelEvaluator(
+   int count
+ , int threads
+ , Kernel kernel
+){
+   this->count   = count;
+   this->threads = threads > 1 ? threads : 1;
+   this->kernel  = kernel;
+
+   target     = nullptr;
+   generation = 0;
+   pending    = 0;
+   exiting    = false;
+
+   // the calling thread takes partition 0
+   for( int i = 1; i < this->threads; i++ ){
+      workers.push_back( std::thread( &ParallelEvaluator::Work, this, i ) );
+   }
+}
+
+ParallelEvaluator::~ParallelEvaluator(
+){
+   {
+      std::lock_guard<std::mutex> lock( mutex );
+      exiting = true;
+      generation++;
+   }
+   startCondition.notify_all();
+
+   for( auto &worker : workers ){
+      worker.join();
+   }
+}
+
+void ParallelEvaluator::Evaluate(
+   double *out
+){
+   if( threads == 1 ){
+      kernel( 0, count, out );
+      return;
+   }
+
+   // start workers
+   {
+      std::lock_guard<std::mutex> lock( mutex );
+      target  = out;
+      error   = nullptr;
+      pending = threads - 1;
+      generation++;
+   }
+   startCondition.notify_all();
+
+   try {
+      Run( 0, out );
+   } catch( ... ){
+      std::lock_guard<std::mutex> lock( mutex );
+      error = std::current_exception();
+   }
+
+   // barrier: spin briefly, then sleep until the last worker is done
+   for( int spin = 0; spin < SpinCount && pending.load() > 0; spin++ ){
+      std::this_thread::yield();
+   }
+   if( pending.load() > 0 ){
+      std::unique_lock<std::mutex> lock( mutex );
+      doneCondition.wait( lock, [this]{ return pending.load() == 0; } );
+   }
+
+   if( error ){
+      std::rethrow_exception( error );
+   }
+}
+
+int ParallelEvaluator::Threads(
+){
+   return threads;
+}
+
+void ParallelEvaluator::Work(
+   int index
+){
+   long long seen = 0;
+
+   while( true ){
+      // wait for the next stage: spin briefly, then sleep
+      for( int spin = 0; spin < SpinCount && generation.load() == seen; spin++ ){
+         std::this_thread::yield();
+      }
+      double *out;
+      {
+         std::unique_lock<std::mutex> lock( mutex );
+         startCondition.wait( lock, [this, seen]{ return generation.load() != seen; } );
+         if( exiting )
+            return;
+         seen = generation.load();
+         out  = target;
+      }
+
+      try {
+         Run( index, out );
+      } catch( ... ){
+         std::lock_guard<std::mutex> lock( mutex );
+         error = std::current_exception();
+      }
+
+      if( pending.fetch_sub( 1 ) == 1 ){
+         std::lock_guard<std::mutex> lock( mutex );
+         doneCondition.notify_one();
+      }
+   }
+}
+
+void ParallelEvaluator::Run(
+   int index
+ , double *out
+){
+   // partition in units of cache lines, counted from the line `out` starts in
+   const int perLine = CacheLine / sizeof( double );
+   int shift = ( reinterpret_cast<std::uintptr_t>( out ) % CacheLine ) / sizeof( double );
+   int lines = ( count + shift + perLine - 1 ) / perLine;
+   int chunk = ( lines + threads - 1 ) / threads * perLine;
+
+   int begin = std::max( 0,     index * chunk - shift );
+   int end   = std::min( count, ( index + 1 ) * chunk - shift );
+   if( begin < end )
+      kernel( begin, end, out );
+}
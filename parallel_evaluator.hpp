@@ -0,0 +1,57 @@
+#ifndef PARALLEL_EVALUATOR_HPP
+#define PARALLEL_EVALUATOR_HPP
+
+// C headers
+#include <cstdint>
+
+// C++ headers
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+// Fills out[0..count) on a persistent pool of threads.
+// Every thread owns a fixed partition of indices, with bounds placed on
+// cache line boundaries of `out`, so no two threads write the same line.
+// Evaluate() returns only when all partitions are done.
+class ParallelEvaluator
+{
+public:
+   typedef std::function<void( int begin, int end, double *out )> Kernel;
+
+   ParallelEvaluator( int count
+                    , int threads
+                    , Kernel kernel );
+   ~ParallelEvaluator();
+
+   void Evaluate( double *out );
+   int  Threads();
+
+private:
+   static const int CacheLine = 64;
+   static const int SpinCount = 4096;
+
+   int count;
+   int threads;
+   Kernel kernel;
+
+   std::vector<std::thread> workers;
+   std::mutex mutex;
+   std::condition_variable startCondition;
+   std::condition_variable doneCondition;
+
+   double *target;
+   std::atomic<long long> generation;
+   std::atomic<int> pending;
+   bool exiting;
+   std::exception_ptr error;
+
+   void Work( int index );
+   void Run( int index, double *out );
+};
+
+#endif // PARALLEL_EVALUATOR_HPP
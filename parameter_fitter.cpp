@@ -0,0 +1,403 @@
+#include "parameter_fitter.hpp"
+
+ParameterFitter::ParameterFitter(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , QMap<QString, int> rate_groups
+ , PointValues initialValues
+ , double timeSlice
+ , Precision stepperPrecision
+ , Method stepperMethod
+ , double stepperTolerance
+ , FitSettings fitSettings
+ , QObject */*parent*/ // unused
+){
+   varRules        = ddt_rules;
+   paramRules      = param_rules;
+   rateGroups      = rate_groups;
+   init            = initialValues;
+   dt              = timeSlice;
+   precision       = stepperPrecision;
+   method          = stepperMethod;
+   solverTolerance = stepperTolerance;
+   settings        = fitSettings;
+   stateExit = false;
+
+   n = settings.names.size();
+   observations = 0;
+
+   result.converged    = false;
+   result.iterations   = 0;
+   result.observations = 0;
+   result.cost         = std::numeric_limits<double>::infinity();
+   result.rms          = std::numeric_limits<double>::infinity();
+}
+
+void ParameterFitter::run(
+){
+   QString error;
+   if( !Prepare( error ) ){
+      emit failed( tr("Fit stopped: %1.").arg( error ) );
+      return;
+   }
+
+   // start points: the equations, then random points within the bounds
+   Philox4x32 random( settings.seed );
+   QVector<FitStart> starts( std::max( 1, settings.starts ) );
+   for( int s = 0; s < starts.size(); s++ ){
+      starts[s].values.resize( n );
+      for( int j = 0; j < n; j++ ){
+         double lower = settings.lower[j];
+         double upper = settings.upper[j];
+         if( s == 0 ){
+            bool ok;
+            double value = paramRules[freeIndex[j]].second.toDouble( &ok );
+            starts[s].values[j] = ok ? std::min( std::max( value, lower ), upper ) : 0.5 * ( lower + upper );
+         } else {
+            starts[s].values[j] = lower + ( upper - lower ) * random.Uniform( s, j );
+         }
+      }
+      starts[s].cost       = std::numeric_limits<double>::infinity();
+      starts[s].iterations = 0;
+      starts[s].converged  = false;
+   }
+
+   QtConcurrent::blockingMap( starts, [this]( FitStart &start ){
+      Fit( start );
+   } );
+   if( stateExit )
+      return;
+
+   int best = 0;
+   for( int s = 0; s < starts.size(); s++ ){
+      result.startCost.push_back( starts[s].cost );
+      if( starts[s].cost < starts[best].cost )
+         best = s;
+   }
+   if( !std::isfinite( starts[best].cost ) ){
+      emit failed( tr("Fit stopped: the model can't be integrated from any start point.") );
+      return;
+   }
+
+   result.converged    = starts[best].converged;
+   result.iterations   = starts[best].iterations;
+   result.observations = observations;
+   result.cost         = starts[best].cost;
+   result.rms          = std::sqrt( result.cost / observations );
+   result.names        = settings.names;
+   result.values       = starts[best].values;
+
+   // standard errors, from the covariance s^2 (J^T J)^-1
+   QVector<double> J = Jacobian( result.values, Residual( result.values ) );
+   QVector<double> A( n*n, 0.0 );
+   for( int k = 0; k < observations; k++ )
+      for( int a = 0; a < n; a++ )
+         for( int b = 0; b < n; b++ )
+            A[a*n+b] += J[k*n+a] * J[k*n+b];
+   double variance = observations > n ? result.cost / ( observations - n ) : NAN;
+   result.standardError.fill( NAN, n );
+   for( int j = 0; j < n; j++ ){
+      QVector<double> column( n, 0.0 );
+      column[j] = 1.0;
+      if( SolveLinear( A, column, n ) && column[j] >= 0.0 )
+         result.standardError[j] = std::sqrt( variance * column[j] );
+   }
+}
+
+void ParameterFitter::stop(
+){
+   stateExit = true;
+}
+
+FitResult ParameterFitter::Result(
+){
+   return result;
+}
+
+QString ParameterFitter::Summary(
+){
+   QString text = result.converged ? tr("Fit converged") : tr("Fit not converged");
+   text += tr(" after %1 iterations:").arg( result.iterations );
+   for( int j = 0; j < result.values.size(); j++ )
+      text += QString(" %1 = %2 +/- %3").arg( settings.names[j] ).arg( result.values[j], 0, 'g', 10 ).arg( result.standardError[j], 0, 'g', 3 );
+   text += tr("; RMS residual %1 over %2 observations, best of %3 starts").arg( result.rms ).arg( result.observations ).arg( result.startCost.size() );
+
+   return text;
+}
+
+bool ParameterFitter::Prepare(
+   QString &error
+){
+   if( n == 0 ){
+      error = tr("no free parameters in [fit parameters]");
+      return false;
+   }
+
+   freeIndex.clear();
+   for( int j = 0; j < n; j++ ){
+      int index = -1;
+      for( int i = 0; i < paramRules.size(); i++ )
+         if( paramRules[i].first == settings.names[j] )
+            index = i;
+      if( index < 0 ){
+         error = tr("%1 is not a parameter").arg( settings.names[j] );
+         return false;
+      }
+      if( !( settings.lower[j] < settings.upper[j] ) ){
+         error = tr("the bounds of %1 are empty").arg( settings.names[j] );
+         return false;
+      }
+      freeIndex.push_back( index );
+   }
+
+   return ReadData( error );
+}
+
+bool ParameterFitter::ReadData(
+   QString &error
+){
+   QFile file( settings.dataFile );
+   if( !file.open( QIODevice::ReadOnly | QIODevice::Text ) ){
+      error = tr("can't read %1: %2").arg( settings.dataFile, file.errorString() );
+      return false;
+   }
+
+   // header line names the columns, lines starting with # are comments
+   QTextStream in( &file );
+   QStringList header;
+   int line = 0;
+   while( !in.atEnd() ){
+      QString text = in.readLine().trimmed();
+      line++;
+      if( text.isEmpty() || text.startsWith( '#' ) )
+         continue;
+      QStringList cells = text.split( ',' );
+
+      if( header.isEmpty() ){
+         for( auto cell : cells )
+            header.push_back( cell.trimmed() );
+         if( header[0] != "t" ){
+            error = tr("the first column of %1 must be t").arg( settings.dataFile );
+            return false;
+         }
+         for( int c = 1; c < header.size(); c++ ){
+            int index = -1;
+            for( int i = 0; i < varRules.size(); i++ )
+               if( varRules[i].first == header[c] )
+                  index = i;
+            columnIsParam.push_back( index < 0 );
+            for( int i = 0; index < 0 && i < paramRules.size(); i++ )
+               if( paramRules[i].first == header[c] )
+                  index = i;
+            if( index < 0 ){
+               error = tr("column %1 is not a variable or parameter").arg( header[c] );
+               return false;
+            }
+            columnIndex.push_back( index );
+         }
+         continue;
+      }
+
+      bool ok;
+      double t = cells[0].toDouble( &ok );
+      if( !ok || t < init.T || ( !times.isEmpty() && t < times.last() ) ){
+         error = tr("line %1: times must be numbers increasing from t_init").arg( line );
+         return false;
+      }
+
+      // empty cells are not measured
+      QVector<double> row( header.size() - 1, NAN );
+      for( int c = 1; c < std::min( cells.size(), header.size() ); c++ ){
+         if( cells[c].trimmed().isEmpty() )
+            continue;
+         row[c-1] = cells[c].toDouble( &ok );
+         if( !ok ){
+            error = tr("line %1: \"%2\" is not a number").arg( line ).arg( cells[c].trimmed() );
+            return false;
+         }
+         observations++;
+      }
+      times.push_back( t );
+      measured.push_back( row );
+   }
+
+   if( observations < n ){
+      error = tr("%1 has fewer measurements than free parameters").arg( settings.dataFile );
+      return false;
+   }
+
+   return true;
+}
+
+void ParameterFitter::Fit(
+   FitStart &start
+){
+   QVector<double> values = start.values;
+   QVector<double> residual = Residual( values );
+   double cost = Cost( residual );
+   start.cost = cost;
+   if( !std::isfinite( cost ) )
+      return;
+
+   double lambda = 1e-3;
+   for( int iteration = 0; iteration < settings.iterations && !stateExit; iteration++ ){
+      start.iterations = iteration + 1;
+
+      // normal equations of the linearised problem; a model that can't
+      // be integrated next to the point ends the run unconverged
+      QVector<double> J = Jacobian( values, residual );
+      if( !AllFinite( J ) )
+         break;
+      QVector<double> A( n*n, 0.0 );
+      QVector<double> gradient( n, 0.0 );
+      for( int k = 0; k < residual.size(); k++ ){
+         for( int a = 0; a < n; a++ ){
+            gradient[a] += J[k*n+a] * residual[k];
+            for( int b = 0; b < n; b++ )
+               A[a*n+b] += J[k*n+a] * J[k*n+b];
+         }
+      }
+      double largest = 0.0;
+      for( int a = 0; a < n; a++ )
+         largest = std::max( largest, A[a*n+a] );
+      if( !( largest > 0.0 ) || !std::isfinite( largest ) )
+         break;
+
+      // raise the damping until a step lowers the cost
+      bool improved = false;
+      bool singular = false;
+      QVector<double> trial;
+      QVector<double> trialResidual;
+      double trialCost = cost;
+      while( lambda <= 1e16 && !stateExit ){
+         QVector<double> M( A );
+         for( int a = 0; a < n; a++ )
+            M[a*n+a] += lambda * std::max( A[a*n+a], 1e-12 * largest );
+         QVector<double> step( gradient );
+         for( auto &value : step )
+            value = -value;
+
+         if( SolveLinear( M, step, n ) ){
+            if( !AllFinite( step ) ){
+               singular = true;
+               break;
+            }
+            trial = values;
+            for( int a = 0; a < n; a++ )
+               trial[a] = std::min( std::max( values[a] + step[a], settings.lower[a] ), settings.upper[a] );
+            trialResidual = Residual( trial );
+            trialCost = Cost( trialResidual );
+            if( trialCost < cost ){
+               improved = true;
+               break;
+            }
+         }
+         lambda *= 10.0;
+      }
+
+      if( singular )
+         break;
+
+      // no step lowers the cost, a minimum within the bounds
+      if( !improved ){
+         start.converged = !stateExit;
+         break;
+      }
+
+      double decrease = cost - trialCost;
+      values   = trial;
+      residual = trialResidual;
+      lambda   = std::max( lambda / 10.0, 1e-12 );
+      start.values = values;
+      start.cost   = trialCost;
+      if( decrease <= settings.tolerance * cost ){
+         start.converged = true;
+         break;
+      }
+      cost = trialCost;
+   }
+}
+
+QVector<double> ParameterFitter::Residual(
+   const QVector<double> &values
+){
+   // a private stepper with the free parameters as constants
+   EquationVector rules( paramRules );
+   for( int j = 0; j < n; j++ )
+      rules[freeIndex[j]].second = QString::number( values[j], 'g', 17 );
+
+   Stepper *stepper = CreateStepper( precision, method, solverTolerance );
+   stepper->SetConditions( varRules, rules, init, dt, rateGroups );
+
+   QVector<double> residual;
+   residual.reserve( observations );
+   for( int k = 0; k < times.size() && !stateExit; k++ ){
+      while( stepper->DenseEndTime() < times[k] && !stateExit )
+         stepper->CalculateStep();
+      PointValues model = times[k] == init.T ? stepper->InitialValues() : stepper->DenseOutput( times[k] );
+      for( int c = 0; c < columnIndex.size(); c++ ){
+         if( std::isnan( measured[k][c] ) )
+            continue;
+         const QVector<double> &column = columnIsParam[c] ? model.Param : model.Val;
+         residual.push_back( column.value( columnIndex[c], NAN ) - measured[k][c] );
+      }
+   }
+
+   delete stepper;
+
+   return residual;
+}
+
+QVector<double> ParameterFitter::Jacobian(
+   const QVector<double> &values
+ , const QVector<double> &residual
+){
+   // forward differences, one column per free parameter
+   int m = residual.size();
+   QVector<double> J( m*n, NAN );
+   double *jacobian = J.data();
+   QVector<int> columns( n );
+   for( int j = 0; j < n; j++ )
+      columns[j] = j;
+
+   QtConcurrent::blockingMap( columns, [&]( int &j ){
+      QVector<double> shifted( values );
+      double h = Step( j, values[j] );
+      shifted[j] += h;
+      QVector<double> r = Residual( shifted );
+      for( int k = 0; k < m && k < r.size(); k++ )
+         jacobian[k*n+j] = ( r[k] - residual[k] ) / h;
+   } );
+
+   return J;
+}
+
+double ParameterFitter::Step(
+   int j
+ , double value
+){
+   // difference step on the scale of the value and of the bounds,
+   // taken inwards at the upper bound
+   double h = 1e-7 * std::max( std::abs( value ), settings.upper[j] - settings.lower[j] );
+   return value + h > settings.upper[j] ? -h : h;
+}
+
+bool ParameterFitter::AllFinite(
+   const QVector<double> &values
+){
+   for( auto value : values )
+      if( !std::isfinite( value ) )
+         return false;
+
+   return true;
+}
+
+double ParameterFitter::Cost(
+   const QVector<double> &residual
+){
+   double sum = 0.0;
+   for( auto r : residual )
+      sum += r*r;
+
+   return std::isfinite( sum ) ? sum : std::numeric_limits<double>::infinity();
+}
@@ -0,0 +1,130 @@
+#ifndef PARAMETER_FITTER_HPP
+#define PARAMETER_FITTER_HPP
+
+// Qt headers
+#include <QThread>
+#include <QVector>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrent>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <atomic>
+#include <limits>
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "stepper.hpp"
+#include "dense_linear.hpp"
+#include "philox.hpp"
+
+typedef struct {
+   QString dataFile;         // CSV: t, then observed variables or parameters
+   QStringList names;        // free parameters
+   QVector<double> lower;
+   QVector<double> upper;
+   int     starts;           // multi-start runs
+   int     iterations;       // Levenberg-Marquardt iteration limit
+   double  tolerance;        // relative decrease of the cost that stops a run
+   quint64 seed;             // of the random start points
+} FitSettings;
+
+typedef struct {
+   bool   converged;
+   int    iterations;        // of the best run
+   int    observations;
+   double cost;              // sum of squared residuals
+   double rms;
+   QStringList names;        // of the free parameters
+   QVector<double> values;
+   QVector<double> standardError;
+   QVector<double> startCost;  // final cost of every start
+} FitResult;
+
+// Fits constant parameters of the problem to measured time series by
+// least squares, with the Levenberg-Marquardt method.
+// A free parameter's equation is replaced by its value, and the residuals
+// are the model, at the measured times by dense output, minus the data.
+// The Jacobian is taken by forward differences, its columns integrated
+// concurrently. Steps are clipped to the bounds.
+// The first start is the value in the equations, the others are spread
+// randomly within the bounds, and all starts run concurrently; the best
+// one is the result. Standard errors come from the Jacobian at the best
+// fit, assuming independent errors of equal variance in the data.
+class ParameterFitter : public QThread
+{
+   Q_OBJECT
+
+public:
+   explicit ParameterFitter( DerivationVector ddt_rules
+                           , EquationVector param_rules
+                           , QMap<QString, int> rate_groups
+                           , PointValues initialValues
+                           , double timeSlice
+                           , Precision stepperPrecision
+                           , Method stepperMethod
+                           , double stepperTolerance
+                           , FitSettings fitSettings
+                           , QObject *parent = 0 );
+   void run() Q_DECL_OVERRIDE;
+   void stop();
+
+   FitResult Result();
+   QString Summary();
+
+signals:
+   void failed( QString message );
+
+private:
+   DerivationVector varRules;
+   EquationVector   paramRules;
+   QMap<QString, int> rateGroups;
+   PointValues init;
+   double dt;
+   Precision precision;
+   Method method;
+   double solverTolerance;
+   FitSettings settings;
+   std::atomic<bool> stateExit;
+   FitResult result;
+
+   // free parameter j is paramRules[freeIndex[j]]
+   int n;
+   QVector<int> freeIndex;
+
+   // measurements, one row per time; NAN where a column has no value
+   QVector<double> times;
+   QVector<bool> columnIsParam;
+   QVector<int> columnIndex;
+   QVector<QVector<double>> measured;
+   int observations;
+
+   typedef struct {
+      QVector<double> values;
+      double cost;
+      int iterations;
+      bool converged;
+   } FitStart;
+
+   bool Prepare( QString &error );
+   bool ReadData( QString &error );
+   void Fit( FitStart &start );
+
+   QVector<double> Residual( const QVector<double> &values );
+   QVector<double> Jacobian( const QVector<double> &values
+                           , const QVector<double> &residual );
+   double Step( int j
+              , double value );
+
+   static bool AllFinite( const QVector<double> &values );
+   static double Cost( const QVector<double> &residual );
+};
+
+#endif // PARAMETER_FITTER_HPP
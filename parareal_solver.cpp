@@ -0,0 +1,182 @@
+#include "parareal_solver.hpp"
+
+PararealSolver::PararealSolver(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , QMap<QString, int> rate_groups
+ , PointValues val_init
+ , double fineStep
+ , double coarseStep
+ , double timeEnd
+ , int sliceCount
+){
+   slices  = sliceCount > 0 ? sliceCount : 1;
+   skip    = 0;
+   spacing = 0.0;
+   tInit   = val_init.T;
+   h       = fineStep;
+   hCoarse = coarseStep;
+   correction = 0.0;
+   aborted = false;
+
+   // slices are made of whole fine steps
+   long long steps = std::llround( ( timeEnd - tInit ) / h );
+   if( steps < slices )
+      slices = steps > 0 ? steps : 1;
+   sliceStep.resize( slices + 1 );
+   for( int j = 0; j <= slices; j++ )
+      sliceStep[j] = steps * j / slices;
+
+   // every slice has its own fine stepper, so slices can run concurrently
+   coarse = new RungeKuttaStepper;
+   coarse->SetConditions( ddt_rules, param_rules, val_init, hCoarse, rate_groups );
+   fine.resize( slices );
+   for( int j = 0; j < slices; j++ ){
+      fine[j] = new RungeKuttaStepper;
+      fine[j]->SetConditions( ddt_rules, param_rules, val_init, h, rate_groups );
+   }
+
+   start.resize( slices + 1 );
+   coarseEnd.resize( slices );
+   fineEnd.resize( slices );
+   output.resize( slices );
+   start[0] = coarse->InitialValues();
+}
+
+PararealSolver::~PararealSolver(
+){
+   delete coarse;
+   for( auto stepper : fine ){
+      delete stepper;
+   }
+   fine.clear();
+}
+
+void PararealSolver::SetOutput(
+   int skipSteps
+ , double outputSpacing
+){
+   skip    = skipSteps;
+   spacing = outputSpacing;
+}
+
+int PararealSolver::Solve(
+   int maxIterations
+ , double tolerance
+){
+   // initial serial prediction
+   for( int j = 0; j < slices; j++ ){
+      coarseEnd[j] = Coarse( j, start[j] );
+      start[j+1]   = coarseEnd[j];
+   }
+
+   // slices before `first` start from exact values and are final
+   int first = 0;
+   int iteration = 0;
+   while( iteration < maxIterations && first < slices && !aborted ){
+      iteration++;
+
+      QVector<int> pending;
+      for( int j = first; j < slices; j++ )
+         pending.push_back( j );
+      QtConcurrent::blockingMap( pending, [this]( int &j ){ Fine( j ); } );
+      if( aborted )
+         break;
+
+      // serial correction sweep:
+      // U[j+1] = G( U_new[j] ) + F( U_old[j] ) - G( U_old[j] )
+      correction = 0.0;
+      for( int j = first; j < slices; j++ ){
+         PointValues predicted = Coarse( j, start[j] );
+         PointValues corrected = predicted;
+         for( int i = 0; i < corrected.Val.size(); i++ )
+            corrected.Val[i] += fineEnd[j].Val[i] - coarseEnd[j].Val[i];
+         for( int i = 0; i < corrected.Param.size(); i++ )
+            corrected.Param[i] += fineEnd[j].Param[i] - coarseEnd[j].Param[i];
+
+         for( int i = 0; i < corrected.Val.size(); i++ )
+            correction = std::max( correction, std::abs( corrected.Val[i] - start[j+1].Val[i] ) );
+
+         coarseEnd[j] = predicted;
+         start[j+1]   = corrected;
+      }
+      first++;
+
+      if( correction <= tolerance )
+         break;
+   }
+
+   return iteration;
+}
+
+void PararealSolver::Abort(
+){
+   aborted = true;
+}
+
+double PararealSolver::Correction(
+){
+   return correction;
+}
+
+QVector<PointValues> PararealSolver::Trajectory(
+){
+   // recorded during the last fine sweep of each slice,
+   // so it differs from the corrected solution by at most the tolerance
+   QVector<PointValues> trajectory;
+   for( auto &points : output ){
+      trajectory += points;
+   }
+
+   return trajectory;
+}
+
+PointValues PararealSolver::Coarse(
+   int slice
+ , PointValues val
+){
+   double length = ( sliceStep[slice+1] - sliceStep[slice] ) * h;
+   long long steps = std::max( 1LL, std::llround( length / hCoarse ) );
+
+   coarse->Reset();
+   coarse->SetTimeSlice( length / steps );
+   for( long long n = 0; n < steps; n++ )
+      val = coarse->Step( val );
+
+   val.T = tInit + sliceStep[slice+1] * h;
+   return val;
+}
+
+void PararealSolver::Fine(
+   int slice
+){
+   RungeKuttaStepper *stepper = fine[slice];
+   QVector<PointValues> &points = output[slice];
+   PointValues val = start[slice];
+
+   points.clear();
+   stepper->Reset();
+
+   // output grid points that fall into this slice
+   long long gridIndex = 0;
+   if( spacing > 0 )
+      gridIndex = (long long)std::floor( sliceStep[slice] * h / spacing ) + 1;
+
+   for( long long n = sliceStep[slice]; n < sliceStep[slice+1]; n++ ){
+      val = stepper->Step( val );
+      if( aborted )
+         return;
+
+      if( spacing > 0 ){
+         while( tInit + gridIndex * spacing <= val.T ){
+            points.push_back( stepper->DenseOutput( tInit + gridIndex * spacing ) );
+            gridIndex++;
+         }
+      } else if( ( n + 1 ) % ( skip + 1 ) == 0 ){
+         points.push_back( val );
+      }
+   }
+
+   val.T = tInit + sliceStep[slice+1] * h;
+   fineEnd[slice] = val;
+}
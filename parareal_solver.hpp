@@ -0,0 +1,68 @@
+#ifndef PARAREAL_SOLVER_HPP
+#define PARAREAL_SOLVER_HPP
+
+// Qt headers
+#include <QVector>
+#include <QMap>
+#include <QString>
+#include <QtConcurrent>
+
+// C++ headers
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "runge_kutta_stepper.hpp"
+
+// Parallel-in-time integration of [t_init, t_end].
+// The interval is split into slices. A coarse stepper predicts the slice
+// start values serially, fine steppers integrate all slices concurrently,
+// and the prediction is corrected until the corrections converge.
+class PararealSolver
+{
+public:
+   PararealSolver( DerivationVector ddt_rules
+                 , EquationVector param_rules
+                 , QMap<QString, int> rate_groups
+                 , PointValues val_init
+                 , double fineStep
+                 , double coarseStep
+                 , double timeEnd
+                 , int sliceCount );
+   ~PararealSolver();
+
+   void SetOutput( int skipSteps, double outputSpacing );
+   int  Solve( int maxIterations, double tolerance );
+   void Abort();
+
+   double Correction();
+   QVector<PointValues> Trajectory();
+
+private:
+   int slices;
+   int skip;
+   double spacing;
+   double tInit;
+   double h;
+   double hCoarse;
+   double correction;
+   std::atomic<bool> aborted;
+
+   // first fine step of each slice, slices+1 entries
+   QVector<long long> sliceStep;
+
+   RungeKuttaStepper *coarse = NULL;
+   QVector<RungeKuttaStepper *> fine;
+
+   QVector<PointValues> start;     // corrected slice start values
+   QVector<PointValues> coarseEnd; // coarse propagation of each slice
+   QVector<PointValues> fineEnd;   // fine propagation of each slice
+   QVector<QVector<PointValues>> output;
+
+   PointValues Coarse( int slice, PointValues val );
+   void Fine( int slice );
+};
+
+#endif // PARAREAL_SOLVER_HPP
@@ -0,0 +1,91 @@
+#include "path_history.hpp"
+
+PathHistory::PathHistory(
+   QVector<int> paramIndices
+ , int historyCapacity
+ , bool quantise
+){
+   indices   = paramIndices;
+   capacity  = std::max( 1, historyCapacity );
+   quantised = quantise;
+
+   times.fill( 0.0, capacity );
+   if( quantised )
+      floatColumns.fill( 0.0f, capacity * indices.size() );
+   else
+      columns.fill( 0.0, capacity * indices.size() );
+}
+
+void PathHistory::Append(
+   const PointValues &pv
+){
+   newest = ( newest + 1 ) % capacity;
+   count  = std::min( count + 1, capacity );
+   appended++;
+
+   times[newest] = pv.T;
+   if( quantised ){
+      float *slot = floatColumns.data() + newest;
+      for( int c = 0; c < indices.size(); c++ )
+         slot[c*capacity] = (float)pv.Param[indices[c]];
+   } else {
+      double *slot = columns.data() + newest;
+      for( int c = 0; c < indices.size(); c++ )
+         slot[c*capacity] = pv.Param[indices[c]];
+   }
+}
+
+void PathHistory::Clear(
+){
+   count  = 0;
+   newest = -1;
+   appended = 0;
+   generation++;
+}
+
+int PathHistory::Count(
+) const {
+   return count;
+}
+
+int PathHistory::Generation(
+) const {
+   return generation;
+}
+
+qint64 PathHistory::Serial(
+   int age
+) const {
+   return appended - 1 - age;
+}
+
+const QVector<int> &PathHistory::ParamIndices(
+) const {
+   return indices;
+}
+
+double PathHistory::Time(
+   int age
+) const {
+   return times[Slot( age )];
+}
+
+void PathHistory::Values(
+   int age
+ , double *values
+) const {
+   int slot = Slot( age );
+   if( quantised ){
+      for( int c = 0; c < indices.size(); c++ )
+         values[c] = floatColumns[c*capacity + slot];
+   } else {
+      for( int c = 0; c < indices.size(); c++ )
+         values[c] = columns[c*capacity + slot];
+   }
+}
+
+int PathHistory::Slot(
+   int age
+) const {
+   return ( newest - age + capacity ) % capacity;
+}
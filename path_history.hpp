@@ -0,0 +1,56 @@
+#ifndef PATH_HISTORY_HPP
+#define PATH_HISTORY_HPP
+
+// Qt headers
+#include <QVector>
+
+// C++ headers
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+
+// Recent points of the trajectory, as drawn by the views.
+// Only the time and the parameters listed in paramIndices are kept, one
+// column each in a ring buffer, so memory grows with the number of
+// referenced parameters instead of the width of the model. Parameters
+// can be quantised to float, time always stays double.
+// Ages count back from the newest point, which has age 0. Serials count
+// the points appended since the last Clear(), which starts a new
+// generation, so views can tell which points they haven't seen yet.
+class PathHistory
+{
+public:
+   PathHistory( QVector<int> paramIndices
+              , int capacity
+              , bool quantise );
+
+   void Append( const PointValues &pv );
+   void Clear();
+
+   int Count() const;
+   int Generation() const;
+   qint64 Serial( int age ) const;
+   const QVector<int> &ParamIndices() const;
+   double Time( int age ) const;
+   void Values( int age
+              , double *values ) const;
+
+private:
+   QVector<int> indices;
+   int capacity;
+   int count = 0;
+   int newest = -1;
+   qint64 appended = 0;
+   int generation = 0;
+   bool quantised;
+
+   // column c of slot s is at c*capacity + s
+   QVector<double> times;
+   QVector<double> columns;
+   QVector<float>  floatColumns;
+
+   int Slot( int age ) const;
+};
+
+#endif // PATH_HISTORY_HPP
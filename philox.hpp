@@ -0,0 +1,69 @@
+#ifndef PHILOX_HPP
+#define PHILOX_HPP
+
+// C headers
+#include <cstdint>
+#include <cmath>
+
+// Philox4x32-10 counter-based random numbers (Salmon et al., 2011).
+// The output depends on the key and the counter only, so every path and
+// step has its own noise, the same whichever thread computes it and in
+// whatever order.
+struct Philox4x32 {
+   uint32_t Key[2];
+
+   explicit Philox4x32( uint64_t seed = 0 ){
+      Key[0] = (uint32_t)seed;
+      Key[1] = (uint32_t)( seed >> 32 );
+   }
+
+   inline void Generate( const uint32_t counter[4]
+                       , uint32_t out[4] ) const {
+      uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+      uint32_t k0 = Key[0], k1 = Key[1];
+      for( int round = 0; round < 10; round++ ){
+         uint64_t p0 = (uint64_t)0xD2511F53 * c0;
+         uint64_t p1 = (uint64_t)0xCD9E8D57 * c2;
+         c0 = (uint32_t)( p1 >> 32 ) ^ c1 ^ k0;
+         c2 = (uint32_t)( p0 >> 32 ) ^ c3 ^ k1;
+         c1 = (uint32_t)p1;
+         c3 = (uint32_t)p0;
+         k0 += 0x9E3779B9;
+         k1 += 0xBB67AE85;
+      }
+      out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+   }
+
+   // uniform number in (0, 1), index of stream
+   inline double Uniform( uint32_t stream
+                        , uint64_t index ) const {
+      uint32_t counter[4] = { (uint32_t)index, (uint32_t)( index >> 32 ), stream, 0xFFFFFFFF };
+      uint32_t bits[4];
+      Generate( counter, bits );
+
+      const double scale = 1.0 / 9007199254740992.0;
+      return ( ( ( (uint64_t)bits[0] << 32 | bits[1] ) >> 11 ) + 0.5 ) * scale;
+   }
+
+   // two independent standard normal numbers, pair of step of path
+   inline void Normal( uint32_t path
+                     , uint64_t step
+                     , uint32_t pair
+                     , double &z0
+                     , double &z1 ) const {
+      uint32_t counter[4] = { pair, (uint32_t)step, (uint32_t)( step >> 32 ), path };
+      uint32_t bits[4];
+      Generate( counter, bits );
+
+      // 53 bit uniforms in (0, 1), then Box-Muller
+      const double scale = 1.0 / 9007199254740992.0;
+      double u0 = ( ( ( (uint64_t)bits[0] << 32 | bits[1] ) >> 11 ) + 0.5 ) * scale;
+      double u1 = ( ( ( (uint64_t)bits[2] << 32 | bits[3] ) >> 11 ) + 0.5 ) * scale;
+      double r = std::sqrt( -2.0 * std::log( u0 ) );
+      double angle = 6.283185307179586476925 * u1;
+      z0 = r * std::cos( angle );
+      z1 = r * std::sin( angle );
+   }
+};
+
+#endif // PHILOX_HPP
@@ -36,19 +36,99 @@ PlotWindow::PlotWindow(
    exitAction->setStatusTip( tr("Exit program.") );
    connect( exitAction, &QAction::triggered, this, &PlotWindow::exitProgram );
 
+   exportAction = new QAction( tr("E&xport"), this );
+   exportAction->setShortcut( QKeySequence( Qt::Key_E ) );
+   exportAction->setStatusTip( tr("Render the run offscreen to image files or a raw video stream.") );
+   exportAction->setEnabled( false );
+   connect( exportAction, &QAction::triggered, this, &PlotWindow::exportFrames );
+
+   equilibriumAction = new QAction( tr("E&quilibrium"), this );
+   equilibriumAction->setShortcut( QKeySequence( Qt::Key_Q ) );
+   equilibriumAction->setStatusTip( tr("Find the equilibrium nearest to the current point.") );
+   equilibriumAction->setEnabled( false );
+   connect( equilibriumAction, &QAction::triggered, this, [this](){ findOrbit( OrbitKind::Equilibrium ); } );
+
+   orbitAction = new QAction( tr("&Find orbit"), this );
+   orbitAction->setShortcut( QKeySequence( Qt::Key_F ) );
+   orbitAction->setStatusTip( tr("Find the periodic orbit through the current point.") );
+   orbitAction->setEnabled( false );
+   connect( orbitAction, &QAction::triggered, this, [this](){ findOrbit( OrbitKind::Periodic ); } );
+
+   fitAction = new QAction( tr("Fit to &measurements"), this );
+   fitAction->setShortcut( QKeySequence( Qt::Key_M ) );
+   fitAction->setStatusTip( tr("Fit the parameters listed in [fit parameters] to the measured data.") );
+   fitAction->setEnabled( false );
+   connect( fitAction, &QAction::triggered, this, &PlotWindow::fitParameters );
+
+   replayAction = new QAction( tr("Re&play"), this );
+   replayAction->setShortcut( QKeySequence( Qt::Key_P ) );
+   replayAction->setStatusTip( tr("Replay the recording from the timeline position.") );
+   replayAction->setCheckable( true );
+   connect( replayAction, &QAction::toggled, this, &PlotWindow::toggleReplay );
+
+   liveAction = new QAction( tr("&Live"), this );
+   liveAction->setShortcut( QKeySequence( Qt::Key_L ) );
+   liveAction->setStatusTip( tr("Return to the running simulation.") );
+   connect( liveAction, &QAction::triggered, this, &PlotWindow::goLive );
+
+   // create timeline for recorded runs
+   timelineSlider = new QSlider( Qt::Horizontal );
+   timelineSlider->setRange( 0, TimelineSteps );
+   connect( timelineSlider, &QSlider::sliderMoved, this, [this]( int position ){
+      replaying = true;
+      seekRecording( timelineIndex( position ) );
+   } );
+
+   seekTimeBox = new QDoubleSpinBox;
+   seekTimeBox->setPrefix( "t = " );
+   seekTimeBox->setDecimals( 4 );
+   seekTimeBox->setRange( -1e12, 1e12 );
+   seekTimeBox->setKeyboardTracking( false );
+   connect( seekTimeBox, &QDoubleSpinBox::editingFinished, this, &PlotWindow::seekTime );
+
+   replaySpeedBox = new QDoubleSpinBox;
+   replaySpeedBox->setSuffix( tr(" pts/frame") );
+   replaySpeedBox->setRange( -10000, 10000 );
+   replaySpeedBox->setValue( 1 );
+
+   replayTimer = new QTimer( this );
+   connect( replayTimer, &QTimer::timeout, this, &PlotWindow::replayStep );
+
+   timelineToolBar = new QToolBar( tr("Timeline"), this );
+   timelineToolBar->addAction( liveAction );
+   timelineToolBar->addAction( replayAction );
+   timelineToolBar->addWidget( replaySpeedBox );
+   timelineToolBar->addWidget( timelineSlider );
+   timelineToolBar->addWidget( seekTimeBox );
+   timelineToolBar->setEnabled( false );
+   addToolBar( Qt::BottomToolBarArea, timelineToolBar );
+
    // create dock for labels
    labelDock = new QDockWidget( tr("Labels"), this );
    labelDock->setAllowedAreas( Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea );
    addDockWidget( Qt::RightDockWidgetArea, labelDock );
 
+   // create dock for live editing of equations
+   equationDock = new QDockWidget( tr("Equations"), this );
+   equationDock->setAllowedAreas( Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea );
+   addDockWidget( Qt::LeftDockWidgetArea, equationDock );
+
+   // reload equations when the problem file is saved
+   problemWatcher = new QFileSystemWatcher( this );
+   connect( problemWatcher, &QFileSystemWatcher::fileChanged, this, &PlotWindow::reloadEquations );
 
    // make toolbar
    ui->mainToolBar->addAction( openProblemAction );
    ui->mainToolBar->addAction( closeProblemAction );
    ui->mainToolBar->addSeparator();
    ui->mainToolBar->addAction( runAction );
+   ui->mainToolBar->addAction( exportAction );
+   ui->mainToolBar->addAction( equilibriumAction );
+   ui->mainToolBar->addAction( orbitAction );
+   ui->mainToolBar->addAction( fitAction );
    ui->mainToolBar->addSeparator();
    ui->mainToolBar->addAction( labelDock->toggleViewAction() );
+   ui->mainToolBar->addAction( equationDock->toggleViewAction() );
    ui->mainToolBar->addSeparator();
    ui->mainToolBar->addAction( exitAction );
 
@@ -57,6 +137,8 @@ PlotWindow::PlotWindow(
 
    // register custom types so they can be used in slots/signals
    qRegisterMetaType<PointValues>();
+   qRegisterMetaType<StatisticsVector>();
+   qRegisterMetaType<EnsembleBand>();
 }
 
 PlotWindow::~PlotWindow(
@@ -66,24 +148,197 @@ PlotWindow::~PlotWindow(
    delete ui;
 }
 
+QString PlotWindow::problemName(
+){
+   if( problemFile.isEmpty() )
+      return tr("(no problem)");
+
+   return QFileInfo( problemFile ).completeBaseName();
+}
+
+bool PlotWindow::runRequested(
+){
+   return simulation != NULL && runAction->isChecked();
+}
+
+void PlotWindow::setBackground(
+   bool background
+ , bool keepComputing
+){
+   // background problems yield the cpu to the visible one
+   if( simulation != NULL && simulation->isRunning() )
+      simulation->setPriority( background ? QThread::LowPriority : QThread::NormalPriority );
+
+   bool pause = background && !keepComputing;
+   if( pause != backgroundPaused ){
+      backgroundPaused = pause;
+      if( simulation != NULL && runAction->isChecked() ){
+         if( pause )
+            simulation->suspend();
+         else
+            simulation->resume();
+      }
+   }
+
+   // catch up with the path computed while hidden
+   bool wasRendering = rendering;
+   rendering = !background;
+   if( rendering && !wasRendering && !replaying )
+      showPath();
+}
+
+void PlotWindow::setThreadBudget(
+   int threads
+){
+   // used for derivative evaluation of the next opened problem
+   derivativeThreads = std::max( 1, threads );
+}
+
 void PlotWindow::updateView(
    PointValues newPoint
 ){
 //   qDebug() << "Adding point @ t = " << newPoint.T << " *** " << newPoint.Param;
 
-   pointPath.push_front( newPoint );
-   if( pointPath.size() > plotMaxPathSegments )
-      pointPath.removeLast();
+   if( recording != NULL && !replaying ){
+      timelineSlider->setValue( TimelineSteps );
+   }
+
+   // the live path is ignored while looking at the recording,
+   // late updates after closing are dropped
+   if( replaying || pointPath == NULL )
+      return;
+
+   pointPath->Append( newPoint );
+   latestPoint = newPoint;
+
+   if( rendering )
+      showPath();
+}
+
+void PlotWindow::updateBand(
+   EnsembleBand band
+){
+   // drawn with the next path update
+   if( replaying || pointPath == NULL )
+      return;
 
    for( auto v : views ){
-      v->updateObjects( pointPath, plotMaxPathSegments );
+      v->appendBand( band, plotMaxPathSegments );
+   }
+}
+
+void PlotWindow::showPath(
+){
+   if( pointPath == NULL || pointPath->Count() == 0 )
+      return;
+
+   for( auto v : views ){
+      v->updateObjects( *pointPath, plotMaxPathSegments );
    }
 
    for( auto v : views ){
       v->repaint();
    }
 
-   updateParamLabels( newPoint );
+   updateParamLabels( latestPoint );
+}
+
+void PlotWindow::seekRecording(
+   qint64 index
+){
+   if( recording == NULL )
+      return;
+
+   qint64 count = recording->Count();
+   if( count == 0 )
+      return;
+   index = qBound( (qint64)0, index, count - 1 );
+
+   // rebuild the path ending at the record
+   pointPath->Clear();
+   qint64 first = std::max( (qint64)0, index - plotMaxPathSegments + 1 );
+   for( qint64 i = first; i <= index; i++ ){
+      pointPath->Append( recording->At( i ) );
+   }
+   latestPoint = recording->At( index );
+
+   replayPosition = index;
+   timelineSlider->setValue( timelinePosition( index ) );
+   seekTimeBox->blockSignals( true );
+   seekTimeBox->setValue( latestPoint.T );
+   seekTimeBox->blockSignals( false );
+
+   showPath();
+}
+
+qint64 PlotWindow::timelineIndex(
+   int position
+){
+   if( recording == NULL || recording->Count() < 2 )
+      return 0;
+   return std::llround( (double)position / TimelineSteps * ( recording->Count() - 1 ) );
+}
+
+int PlotWindow::timelinePosition(
+   qint64 index
+){
+   if( recording == NULL || recording->Count() < 2 )
+      return 0;
+   return (int)std::llround( (double)index / ( recording->Count() - 1 ) * TimelineSteps );
+}
+
+void PlotWindow::seekTime(
+){
+   if( recording == NULL )
+      return;
+
+   replaying = true;
+   seekRecording( recording->Seek( seekTimeBox->value() ) );
+}
+
+void PlotWindow::toggleReplay(
+   bool toggled
+){
+   if( toggled ){
+      // from the record looked at, or from the live end
+      if( !replaying && recording != NULL )
+         replayPosition = recording->Count() - 1;
+      replaying = true;
+      replayCarry = 0;
+      replayTimer->start( 1000 / plotMaxFPS );
+   } else {
+      replayTimer->stop();
+   }
+}
+
+void PlotWindow::replayStep(
+){
+   if( recording == NULL )
+      return;
+
+   // whole records per frame, the fraction is carried to the next one
+   replayCarry += replaySpeedBox->value();
+   qint64 advance = (qint64)replayCarry;
+   replayCarry -= advance;
+   replayPosition += advance;
+
+   // stop at either end of the recording
+   if( replayPosition <= 0 || replayPosition >= recording->Count() - 1 ){
+      replayAction->setChecked( false );
+   }
+
+   seekRecording( replayPosition );
+}
+
+void PlotWindow::goLive(
+   bool /* checked */ // unused
+){
+   replayAction->setChecked( false );
+   replaying = false;
+
+   if( recording != NULL ){
+      seekRecording( recording->Count() - 1 );
+   }
 }
 
 void PlotWindow::ThrowError(
@@ -123,10 +378,164 @@ void PlotWindow::inputData(
       initialValues.Val.push_back( tempdbl );
    }
 
+   // noise terms, only if the section is present; variables without
+   // an entry have none
+   stochastic = inputFile->childGroups().contains( SECTION_VAR_DIFF );
+   diffusionRules.clear();
+   if( stochastic ){
+      diffusionRules.resize( varNames.size() );
+      for( int i = 0; i < diffusionRules.size(); i++ ){
+         diffusionRules[i].first  = varNames[i];
+         diffusionRules[i].second = inputFile->value( QString(SECTION_VAR_DIFF) + "/" + varNames[i], "0" ).toString();
+      }
+   }
+
+   // rate groups, only the listed names are slow
+   inputFile->beginGroup( SECTION_RATES );
+   for( auto name : inputFile->childKeys() ){
+      rateGroups[name] = inputFile->value( name, 1 ).toInt();
+   }
+   inputFile->endGroup();
+
    // time
    initialValues.T = readEntry<double>( inputFile, SECTION_TIME, "t_init", 0.0 );
    dt              = readEntry<double>( inputFile, SECTION_TIME, "dt",     0.1 );
 
+   // numeric precision and method, double precision RK4 unless requested
+   precision = Precision::Double;
+   method    = Method::RungeKutta4;
+   tolerance = 1e-15;
+   if( inputFile->childGroups().contains( SECTION_SOLVER ) ){
+      QString precisionName = readEntry<QString>( inputFile, SECTION_SOLVER, "precision", "double" );
+      if( !PrecisionFromName( precisionName, precision ) ){
+         qDebug() << "WARNING: Unknown precision" << precisionName << ", using double.";
+      }
+      QString methodName = readEntry<QString>( inputFile, SECTION_SOLVER, "method", "rk4" );
+      if( !MethodFromName( methodName, method ) ){
+         qDebug() << "WARNING: Unknown method" << methodName << ", using rk4.";
+      }
+      if( method == Method::Taylor ){
+         tolerance = readEntry<double>( inputFile, SECTION_SOLVER, "tolerance", 1e-15 );
+      }
+   }
+
+   // noise needs a stochastic method, and only has one in double
+   bool stochasticMethod = method == Method::EulerMaruyama || method == Method::Milstein;
+   noiseSeed = inputFile->value( QString(SECTION_SOLVER) + "/seed", 0 ).toULongLong();
+   if( stochastic && !stochasticMethod ){
+      if( inputFile->contains( QString(SECTION_SOLVER) + "/method" ) )
+         qDebug() << "WARNING: Noise needs euler-maruyama or milstein, not" << MethodName( method ) << ", using euler-maruyama.";
+      method = Method::EulerMaruyama;
+   }
+   if( stochastic && precision != Precision::Double ){
+      qDebug() << "WARNING: Stochastic methods run in double precision, not" << PrecisionName( precision );
+      precision = Precision::Double;
+   }
+   if( !stochastic && stochasticMethod ){
+      qDebug() << "WARNING: No [variable diffusion], using euler.";
+      method = Method::Euler;
+   }
+   if( !rateGroups.isEmpty() && ( precision != Precision::Double || method == Method::Taylor ) ){
+      qDebug() << "WARNING: Ignoring [" SECTION_RATES "]: they need the double precision Runge-Kutta stepper, not"
+               << PrecisionName( precision ) << MethodName( method );
+      rateGroups.clear();
+   }
+
+   // Monte Carlo ensemble, only if requested
+   ensemblePaths = 0;
+   ensembleQuantiles = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+   if( inputFile->childGroups().contains( SECTION_ENSEMBLE ) ){
+      if( !stochastic )
+         qDebug() << "WARNING: Ignoring [ensemble]: the problem has no [variable diffusion].";
+      else
+         ensemblePaths = readEntry<int>( inputFile, SECTION_ENSEMBLE, "paths", 1000 );
+      if( inputFile->contains( QString(SECTION_ENSEMBLE) + "/quantiles" ) ){
+         ensembleQuantiles.clear();
+         for( auto level : readEntry<QStringList>( inputFile, SECTION_ENSEMBLE, "quantiles", QStringList() ) )
+            ensembleQuantiles.push_back( level.toDouble() );
+      }
+   }
+
+   // parallel-in-time mode, only if requested
+   pararealSlices     = 0;
+   pararealIterations = 0;
+   pararealCoarseDt   = dt;
+   pararealTolerance  = 0.0;
+   pararealTimeEnd    = initialValues.T;
+   if( inputFile->childGroups().contains( SECTION_PARAREAL ) ){
+      pararealSlices     = readEntry<int>(    inputFile, SECTION_PARAREAL, "slices",     QThread::idealThreadCount() );
+      pararealIterations = readEntry<int>(    inputFile, SECTION_PARAREAL, "iterations", 10 );
+      pararealCoarseDt   = readEntry<double>( inputFile, SECTION_PARAREAL, "coarse_dt",  10*dt );
+      pararealTolerance  = readEntry<double>( inputFile, SECTION_PARAREAL, "tolerance",  1e-8 );
+      pararealTimeEnd    = readEntry<double>( inputFile, SECTION_TIME,     "t_end",      initialValues.T + 100*dt );
+   }
+   if( stochastic && pararealSlices > 0 ){
+      qDebug() << "WARNING: Ignoring [parareal]: it can't solve stochastic problems.";
+      pararealSlices = 0;
+   }
+   if( pararealSlices > 0 && precision != Precision::Double ){
+      qDebug() << "WARNING: Ignoring [parareal]: it solves in double precision only, not" << PrecisionName( precision );
+      pararealSlices = 0;
+   }
+
+   // equilibrium and periodic orbit search, the section is optional
+   orbitSettings.segments   = inputFile->value( QString(SECTION_ORBIT) + "/segments",   QThread::idealThreadCount() ).toInt();
+   orbitSettings.iterations = inputFile->value( QString(SECTION_ORBIT) + "/iterations", 50 ).toInt();
+   orbitSettings.tolerance  = inputFile->value( QString(SECTION_ORBIT) + "/tolerance",  1e-9 ).toDouble();
+   orbitSettings.maxPeriod  = inputFile->value( QString(SECTION_ORBIT) + "/max_period", 1000*dt ).toDouble();
+
+   // parameter fitting, only if requested: the data file, and the free
+   // parameters with their lower and upper bounds
+   fitSettings.dataFile   = inputFile->value( QString(SECTION_FIT) + "/data",       QString() ).toString();
+   fitSettings.starts     = inputFile->value( QString(SECTION_FIT) + "/starts",     QThread::idealThreadCount() ).toInt();
+   fitSettings.iterations = inputFile->value( QString(SECTION_FIT) + "/iterations", 100 ).toInt();
+   fitSettings.tolerance  = inputFile->value( QString(SECTION_FIT) + "/tolerance",  1e-10 ).toDouble();
+   fitSettings.seed       = inputFile->value( QString(SECTION_FIT) + "/seed",       0 ).toULongLong();
+   fitSettings.names.clear();
+   fitSettings.lower.clear();
+   fitSettings.upper.clear();
+   inputFile->beginGroup( SECTION_FIT_PARAM );
+   for( auto name : inputFile->childKeys() ){
+      QStringList bounds = inputFile->value( name ).toStringList();
+      if( bounds.size() != 2 ){
+         qDebug() << "WARNING: Ignoring fit parameter" << name << ": bounds must be given as lower, upper.";
+         continue;
+      }
+      fitSettings.names.push_back( name );
+      fitSettings.lower.push_back( bounds[0].toDouble() );
+      fitSettings.upper.push_back( bounds[1].toDouble() );
+   }
+   inputFile->endGroup();
+
+   // recording, only if requested; the file name is optional
+   recordEnabled  = inputFile->childGroups().contains( SECTION_RECORD );
+   recordFile     = inputFile->value( QString(SECTION_RECORD) + "/file", QString() ).toString();
+   recordCompress = inputFile->value( QString(SECTION_RECORD) + "/compress", false ).toBool();
+
+   // streaming, only if requested
+   streamEnabled   = inputFile->childGroups().contains( SECTION_STREAM );
+   streamLocalName = QString();
+   streamTcpPort   = 0;
+   streamStride    = 1;
+   streamBatch     = 64;
+   streamQueue     = 256;
+   if( streamEnabled ){
+      streamLocalName = readEntry<QString>( inputFile, SECTION_STREAM, "local",    "ode-pathtracer" );
+      streamTcpPort   = readEntry<int>(     inputFile, SECTION_STREAM, "tcp_port", 0 );
+      streamStride    = readEntry<int>(     inputFile, SECTION_STREAM, "stride",   1 );
+      streamBatch     = readEntry<int>(     inputFile, SECTION_STREAM, "batch",    64 );
+      streamQueue     = readEntry<int>(     inputFile, SECTION_STREAM, "queue",    256 );
+   }
+
+   // shared memory ring, only if requested
+   sharedEnabled  = inputFile->childGroups().contains( SECTION_SHARED );
+   sharedName     = QString();
+   sharedCapacity = 65536;
+   if( sharedEnabled ){
+      sharedName     = readEntry<QString>( inputFile, SECTION_SHARED, "name",     "/ode-pathtracer" );
+      sharedCapacity = readEntry<int>(     inputFile, SECTION_SHARED, "capacity", 65536 );
+   }
+
    // plot
    int x1 = readEntry<int>( inputFile, SECTION_PLOT, "x1", -10 );
    int y1 = readEntry<int>( inputFile, SECTION_PLOT, "y1", -10 );
@@ -137,7 +546,313 @@ void PlotWindow::inputData(
    plotTransformY  = readEntry<QString>( inputFile, SECTION_PLOT, "y_transform", "y" );
    plotMaxFPS          = readEntry<int>( inputFile, SECTION_PLOT, "max_fps", 60 );
    plotSkip            = readEntry<int>( inputFile, SECTION_PLOT, "frame_skip", 0 );
+   plotOutputSpacing   = readEntry<double>( inputFile, SECTION_PLOT, "output_spacing", 0.0 );
    plotMaxPathSegments = readEntry<int>( inputFile, SECTION_PLOT, "max_segments", 100 );
+   plotLabelFPS        = readEntry<int>( inputFile, SECTION_PLOT, "label_fps", 10 );
+
+   // path history precision, double unless requested
+   QString pathPrecision = inputFile->value( QString(SECTION_PLOT) + "/path_precision", "double" ).toString();
+   plotPathFloat = pathPrecision == "float";
+   if( pathPrecision != "double" && !plotPathFloat ){
+      qDebug() << "WARNING: Unknown path precision" << pathPrecision << ", using double.";
+   }
+
+   // density rendering, trails unless requested
+   QString plotMode = inputFile->value( QString(SECTION_PLOT) + "/mode", "trail" ).toString();
+   plotDensity      = plotMode == "density";
+   plotTone         = ToneMapping::Log;
+   plotGamma        = 2.2;
+   plotDensityWidth = 1024;
+   if( plotMode != "trail" && !plotDensity ){
+      qDebug() << "WARNING: Unknown plot mode" << plotMode << ", using trail.";
+   }
+   if( plotDensity ){
+      QString toneName = readEntry<QString>( inputFile, SECTION_PLOT, "tone", "log" );
+      if( toneName == "gamma" ){
+         plotTone = ToneMapping::Gamma;
+      } else if( toneName != "log" ){
+         qDebug() << "WARNING: Unknown tone mapping" << toneName << ", using log.";
+      }
+      plotGamma        = readEntry<double>( inputFile, SECTION_PLOT, "gamma", 2.2 );
+      plotDensityWidth = readEntry<int>(    inputFile, SECTION_PLOT, "density_width", 1024 );
+      if( !( plotGamma > 0.0 ) || !std::isfinite( plotGamma ) ){
+         qDebug() << "WARNING: Gamma must be positive, not" << plotGamma << ", using 2.2.";
+         plotGamma = 2.2;
+      }
+   }
+}
+
+void PlotWindow::writeProblem(
+   QDataStream &out
+){
+   // must match readProblem()
+   out << paramNames << varNames << labelNames;
+   out << paramRules << varRules << rateGroups;
+   out << initialValues.T << initialValues.Val << dt;
+   out << (qint32)precision << (qint32)method << tolerance;
+   out << stochastic << diffusionRules << noiseSeed;
+   out << ensemblePaths << ensembleQuantiles;
+   out << pararealSlices << pararealIterations << pararealCoarseDt
+       << pararealTolerance << pararealTimeEnd;
+   out << orbitSettings.segments << orbitSettings.iterations
+       << orbitSettings.tolerance << orbitSettings.maxPeriod;
+   out << fitSettings.dataFile << fitSettings.names << fitSettings.lower << fitSettings.upper
+       << fitSettings.starts << fitSettings.iterations << fitSettings.tolerance << fitSettings.seed;
+   out << recordEnabled << recordFile << recordCompress;
+   out << streamEnabled << streamLocalName << streamTcpPort
+       << streamStride << streamBatch << streamQueue;
+   out << sharedEnabled << sharedName << sharedCapacity;
+   out << plotViewport << plotTransformX << plotTransformY;
+   out << plotMaxFPS << plotSkip << plotOutputSpacing << plotMaxPathSegments << plotLabelFPS;
+   out << plotPathFloat;
+   out << plotDensity << (qint32)plotTone << plotGamma << plotDensityWidth;
+}
+
+void PlotWindow::readProblem(
+   QDataStream &in
+){
+   // must match writeProblem()
+   in >> paramNames >> varNames >> labelNames;
+   in >> paramRules >> varRules >> rateGroups;
+   in >> initialValues.T >> initialValues.Val >> dt;
+   qint32 precisionIndex, methodIndex;
+   in >> precisionIndex >> methodIndex >> tolerance;
+   precision = (Precision)precisionIndex;
+   method    = (Method)methodIndex;
+   in >> stochastic >> diffusionRules >> noiseSeed;
+   in >> ensemblePaths >> ensembleQuantiles;
+   in >> pararealSlices >> pararealIterations >> pararealCoarseDt
+      >> pararealTolerance >> pararealTimeEnd;
+   in >> orbitSettings.segments >> orbitSettings.iterations
+      >> orbitSettings.tolerance >> orbitSettings.maxPeriod;
+   in >> fitSettings.dataFile >> fitSettings.names >> fitSettings.lower >> fitSettings.upper
+      >> fitSettings.starts >> fitSettings.iterations >> fitSettings.tolerance >> fitSettings.seed;
+   in >> recordEnabled >> recordFile >> recordCompress;
+   in >> streamEnabled >> streamLocalName >> streamTcpPort
+      >> streamStride >> streamBatch >> streamQueue;
+   in >> sharedEnabled >> sharedName >> sharedCapacity;
+   in >> plotViewport >> plotTransformX >> plotTransformY;
+   in >> plotMaxFPS >> plotSkip >> plotOutputSpacing >> plotMaxPathSegments >> plotLabelFPS;
+   in >> plotPathFloat;
+   qint32 toneIndex;
+   in >> plotDensity >> toneIndex >> plotGamma >> plotDensityWidth;
+   plotTone = (ToneMapping)toneIndex;
+}
+
+void PlotWindow::exportFrames(
+   bool /* checked */ // unused
+){
+   if( exporter != NULL ){
+      ui->statusBar->showMessage( tr("Export already running.") );
+      return;
+   }
+   if( stochastic ){
+      ui->statusBar->showMessage( tr("Stochastic problems can't be exported.") );
+      return;
+   }
+
+   // ask for export settings
+   QDialog dialog( this );
+   dialog.setWindowTitle( tr("Export frames") );
+   QFormLayout *form = new QFormLayout( &dialog );
+
+   QSpinBox *widthBox = new QSpinBox;
+   widthBox->setRange( 16, 16384 );
+   widthBox->setValue( views.isEmpty() ? 1920 : 2*views[0]->width() );
+   QSpinBox *heightBox = new QSpinBox;
+   heightBox->setRange( 16, 16384 );
+   heightBox->setValue( views.isEmpty() ? 1080 : 2*views[0]->height() );
+   QDoubleSpinBox *spacingBox = new QDoubleSpinBox;
+   spacingBox->setDecimals( 6 );
+   spacingBox->setRange( 1e-6, 1e6 );
+   spacingBox->setValue( plotOutputSpacing > 0 ? plotOutputSpacing : dt*(plotSkip+1) );
+   QSpinBox *framesBox = new QSpinBox;
+   framesBox->setRange( 1, 100000000 );
+   framesBox->setValue( 600 );
+   QComboBox *formatBox = new QComboBox;
+   formatBox->addItem( tr("PNG files") );
+   formatBox->addItem( tr("Raw RGB24 stream") );
+   QLineEdit *targetEdit = new QLineEdit( QDir::current().filePath( "frames" ) );
+   targetEdit->setToolTip( tr("Directory for PNG files; file, pipe or - (stdout) for raw frames.") );
+   QDialogButtonBox *buttons = new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel );
+   connect( buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept );
+   connect( buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject );
+
+   form->addRow( tr("Width"),  widthBox );
+   form->addRow( tr("Height"), heightBox );
+   form->addRow( tr("Time per frame"), spacingBox );
+   form->addRow( tr("Frames"), framesBox );
+   form->addRow( tr("Format"), formatBox );
+   form->addRow( tr("Target"), targetEdit );
+   form->addRow( buttons );
+
+   if( dialog.exec() != QDialog::Accepted )
+      return;
+
+   ExportSettings settings;
+   settings.size    = QSize( widthBox->value(), heightBox->value() );
+   settings.spacing = spacingBox->value();
+   settings.frames  = framesBox->value();
+   settings.raw     = formatBox->currentIndex() == 1;
+   settings.target  = targetEdit->text();
+
+   exporter = new FrameExporter( varRules, paramRules, rateGroups, initialValues, dt, precision, method, tolerance
+                               , plotViewport, plotTransformX, plotTransformY, paramNames
+                               , plotMaxPathSegments, settings );
+   connect( exporter, &FrameExporter::progress, this, [this]( int done, int total ){
+      ui->statusBar->showMessage( tr("Exported %1 of %2 frames.").arg( done ).arg( total ) );
+   } );
+   connect( exporter, &FrameExporter::failed, this, [this]( QString message ){
+      ui->statusBar->showMessage( tr("Export failed: %1").arg( message ) );
+   } );
+   // stopExport() may have deleted it already
+   FrameExporter *started = exporter;
+   connect( exporter, &QThread::finished, this, [this, started](){
+      if( exporter == started ){
+         exporter->deleteLater();
+         exporter = NULL;
+      }
+   } );
+   exporter->start();
+
+   ui->statusBar->showMessage( tr("Export started.") );
+}
+
+void PlotWindow::stopExport(
+){
+   if( exporter == NULL )
+      return;
+
+   exporter->stop();
+   exporter->wait();
+   delete exporter;
+   exporter = NULL;
+}
+
+void PlotWindow::findOrbit(
+   OrbitKind kind
+){
+   if( orbitFinder != NULL ){
+      ui->statusBar->showMessage( tr("Search already running.") );
+      return;
+   }
+   if( stochastic ){
+      ui->statusBar->showMessage( tr("Stochastic problems have no equilibria or orbits to find.") );
+      return;
+   }
+   if( ContainsDelayTerms( varRules, paramRules ) ){
+      ui->statusBar->showMessage( tr("Equilibria and orbits can't be searched with delay terms.") );
+      return;
+   }
+
+   // seeded from the newest point of the path
+   PointValues seed = latestPoint.Val.isEmpty() ? initialValues : latestPoint;
+   orbitFinder = new OrbitFinder( varRules, paramRules, dt, kind, seed, orbitSettings );
+   connect( orbitFinder, &OrbitFinder::failed, this, [this]( QString message ){
+      ui->statusBar->showMessage( message );
+   } );
+   OrbitFinder *started = orbitFinder;
+   connect( orbitFinder, &QThread::finished, this, [this, started](){
+      if( orbitFinder != started )
+         return;
+
+      OrbitResult result = orbitFinder->Result();
+      if( !result.orbit.isEmpty() ){
+         for( auto v : views ){
+            v->setOverlay( result.orbit, result.kind == OrbitKind::Periodic );
+         }
+         QString summary = OrbitFinder::Summary( result );
+         ui->statusBar->showMessage( summary );
+      }
+      orbitFinder->deleteLater();
+      orbitFinder = NULL;
+   } );
+   orbitFinder->start();
+
+   ui->statusBar->showMessage( kind == OrbitKind::Equilibrium ? tr("Searching for an equilibrium...")
+                                                              : tr("Searching for a periodic orbit...") );
+}
+
+void PlotWindow::stopOrbitSearch(
+){
+   if( orbitFinder == NULL )
+      return;
+
+   orbitFinder->stop();
+   orbitFinder->wait();
+   delete orbitFinder;
+   orbitFinder = NULL;
+}
+
+void PlotWindow::fitParameters(
+){
+   if( fitter != NULL ){
+      ui->statusBar->showMessage( tr("Fit already running.") );
+      return;
+   }
+   if( stochastic ){
+      ui->statusBar->showMessage( tr("Stochastic problems can't be fitted.") );
+      return;
+   }
+   if( fitSettings.names.isEmpty() || fitSettings.dataFile.isEmpty() ){
+      ui->statusBar->showMessage( tr("Nothing to fit: the problem needs [fit] data and [fit parameters].") );
+      return;
+   }
+
+   // the data file is relative to the problem file
+   FitSettings settings = fitSettings;
+   settings.dataFile = QFileInfo( problemFile ).absoluteDir().absoluteFilePath( fitSettings.dataFile );
+
+   fitter = new ParameterFitter( varRules, paramRules, rateGroups, initialValues, dt
+                               , precision, method, tolerance, settings );
+   connect( fitter, &ParameterFitter::failed, this, [this]( QString message ){
+      ui->statusBar->showMessage( message );
+   } );
+   ParameterFitter *started = fitter;
+   connect( fitter, &QThread::finished, this, [this, started](){
+      if( fitter != started )
+         return;
+
+      // the fitter is gone before the question, the problem may change
+      // or close while it is open
+      FitResult result = fitter->Result();
+      QString summary = fitter->Summary();
+      fitter->deleteLater();
+      fitter = NULL;
+      if( result.values.isEmpty() )
+         return;
+
+      ui->statusBar->showMessage( summary );
+      if( QMessageBox::question( this, tr("Fit to measurements"),
+                                 summary + "\n\n" + tr("Apply the fitted values to the equations?") ) != QMessageBox::Yes )
+         return;
+      if( stepper == NULL )
+         return;
+
+      // only the fitted parameters change, in the equations as they are now
+      EquationVector newParamRules( paramRules );
+      for( int j = 0; j < result.names.size(); j++ ){
+         for( int i = 0; i < newParamRules.size(); i++ ){
+            if( newParamRules[i].first == result.names[j] )
+               newParamRules[i].second = QString::number( result.values[j], 'g', 17 );
+         }
+      }
+      applyEquations( varRules, newParamRules );
+   } );
+   fitter->start();
+
+   ui->statusBar->showMessage( tr("Fitting %1 parameters with %2 starts...").arg( settings.names.size() ).arg( settings.starts ) );
+}
+
+void PlotWindow::stopFit(
+){
+   if( fitter == NULL )
+      return;
+
+   fitter->stop();
+   fitter->wait();
+   delete fitter;
+   fitter = NULL;
 }
 
 QStringList PlotWindow::tokenizeString(
@@ -158,7 +873,8 @@ void PlotWindow::toggleSimulationRun(
    }
    if( toggled ){
       //qDebug() << "::ON";
-      simulation->resume();
+      if( !backgroundPaused )
+         simulation->resume();
    } else {
       //qDebug() << "::OFF";
       simulation->suspend();
@@ -177,8 +893,8 @@ void PlotWindow::exitProgram(
       // cancel
       return;
    } else {
-      // exit
-      this->close();
+      // exit, closing the workspace if embedded in one
+      window()->close();
    }
 }
 
@@ -194,6 +910,10 @@ void PlotWindow::openProblem(
       loadProblem( file );
 
       closeProblemAction->setEnabled( true );
+      exportAction->setEnabled( true );
+      equilibriumAction->setEnabled( true );
+      orbitAction->setEnabled( true );
+      fitAction->setEnabled( true );
       runAction->setChecked( false );
       runAction->setEnabled( true );
    }
@@ -205,8 +925,28 @@ void PlotWindow::loadProblem(
    // close problem if one is already opened
    closeProblem();
 
-   // load input file
-   inputData( filename );
+   QElapsedTimer loadTimer;
+   loadTimer.start();
+
+   // load input file, or its analysed form if it was opened before
+   ProblemCache cache( filename );
+   bool cached = cache.Open();
+   if( cached ){
+      QDataStream &reader = cache.Reader();
+      readProblem( reader );
+      // a truncated or damaged bundle is analysed again and replaced
+      if( reader.status() != QDataStream::Ok || !reader.atEnd() ){
+         qDebug() << "WARNING: Ignoring damaged problem cache for" << filename;
+         cached = false;
+         rateGroups.clear();
+         initialValues.Val.clear();
+      }
+   }
+   if( !cached ){
+      inputData( filename );
+      writeProblem( cache.Writer() );
+      cache.Store();
+   }
 
    // create render surface(s)
    views.push_back( new RenderView( plotViewport, plotTransformX, plotTransformY, paramNames ) );
@@ -214,6 +954,10 @@ void PlotWindow::loadProblem(
    // add render surfaces to main window
    mainLayout->addWidget( views[0], 0, 0 );
 
+   // path history, with only the parameters the views draw
+   QVector<int> pathParams = CoordinateTransform( plotTransformX, plotTransformY, paramNames ).UsedParams();
+   pointPath = new PathHistory( pathParams, plotMaxPathSegments, plotPathFloat );
+
    // set dock widget for labels
    dockWidget = new LabelDockWidget( paramNames, labelDock );
    connect( this, &PlotWindow::updateParamLabels, dockWidget, &LabelDockWidget::updateParamLabels );
@@ -224,21 +968,99 @@ void PlotWindow::loadProblem(
    for( auto name : labelNames ){
       dockWidget->addParamLabel( name );
    }
+   dockWidget->setRefreshRate( plotLabelFPS );
+
+   // set dock widget for equations, and watch the file for edits
+   equationWidget = new EquationDockWidget( varRules, paramRules, equationDock );
+   connect( equationWidget, &EquationDockWidget::equationsEdited, this, &PlotWindow::applyEquations );
+   equationDock->setWidget( equationWidget );
+   problemFile = filename;
+   problemWatcher->addPath( filename );
 
    // update window title
    setWindowTitle( filename + tr(" - ODE PathTracer") );
 
    // prepare stepper
-   stepper = new RungeKuttaStepper;
-   stepper->SetConditions( varRules, paramRules, initialValues, dt );
+   if( stochastic )
+      stepper = new SdeStepper( method, diffusionRules, noiseSeed );
+   else
+      stepper = CreateStepper( precision, method, tolerance );
+   stepper->SetConditions( varRules, paramRules, initialValues, dt, rateGroups );
+   if( pararealSlices == 0 )
+      stepper->EnableParallelDerivatives( derivativeThreads );
 
    // start simulation
-   simulation = new SimulationLoop( plotMaxFPS, plotSkip, stepper );
+   simulation = new SimulationLoop( plotMaxFPS, plotSkip, plotOutputSpacing, stepper );
    connect( simulation, &SimulationLoop::updateView, this, &PlotWindow::updateView );
+   connect( simulation, &SimulationLoop::updateStatistics, dockWidget, &LabelDockWidget::updateStatistics );
+   simulation->setStatistics( dockWidget->statisticsIndices(), plotLabelFPS );
+   connect( simulation, &SimulationLoop::statusMessage, ui->statusBar, [this]( QString message ){
+      ui->statusBar->showMessage( message );
+   } );
+   if( ensemblePaths > 0 ){
+      ensemble = new EnsembleSolver( varRules, paramRules, diffusionRules, initialValues, dt, method, noiseSeed
+                                   , ensemblePaths, plotTransformX, plotTransformY, paramNames, ensembleQuantiles );
+      ensemble->SetOutput( plotSkip, plotOutputSpacing );
+      simulation->setEnsemble( ensemble );
+      connect( simulation, &SimulationLoop::updateBand, this, &PlotWindow::updateBand );
+   } else if( pararealSlices > 0 ){
+      if( method != Method::RungeKutta4 )
+         qDebug() << "WARNING: Parareal solves with rk4, not" << MethodName( method );
+      if( ContainsDelayTerms( varRules, paramRules ) )
+         qDebug() << "WARNING: Parareal slices don't see the past of earlier slices, delay terms will be wrong.";
+      parareal = new PararealSolver( varRules, paramRules, rateGroups, initialValues
+                                   , dt, pararealCoarseDt, pararealTimeEnd, pararealSlices );
+      parareal->SetOutput( plotSkip, plotOutputSpacing );
+      simulation->setParareal( parareal, pararealIterations, pararealTolerance );
+   }
+   if( recordEnabled ){
+      // relative to the problem file, named after it by default
+      QFileInfo iniInfo( filename );
+      QString recordPath = recordFile.isEmpty() ? iniInfo.completeBaseName() + ".trajectory" : recordFile;
+      recordPath = iniInfo.absoluteDir().absoluteFilePath( recordPath );
+
+      recording = new TrajectoryStore( recordPath, varRules.size(), paramRules.size(), recordCompress );
+      if( recording->IsOpen() ){
+         simulation->setRecorder( recording );
+         timelineToolBar->setEnabled( true );
+      } else {
+         delete recording;
+         recording = NULL;
+      }
+   }
+   if( streamEnabled ){
+      publisher = new TrajectoryPublisher( varNames, paramNames, streamLocalName, streamTcpPort
+                                         , streamStride, streamBatch, streamQueue );
+      publisher->start();
+      simulation->setPublisher( publisher );
+   }
+   if( sharedEnabled ){
+      sharedRing = new SharedMemoryRing( sharedName, varNames, paramNames, sharedCapacity );
+      if( sharedRing->IsOpen() ){
+         simulation->setSharedRing( sharedRing );
+      } else {
+         delete sharedRing;
+         sharedRing = NULL;
+      }
+   }
+   if( plotDensity ){
+      // square bins, as many columns as requested
+      int densityHeight = std::max( 1, (int)std::lround( (double)plotDensityWidth * plotViewport.height() / plotViewport.width() ) );
+      density = new DensityHistogram( plotViewport, plotDensityWidth, densityHeight );
+      densityAccumulator = new DensityHistogram::Accumulator( density, plotTransformX, plotTransformY, paramNames );
+      simulation->setDensity( densityAccumulator );
+      for( auto v : views ){
+         v->setDensity( density, plotTone, plotGamma );
+      }
+   }
    simulation->suspend();
    simulation->start();
 
-   ui->statusBar->showMessage( tr("Problem opened.") );
+   if( cached ){
+      ui->statusBar->showMessage( tr("Problem opened from cache in %1 ms.").arg( loadTimer.elapsed() ) );
+   } else {
+      ui->statusBar->showMessage( tr("Problem opened in %1 ms.").arg( loadTimer.elapsed() ) );
+   }
 }
 
 void PlotWindow::closeProblem(
@@ -246,10 +1068,22 @@ void PlotWindow::closeProblem(
 ){
    // update gui elements
    closeProblemAction->setEnabled( false );
+   exportAction->setEnabled( false );
+   equilibriumAction->setEnabled( false );
+   orbitAction->setEnabled( false );
+   fitAction->setEnabled( false );
    runAction->setChecked( false );
    runAction->setEnabled( false );
 
-   // end simulation
+   // end export, searches and simulation
+   stopExport();
+   stopOrbitSearch();
+   stopFit();
+   if( publisher != NULL ){
+      // a producer blocked on a full client queue must not hold the
+      // simulation thread
+      publisher->stop();
+   }
    if( simulation != NULL ){
       simulation->stop();
       ui->statusBar->showMessage( tr("Waiting for threads to stop...") );
@@ -261,6 +1095,36 @@ void PlotWindow::closeProblem(
       delete simulation;
       simulation = NULL;
    }
+   if( parareal != NULL ){
+      delete parareal;
+      parareal = NULL;
+   }
+   if( ensemble != NULL ){
+      delete ensemble;
+      ensemble = NULL;
+   }
+   if( publisher != NULL ){
+      // the simulation has ended, so its last partial batch can go out
+      publisher->FlushBatch();
+      delete publisher;
+      publisher = NULL;
+   }
+   if( sharedRing != NULL ){
+      delete sharedRing;
+      sharedRing = NULL;
+   }
+   if( densityAccumulator != NULL ){
+      delete densityAccumulator;
+      densityAccumulator = NULL;
+   }
+   replayAction->setChecked( false );
+   replaying = false;
+   timelineToolBar->setEnabled( false );
+   timelineSlider->setValue( 0 );
+   if( recording != NULL ){
+      delete recording;
+      recording = NULL;
+   }
    if( stepper != NULL ){
       delete stepper;
       stepper = NULL;
@@ -270,13 +1134,27 @@ void PlotWindow::closeProblem(
       delete v;
    }
    views.clear();
+   if( density != NULL ){
+      delete density;
+      density = NULL;
+   }
 
    if( dockWidget != NULL ){
       delete dockWidget;
       dockWidget = NULL;
    }
+   if( equationWidget != NULL ){
+      delete equationWidget;
+      equationWidget = NULL;
+   }
+   if( !problemWatcher->files().isEmpty() )
+      problemWatcher->removePaths( problemWatcher->files() );
+   problemFile.clear();
 
-   pointPath.clear();
+   if( pointPath != NULL ){
+      delete pointPath;
+      pointPath = NULL;
+   }
 
    paramNames.clear();
    varNames.clear();
@@ -284,6 +1162,8 @@ void PlotWindow::closeProblem(
 
    paramRules.clear();
    varRules.clear();
+   rateGroups.clear();
+   diffusionRules.clear();
 
    initialValues.Param.clear();
    initialValues.Val.clear();
@@ -293,3 +1173,63 @@ void PlotWindow::closeProblem(
 
    ui->statusBar->showMessage( tr("Problem closed.") );
 }
+
+void PlotWindow::applyEquations(
+   DerivationVector newVarRules
+ , EquationVector newParamRules
+){
+   if( stepper == NULL )
+      return;
+   if( parareal != NULL ){
+      ui->statusBar->showMessage( tr("Equations can't be edited in parareal mode.") );
+      return;
+   }
+
+   // the stepper swaps them in at its next step; state and path are kept
+   QElapsedTimer editTimer;
+   editTimer.start();
+   QString error;
+   if( !stepper->UpdateEquations( newVarRules, newParamRules, error ) ){
+      ui->statusBar->showMessage( tr("Equations not applied: %1.").arg( error ) );
+      return;
+   }
+
+   varRules   = newVarRules;
+   paramRules = newParamRules;
+   equationWidget->setEquations( varRules, paramRules );
+   if( density != NULL )
+      density->Clear();
+   ui->statusBar->showMessage( tr("Equations updated in %1 ms.").arg( editTimer.elapsed() ) );
+}
+
+void PlotWindow::reloadEquations(
+   const QString filename
+){
+   // editors often save by replacing the file, which ends the watch
+   if( !problemWatcher->files().contains( filename ) && QFileInfo::exists( filename ) )
+      problemWatcher->addPath( filename );
+   if( stepper == NULL || filename != problemFile )
+      return;
+
+   QSettings inputFile( filename, QSettings::IniFormat );
+
+   // only equations are reloaded; anything else needs the problem reopened
+   QStringList newParamNames = readEntry<QStringList>( &inputFile, SECTION_NAMES, "parameter_names", QStringList() );
+   QStringList newVarNames   = readEntry<QStringList>( &inputFile, SECTION_NAMES, "variable_names",  QStringList() );
+   if( newParamNames != paramNames || newVarNames != varNames ){
+      ui->statusBar->showMessage( tr("Names changed in the problem file; reopen it to apply.") );
+      return;
+   }
+
+   EquationVector newParamRules( paramRules );
+   for( int i = 0; i < newParamRules.size(); i++ )
+      newParamRules[i].second = readEntry<QString>( &inputFile, SECTION_PARAM_EQ, paramNames[i], "0" );
+   DerivationVector newVarRules( varRules );
+   for( int i = 0; i < newVarRules.size(); i++ )
+      newVarRules[i].second = readEntry<QString>( &inputFile, SECTION_VAR_DERIV, varNames[i], "0" );
+
+   if( newVarRules == varRules && newParamRules == paramRules )
+      return;
+
+   applyEquations( newVarRules, newParamRules );
+}
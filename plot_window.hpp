@@ -9,6 +9,21 @@
 #include <QDockWidget>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QElapsedTimer>
+#include <QToolBar>
+#include <QSlider>
+#include <QDoubleSpinBox>
+#include <QLabel>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QSpinBox>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QFileSystemWatcher>
 #include <QtDebug>
 //#include <QtWidgets>
 
@@ -18,6 +33,8 @@
 // C++ headers
 #include <iostream>
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
 
 // Boost headers
 //#include <boost/property_tree/ptree.hpp>
@@ -26,10 +43,22 @@
 
 // Local headers
 #include "ode_pathtracer.hpp"
-#include "runge_kutta_stepper.hpp"
+#include "stepper.hpp"
 #include "render_view.hpp"
 #include "simulation_loop.hpp"
 #include "label_dock_widget.hpp"
+#include "equation_dock_widget.hpp"
+#include "trajectory_store.hpp"
+#include "problem_cache.hpp"
+#include "frame_exporter.hpp"
+#include "trajectory_publisher.hpp"
+#include "shared_memory_ring.hpp"
+#include "path_history.hpp"
+#include "delay_history.hpp"
+#include "sde_stepper.hpp"
+#include "ensemble_solver.hpp"
+#include "orbit_finder.hpp"
+#include "parameter_fitter.hpp"
 
 // OUT and IN can be redefined as a filestream
 // to enable direct file input/output
@@ -46,14 +75,6 @@
 #define LF  std::endl
 #define ABS std::abs
 
-// Ini file sections
-#define SECTION_NAMES     "names"
-#define SECTION_PARAM_EQ  "parameter equations"
-#define SECTION_VAR_DERIV "variable derivations"
-#define SECTION_VAR_INIT  "variable initial"
-#define SECTION_TIME      "time"
-#define SECTION_PLOT      "plot"
-
 namespace Ui {
 class PlotWindow;
 }
@@ -66,35 +87,99 @@ public:
    explicit PlotWindow( QWidget *parent = 0 );
    ~PlotWindow();
 
+   // workspace scheduling
+   QString problemName();
+   bool runRequested();
+   void setBackground( bool background
+                     , bool keepComputing );
+   void setThreadBudget( int threads );
+
 signals:
    void updateParamLabels( PointValues values );
 
 public slots:
    void updateView( PointValues newPoint );
+   void updateBand( EnsembleBand band );
 
 private:
    Ui::PlotWindow *ui;
 
    // simulation objects
-   RungeKuttaStepper *stepper = NULL;
+   Stepper           *stepper = NULL;
    SimulationLoop    *simulation = NULL;
-   QList<PointValues> pointPath;
+   PararealSolver    *parareal = NULL;
+   EnsembleSolver    *ensemble = NULL;
+   FrameExporter     *exporter = NULL;
+   OrbitFinder       *orbitFinder = NULL;
+   ParameterFitter   *fitter = NULL;
+   TrajectoryPublisher *publisher = NULL;
+   SharedMemoryRing  *sharedRing = NULL;
+   DensityHistogram  *density = NULL;
+   DensityHistogram::Accumulator *densityAccumulator = NULL;
+   PathHistory       *pointPath = NULL;
+   PointValues        latestPoint;
+
+   // background tabs skip rendering, and may be paused
+   bool rendering = true;
+   bool backgroundPaused = false;
+   int  derivativeThreads = QThread::idealThreadCount();
+
+   // recording and replay
+   TrajectoryStore *recording = NULL;
+   bool    recordEnabled = false;
+   QString recordFile;
+   bool    recordCompress = false;
+
+   // streaming to external consumers
+   bool    streamEnabled = false;
+   QString streamLocalName;
+   int     streamTcpPort;
+   int     streamStride;
+   int     streamBatch;
+   int     streamQueue;
+
+   // shared memory ring for local consumers
+   bool    sharedEnabled = false;
+   QString sharedName;
+   int     sharedCapacity;
+   bool    replaying = false;
+   qint64  replayPosition = 0;
+   double  replayCarry = 0;      // records short of a whole step
+   // the slider covers the recording in fixed steps, it can't count records
+   static const int TimelineSteps = 10000;
 
    // actions
    QAction *runAction;
    QAction *exitAction;
    QAction *openProblemAction;
    QAction *closeProblemAction;
+   QAction *exportAction;
+   QAction *equilibriumAction;
+   QAction *orbitAction;
+   QAction *fitAction;
+   QAction *replayAction;
+   QAction *liveAction;
 
    // gui elements
    QGridLayout *mainLayout = NULL;
    QDockWidget *labelDock = NULL;
+   QDockWidget *equationDock = NULL;
    QList<RenderView *> views;
+   QToolBar *timelineToolBar = NULL;
+   QSlider  *timelineSlider = NULL;
+   QDoubleSpinBox *seekTimeBox = NULL;
+   QDoubleSpinBox *replaySpeedBox = NULL;
+   QTimer   *replayTimer = NULL;
 
    // Labels
    QStringList labelNames;
    LabelDockWidget *dockWidget = NULL;
 
+   // Live editing
+   EquationDockWidget *equationWidget = NULL;
+   QFileSystemWatcher *problemWatcher = NULL;
+   QString problemFile;
+
    // Names
    QStringList paramNames;
    QStringList varNames;
@@ -103,28 +188,86 @@ private:
    EquationVector   paramRules;
    DerivationVector varRules;
 
+   // Rate groups (name -> steps per update)
+   QMap<QString, int> rateGroups;
+
    // Initial values
    PointValues initialValues;
 
    // Time parameters
    double dt;
 
+   // Solver parameters
+   Precision precision = Precision::Double;
+   Method method = Method::RungeKutta4;
+   double tolerance = 1e-15;
+
+   // Noise, if [variable diffusion] is present
+   bool stochastic = false;
+   DerivationVector diffusionRules;
+   quint64 noiseSeed = 0;
+
+   // Monte Carlo ensemble parameters (paths = 0 disables)
+   int ensemblePaths = 0;
+   QVector<double> ensembleQuantiles;
+
+   // Parareal parameters (slices = 0 disables)
+   int    pararealSlices;
+   int    pararealIterations;
+   double pararealCoarseDt;
+   double pararealTolerance;
+   double pararealTimeEnd;
+
+   // Equilibrium and periodic orbit search
+   OrbitSettings orbitSettings;
+
+   // Parameter fitting to measured data
+   FitSettings fitSettings;
+
    // Plot parameters
    QString plotTransformX;
    QString plotTransformY;
    QRect   plotViewport;
    int plotMaxFPS;
    int plotSkip;
+   double plotOutputSpacing;
    int plotMaxPathSegments;
+   int plotLabelFPS;
+   bool plotPathFloat = false;
+
+   // Density rendering (mode = density)
+   bool plotDensity = false;
+   ToneMapping plotTone = ToneMapping::Log;
+   double plotGamma;
+   int plotDensityWidth;
 
    void ThrowError( QString msg );
    void inputData( const QString filename );
+   void writeProblem( QDataStream &out );
+   void readProblem( QDataStream &in );
    QStringList tokenizeString( QString &str );
    void toggleSimulationRun( bool toggled );
    void exitProgram( bool checked = false );
    void openProblem( bool checked = false );
    void loadProblem( const QString filename );
    void closeProblem( bool checked = false );
+   void showPath();
+   void seekRecording( qint64 index );
+   qint64 timelineIndex( int position );
+   int timelinePosition( qint64 index );
+   void seekTime();
+   void toggleReplay( bool toggled );
+   void replayStep();
+   void goLive( bool checked = false );
+   void exportFrames( bool checked = false );
+   void stopExport();
+   void findOrbit( OrbitKind kind );
+   void stopOrbitSearch();
+   void fitParameters();
+   void stopFit();
+   void applyEquations( DerivationVector newVarRules
+                      , EquationVector newParamRules );
+   void reloadEquations( const QString filename );
 
    template <class T> T readEntry(
       QSettings *inputFile
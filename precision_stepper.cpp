@@ -0,0 +1,388 @@
+#include "precision_stepper.hpp"
+
+// Local headers
+#include "double_double.hpp"
+
+template <typename Scalar>
+PrecisionStepper<Scalar>::PrecisionStepper(
+   Method method
+ , int seriesLength
+){
+   switch( method ){
+   case Method::Euler:        UseTableau<EulerTableau>();        break;
+   case Method::Heun:         UseTableau<HeunTableau>();         break;
+   case Method::RungeKutta3:  UseTableau<RungeKutta3Tableau>();  break;
+   case Method::RungeKutta38: UseTableau<RungeKutta38Tableau>(); break;
+   case Method::RungeKutta6:  UseTableau<RungeKutta6Tableau>();  break;
+   case Method::RungeKutta4:
+   default:                   UseTableau<RungeKutta4Tableau>();  break;
+   }
+
+   stride = seriesLength;
+   tInit  = Scalar( 0 );
+   h      = Scalar( 0 );
+   stateT = Scalar( 0 );
+}
+
+template <typename Scalar>
+void PrecisionStepper<Scalar>::SetConditions(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , PointValues val_init
+ , double timeSlice
+ , QMap<QString, int> rate_groups
+){
+   if( !rate_groups.isEmpty() )
+      std::cerr << "Ignoring rate groups: only the double precision Runge-Kutta stepper supports them." << std::endl;
+   if( ContainsDelayTerms( ddt_rules, param_rules ) ){
+      std::cerr << "Delay terms x(t - lag) need the double precision Runge-Kutta stepper." << std::endl;
+      exit( EXIT_FAILURE );
+   }
+
+   varCount   = ddt_rules.size();
+   paramCount = param_rules.size();
+
+   // symbol addresses stay fixed from here on
+   symbolValues.assign( ( 1 + varCount + paramCount ) * stride, Scalar( 0 ) );
+   symbols.Clear();
+   symbols.Define( "t", TimeSymbol() );
+   for( int j = 0; j < varCount; j++ )
+      symbols.Define( ddt_rules[j].first.toStdString(), VarSymbol( j ) );
+   for( int j = 0; j < paramCount; j++ )
+      symbols.Define( param_rules[j].first.toStdString(), ParamSymbol( j ) );
+
+   // compile expressions
+   varExpr.resize( varCount );
+   paramExpr.resize( paramCount );
+   try {
+      for( int i = 0; i < varCount; i++ ){
+         varExpr[i].SetSymbols( &symbols );
+         varExpr[i].SetExpr( ddt_rules[i].second.toStdString() );
+      }
+      for( int i = 0; i < paramCount; i++ ){
+         paramExpr[i].SetSymbols( &symbols );
+         paramExpr[i].SetExpr( param_rules[i].second.toStdString() );
+      }
+   } catch( ExpressionError &e ){
+      ParserError( e );
+   }
+
+   {
+      QMutexLocker lock( &pendingMutex );
+      varRules   = ddt_rules;
+      paramRules = param_rules;
+      pendingVarExpr.clear();
+      pendingParamExpr.clear();
+      pendingEquations = false;
+   }
+
+   // initial state
+   tInit = Scalar( val_init.T );
+   h     = Scalar( timeSlice );
+   steps = 0;
+   stateT = tInit;
+   stateVal.resize( varCount );
+   for( int i = 0; i < varCount; i++ )
+      stateVal[i] = Scalar( val_init.Val[i] );
+   LoadPoint( tInit, stateVal.data() );
+   stateParam = CurrentParams();
+   denseValid = false;
+
+   init = ToPoint( tInit, stateVal, stateParam );
+}
+
+template <typename Scalar>
+PointValues PrecisionStepper<Scalar>::CalculateStep(
+){
+   if( pendingEquations.load( std::memory_order_acquire ) )
+      ApplyPendingEquations();
+
+   Step();
+
+   return ToPoint( denseT1, stateVal, stateParam );
+}
+
+template <typename Scalar>
+PointValues PrecisionStepper<Scalar>::InitialValues(
+){
+   return init;
+}
+
+template <typename Scalar>
+double PrecisionStepper<Scalar>::DenseStartTime(
+){
+   return denseValid ? static_cast<double>( denseT0 ) : init.T;
+}
+
+template <typename Scalar>
+double PrecisionStepper<Scalar>::DenseEndTime(
+){
+   return denseValid ? static_cast<double>( denseT1 ) : init.T;
+}
+
+template <typename Scalar>
+PointValues PrecisionStepper<Scalar>::DenseOutput(
+   double t_out
+){
+   if( !denseValid )
+      return init;
+
+   // cubic Hermite interpolation over the last step
+   Scalar time  = Scalar( t_out );
+   Scalar H     = denseT1 - denseT0;
+   Scalar theta = ( time - denseT0 ) / H;
+   Scalar a     = Scalar( 1 ) - theta;
+   Scalar one( 1 ), two( 2 );
+
+   std::vector<Scalar> val( varCount );
+   for( int i = 0; i < varCount; i++ ){
+      Scalar dy = denseY1[i] - denseY0[i];
+      val[i] = a*denseY0[i] + theta*denseY1[i]
+             + theta*(theta-one) * ( (one-two*theta)*dy
+                                   + (theta-one)*H*denseF0[i]
+                                   + theta*H*denseF1[i] );
+   }
+
+   // parameters are evaluated at the interpolated point
+   *TimeSymbol() = time;
+   for( int i = 0; i < varCount; i++ )
+      *VarSymbol( i ) = val[i];
+   for( int i = 0; i < paramCount; i++ )
+      *ParamSymbol( i ) = a*denseP0[i] + theta*denseP1[i];
+   for( int i = 0; i < paramCount; i++ )
+      *ParamSymbol( i ) = paramExpr[i].Eval();
+
+   return ToPoint( time, val, CurrentParams() );
+}
+
+template <typename Scalar>
+void PrecisionStepper<Scalar>::Step(
+){
+   std::vector<Scalar> k1( varCount );
+   std::vector<Scalar> slopes( ( stageCount - 1 ) * varCount );
+   std::vector<Scalar *> k( stageCount );
+   std::vector<Scalar> y( varCount );
+   k[0] = k1.data();
+   for( int s = 1; s < stageCount; s++ )
+      k[s] = slopes.data() + ( s - 1 ) * varCount;
+
+   Scalar t0 = tInit + Scalar( (double)steps ) * h;
+   Scalar t1 = tInit + Scalar( (double)( steps + 1 ) ) * h;
+
+   // k1, reusing the end slope of the previous step
+   if( denseValid ){
+      k1 = denseF1;
+   } else {
+      LoadPoint( t0, stateVal.data() );
+      EvaluateDerivatives( k1.data() );
+   }
+
+   // remaining stages and the final result
+   ( this->*stepRule )( t0, k.data(), y.data() );
+
+   // parameters and slope at the new point
+   std::vector<Scalar> slope( varCount );
+   LoadPoint( t1, y.data() );
+   EvaluateDerivatives( slope.data() );
+
+   // keep the step for dense output
+   denseT0 = t0;
+   denseT1 = t1;
+   denseY0 = stateVal;
+   denseY1 = y;
+   denseF0 = k1;
+   denseF1 = slope;
+   denseP0 = stateParam;
+   denseP1 = CurrentParams();
+   denseValid = true;
+
+   stateVal   = y;
+   stateParam = denseP1;
+   steps++;
+   stateT = t1;
+}
+
+template <typename Scalar>
+template <class Tableau>
+void PrecisionStepper<Scalar>::UseTableau(
+){
+   stageCount = Tableau::Stages;
+   stepRule   = &PrecisionStepper::template StepRule<Tableau>;
+}
+
+template <typename Scalar>
+template <class Tableau>
+void PrecisionStepper<Scalar>::StepRule(
+   const Scalar &t0
+ , Scalar *const *k
+ , Scalar *result
+){
+   std::vector<Scalar> stage( varCount );
+   auto derive = [this]( const Scalar &time, Scalar *point, Scalar *slope ){
+      LoadPoint( time, point );
+      EvaluateDerivatives( slope );
+   };
+
+   ExplicitRungeKuttaStep<Tableau>( derive, t0, h, varCount, stateVal.data(), k, stage.data(), result );
+}
+
+template <typename Scalar>
+void PrecisionStepper<Scalar>::LoadPoint(
+   const Scalar &time
+ , const Scalar *val
+){
+   // parameters are evaluated in order, each one sees those before it
+   *TimeSymbol() = time;
+   for( int i = 0; i < varCount; i++ )
+      *VarSymbol( i ) = val[i];
+   for( int i = 0; i < paramCount; i++ )
+      *ParamSymbol( i ) = paramExpr[i].Eval();
+}
+
+template <typename Scalar>
+std::vector<Scalar> PrecisionStepper<Scalar>::CurrentParams(
+){
+   std::vector<Scalar> param( paramCount );
+   for( int i = 0; i < paramCount; i++ )
+      param[i] = *ParamSymbol( i );
+
+   return param;
+}
+
+template <typename Scalar>
+void PrecisionStepper<Scalar>::EvaluateDerivatives(
+   Scalar *k
+){
+   evaluations++;
+   for( int i = 0; i < varCount; i++ )
+      k[i] = varExpr[i].Eval();
+}
+
+template <typename Scalar>
+PointValues PrecisionStepper<Scalar>::ToPoint(
+   const Scalar &time
+ , const std::vector<Scalar> &val
+ , const std::vector<Scalar> &param
+){
+   PointValues pv;
+   pv.T = static_cast<double>( time );
+   pv.Val.resize( val.size() );
+   pv.Param.resize( param.size() );
+   for( size_t i = 0; i < val.size(); i++ )
+      pv.Val[i] = static_cast<double>( val[i] );
+   for( size_t i = 0; i < param.size(); i++ )
+      pv.Param[i] = static_cast<double>( param[i] );
+
+   return pv;
+}
+
+template <typename Scalar>
+bool PrecisionStepper<Scalar>::UpdateEquations(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , QString &error
+){
+   QMutexLocker lock( &pendingMutex );
+
+   // only expressions can change while running
+   bool sameNames = ddt_rules.size() == varRules.size() && param_rules.size() == paramRules.size();
+   for( int i = 0; sameNames && i < varRules.size(); i++ )
+      sameNames = ddt_rules[i].first == varRules[i].first;
+   for( int i = 0; sameNames && i < paramRules.size(); i++ )
+      sameNames = param_rules[i].first == paramRules[i].first;
+   if( !sameNames ){
+      error = "variables or parameters were added, removed or renamed";
+      return false;
+   }
+
+   // compile changed expressions against scratch values; the live
+   // symbols belong to the simulation thread
+   Scalar scratchT( 0 );
+   std::vector<Scalar> scratchVars( varCount, Scalar( 0 ) );
+   std::vector<Scalar> scratchParams( paramCount, Scalar( 0 ) );
+   ExpressionSymbols<Scalar> scratch;
+   scratch.Define( "t", &scratchT );
+   for( int j = 0; j < varCount; j++ )
+      scratch.Define( varRules[j].first.toStdString(), &scratchVars[j] );
+   for( int j = 0; j < paramCount; j++ )
+      scratch.Define( paramRules[j].first.toStdString(), &scratchParams[j] );
+
+   QMap<int, QString> changedVars;
+   QMap<int, QString> changedParams;
+   try {
+      Expression<Scalar> check;
+      check.SetSymbols( &scratch );
+      for( int i = 0; i < varCount; i++ ){
+         if( ddt_rules[i].second == varRules[i].second )
+            continue;
+         check.SetExpr( ddt_rules[i].second.toStdString() );
+         changedVars[i] = ddt_rules[i].second;
+      }
+      for( int i = 0; i < paramCount; i++ ){
+         if( param_rules[i].second == paramRules[i].second )
+            continue;
+         check.SetExpr( param_rules[i].second.toStdString() );
+         changedParams[i] = param_rules[i].second;
+      }
+   } catch( ExpressionError &e ){
+      error = QString( "%1 in \"%2\"" ).arg( QString::fromStdString( e.GetMsg() ), QString::fromStdString( e.GetExpr() ) );
+      return false;
+   }
+
+   if( changedVars.isEmpty() && changedParams.isEmpty() )
+      return true;
+
+   // queue for the simulation thread; later edits replace earlier ones
+   for( auto it = changedVars.constBegin(); it != changedVars.constEnd(); ++it )
+      pendingVarExpr[it.key()] = it.value();
+   for( auto it = changedParams.constBegin(); it != changedParams.constEnd(); ++it )
+      pendingParamExpr[it.key()] = it.value();
+   varRules   = ddt_rules;
+   paramRules = param_rules;
+   pendingEquations.store( true, std::memory_order_release );
+
+   return true;
+}
+
+template <typename Scalar>
+void PrecisionStepper<Scalar>::ApplyPendingEquations(
+){
+   QMutexLocker lock( &pendingMutex );
+
+   // between steps, so no expression is in use
+   try {
+      for( auto it = pendingVarExpr.constBegin(); it != pendingVarExpr.constEnd(); ++it )
+         varExpr[it.key()].SetExpr( it.value().toStdString() );
+      for( auto it = pendingParamExpr.constBegin(); it != pendingParamExpr.constEnd(); ++it )
+         paramExpr[it.key()].SetExpr( it.value().toStdString() );
+   } catch( ExpressionError &e ){
+      ParserError( e );
+   }
+   pendingVarExpr.clear();
+   pendingParamExpr.clear();
+   pendingEquations.store( false, std::memory_order_release );
+
+   // parameters of the current point follow the new equations,
+   // and the old end slope no longer applies
+   LoadPoint( stateT, stateVal.data() );
+   stateParam = CurrentParams();
+   denseValid = false;
+}
+
+template <typename Scalar>
+void PrecisionStepper<Scalar>::ParserError(
+   const ExpressionError &e
+){
+   std::cerr << std::endl << "Parsing error:" << std::endl;
+   std::cerr << "------" << std::endl;
+   std::cerr << "Message:  " << e.GetMsg()   << std::endl;
+   std::cerr << "Formula:  " << e.GetExpr()  << std::endl;
+   std::cerr << "Token:    " << e.GetToken() << std::endl;
+   std::cerr << "Position: " << e.GetPos()   << std::endl;
+   exit( EXIT_FAILURE );
+}
+
+template class PrecisionStepper<float>;
+template class PrecisionStepper<double>;
+template class PrecisionStepper<long double>;
+template class PrecisionStepper<DoubleDouble>;
@@ -0,0 +1,127 @@
+#ifndef PRECISION_STEPPER_HPP
+#define PRECISION_STEPPER_HPP
+
+// Qt headers
+#include <QMap>
+#include <QString>
+#include <QMutex>
+
+// C headers
+#include <cstdlib>
+
+// C++ headers
+#include <iostream>
+#include <atomic>
+#include <vector>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "stepper.hpp"
+#include "expression.hpp"
+#include "butcher_tableau.hpp"
+#include "delay_history.hpp"
+
+// Explicit Runge-Kutta stepper with state, arithmetic and expression
+// evaluation all in Scalar. Instantiated for float, double, long double
+// and DoubleDouble. Rate groups, delay terms and parallel derivatives
+// are only supported by RungeKuttaStepper.
+// Symbols may hold series of seriesLength values each, see TaylorStepper.
+template <typename Scalar>
+class PrecisionStepper : public Stepper
+{
+public:
+   explicit PrecisionStepper( Method method = Method::RungeKutta4
+                            , int seriesLength = 1 );
+
+   void SetConditions( DerivationVector ddt_rules
+                     , EquationVector param_rules
+                     , PointValues val_init
+                     , double timeSlice
+                     , QMap<QString, int> rate_groups = QMap<QString, int>() ) override;
+
+   PointValues CalculateStep() override;
+   PointValues InitialValues() override;
+
+   double DenseStartTime() override;
+   double DenseEndTime() override;
+   PointValues DenseOutput( double t_out ) override;
+
+   bool UpdateEquations( DerivationVector ddt_rules
+                       , EquationVector param_rules
+                       , QString &error ) override;
+
+protected:
+   int varCount = 0;
+   int paramCount = 0;
+
+   // values seen by the expressions, t first, then variables and
+   // parameters; std::vector, as the expressions hold their addresses
+   // and QVector may detach on write
+   int stride;
+   std::vector<Scalar> symbolValues;
+   ExpressionSymbols<Scalar> symbols;
+   std::vector<Expression<Scalar>> varExpr;
+   std::vector<Expression<Scalar>> paramExpr;
+
+   Scalar *TimeSymbol()         { return &symbolValues[0]; }
+   Scalar *VarSymbol( int i )   { return &symbolValues[( 1 + i ) * stride]; }
+   Scalar *ParamSymbol( int i ) { return &symbolValues[( 1 + varCount + i ) * stride]; }
+
+   // state; Runge-Kutta time is t_init + steps*h, so it doesn't drift
+   // in low precision
+   PointValues init;
+   Scalar tInit;
+   Scalar h;
+   long long steps = 0;
+   Scalar stateT;
+   std::vector<Scalar> stateVal;
+   std::vector<Scalar> stateParam;
+
+   // last step, kept for dense output and for reusing the end slope
+   bool denseValid = false;
+   Scalar denseT0;
+   Scalar denseT1;
+   std::vector<Scalar> denseY0;
+   std::vector<Scalar> denseY1;
+   std::vector<Scalar> denseF0;
+   std::vector<Scalar> denseF1;
+   std::vector<Scalar> denseP0;
+   std::vector<Scalar> denseP1;
+
+   // live editing
+   DerivationVector varRules;
+   EquationVector   paramRules;
+   QMutex pendingMutex;
+   std::atomic<bool> pendingEquations{ false };
+   QMap<int, QString> pendingVarExpr;
+   QMap<int, QString> pendingParamExpr;
+
+   virtual void Step();
+   void LoadPoint( const Scalar &time
+                 , const Scalar *val );
+   std::vector<Scalar> CurrentParams();
+   void EvaluateDerivatives( Scalar *k );
+   PointValues ToPoint( const Scalar &time
+                      , const std::vector<Scalar> &val
+                      , const std::vector<Scalar> &param );
+
+   void ParserError( const ExpressionError &e );
+
+private:
+   // explicit Runge-Kutta rule, see RungeKuttaStepper
+   int stageCount;
+   void ( PrecisionStepper::*stepRule )( const Scalar &t0
+                                       , Scalar *const *k
+                                       , Scalar *result );
+
+   template <class Tableau>
+   void UseTableau();
+   template <class Tableau>
+   void StepRule( const Scalar &t0
+                , Scalar *const *k
+                , Scalar *result );
+
+   void ApplyPendingEquations();
+};
+
+#endif // PRECISION_STEPPER_HPP
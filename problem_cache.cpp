@@ -0,0 +1,97 @@
+#include "problem_cache.hpp"
+
+ProblemCache::ProblemCache(
+   QString problemFile
+) :
+   writer( &writeData, QIODevice::WriteOnly )
+{
+   mapped = NULL;
+   writer.setVersion( QDataStream::Qt_5_0 );
+
+   QFile input( problemFile );
+   if( input.open( QIODevice::ReadOnly ) ){
+      key = QCryptographicHash::hash( input.readAll(), QCryptographicHash::Sha1 ).toHex();
+   }
+}
+
+ProblemCache::~ProblemCache(
+){
+   reader.setDevice( NULL );
+   readBuffer.close();
+   if( mapped != NULL )
+      bundleFile.unmap( mapped );
+}
+
+bool ProblemCache::Open(
+){
+   if( key.isEmpty() )
+      return false;
+
+   bundleFile.setFileName( BundlePath() );
+   if( !bundleFile.open( QIODevice::ReadOnly ) )
+      return false;
+
+   mapped = bundleFile.map( 0, bundleFile.size() );
+   if( mapped == NULL )
+      return false;
+
+   // read straight from the mapping
+   readBuffer.setData( QByteArray::fromRawData( reinterpret_cast<const char *>( mapped ), bundleFile.size() ) );
+   readBuffer.open( QIODevice::ReadOnly );
+   reader.setDevice( &readBuffer );
+   reader.setVersion( QDataStream::Qt_5_0 );
+
+   QByteArray magic( 8, 0 );
+   quint32 version = 0;
+   reader.readRawData( magic.data(), magic.size() );
+   reader >> version;
+   if( magic != "ODEBNDL1" || version != BundleVersion || reader.status() != QDataStream::Ok ){
+      qDebug() << "WARNING: Ignoring outdated problem cache" << bundleFile.fileName();
+      return false;
+   }
+
+   return true;
+}
+
+QDataStream &ProblemCache::Reader(
+){
+   return reader;
+}
+
+QDataStream &ProblemCache::Writer(
+){
+   return writer;
+}
+
+void ProblemCache::Store(
+){
+   if( key.isEmpty() )
+      return;
+
+   QDir().mkpath( QFileInfo( BundlePath() ).absolutePath() );
+
+   // write to a temporary file and rename, so readers never see a partial bundle
+   QSaveFile output( BundlePath() );
+   if( !output.open( QIODevice::WriteOnly ) ){
+      qDebug() << "WARNING: Can't write problem cache" << output.fileName() << ":" << output.errorString();
+      return;
+   }
+
+   QDataStream header( &output );
+   header.setVersion( QDataStream::Qt_5_0 );
+   header.writeRawData( "ODEBNDL1", 8 );
+   header << BundleVersion;
+   output.write( writeData );
+   output.commit();
+}
+
+QString ProblemCache::Key(
+){
+   return key;
+}
+
+QString ProblemCache::BundlePath(
+){
+   QString cacheDir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+   return cacheDir + "/problems/" + key + ".bundle";
+}
@@ -0,0 +1,52 @@
+#ifndef PROBLEM_CACHE_HPP
+#define PROBLEM_CACHE_HPP
+
+// Qt headers
+#include <QFile>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QSaveFile>
+#include <QDir>
+#include <QString>
+#include <QByteArray>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QtDebug>
+
+// On-disk cache of analysed problems.
+// Bundles are keyed by a hash of the problem file contents, so an
+// unchanged problem is found again regardless of where it is opened from.
+// A cached bundle is memory-mapped and read in place.
+class ProblemCache
+{
+public:
+   explicit ProblemCache( QString problemFile );
+   ~ProblemCache();
+
+   // cached bundle
+   bool Open();
+   QDataStream &Reader();
+
+   // new bundle, written by Store()
+   QDataStream &Writer();
+   void Store();
+
+   QString Key();
+
+private:
+   // increase whenever the bundle contents change
+   static const quint32 BundleVersion = 15;
+
+   QString key;
+   QFile   bundleFile;
+   uchar  *mapped;
+   QBuffer readBuffer;
+   QDataStream reader;
+   QByteArray  writeData;
+   QDataStream writer;
+
+   QString BundlePath();
+};
+
+#endif // PROBLEM_CACHE_HPP
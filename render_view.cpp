@@ -6,97 +6,103 @@ RenderView::RenderView(
  , QString transformationY
  , QStringList paramNames
  , QWidget * /*parent*/ // unused
-){
+) :
+   transform( transformationX, transformationY, paramNames )
+ , trail( viewportArea )
+{
    viewRectAlwaysVisible = viewportArea;
    //updateViewRect( this->size() );
-
-   // initialize parser
-   try {
-      // clear
-      paramVals.clear();
-      for( auto parser : coordinateParsers ){
-         delete parser;
-      }
-      coordinateParsers.clear();
-
-      // create parsers
-      coordinateParsers.push_back( new mu::Parser );
-      coordinateParsers.push_back( new mu::Parser );
-
-      // register parameters
-//      qDebug() << "Registering parameters...";
-      paramVals.resize( paramNames.size() );
-//      qDebug() << "--- param count = " << paramVals.size() << " or " << paramNames.size();
-      for( auto parser : coordinateParsers ){
-//         qDebug() << "--- parser";
-         parser->DefineVar( "t", &t );
-         for( int i = 0; i < paramVals.size(); i++  ){
-            parser->DefineVar( paramNames[i].toStdString(), &(paramVals[i]) );
-//            qDebug() << "------ registered param " << paramNames[i];
-         }
-      }
-//      qDebug() << "Registering parameters done.";
-
-      // set coordinate transformation
-      coordinateParsers[0]->SetExpr( transformationX.toStdString() );
-      coordinateParsers[1]->SetExpr( transformationY.toStdString() );
-   } catch( mu::Parser::exception_type &e ){
-      ParserError( e );
-   }
 }
 
 RenderView::~RenderView(
 ){
-   for( auto parser : coordinateParsers ){
-      delete parser;
-   }
-   coordinateParsers.clear();
+   // stub
 }
 
 void RenderView::updateObjects(
-   QList<PointValues> pointPathList
+   const PathHistory &path
  , int maxPathLength
 ){
-   double x, y;
-   bool firstPoint = true;
-   QPointF p1, p2;
-   segments.clear();
-   segments.reserve( pointPathList.size() );
-
-   for( auto &point : pointPathList ){
-      t = point.T;
-      for( int i = 0; i < paramVals.size(); i++  ){
-         paramVals[i] = point.Param[i];
-      }
-      try {
-         x = coordinateParsers[0]->Eval();
-         y = coordinateParsers[1]->Eval();
-         //qDebug() << "Point ( " << x << ", " << y << " )";
-      } catch( mu::Parser::exception_type &e ){
-         ParserError( e );
-      }
-
-      if( firstPoint ){
-         p1 = QPoint( x, y );
-         firstPoint = false;
-      } else {
-         p2 = p1;
-         p1 = QPointF( x, y );
-         segments.append( QLineF( p1, p2 ) );
-      }
-   }
-
    if( maxPathLength != maxSegments ){
       maxSegments = maxPathLength;
       updateColors();
+      trail.SetCapacity( maxSegments );
+      pathGeneration = -1;
+   }
+   if( path.Count() == 0 )
+      return;
+
+   // start over after the path was cleared, or if points were missed
+   qint64 newest = path.Serial( 0 );
+   bool connected = true;
+   if( path.Generation() != pathGeneration || newest - mappedSerial >= path.Count() ){
+      trail.Clear();
+      pathGeneration = path.Generation();
+      mappedSerial = path.Serial( path.Count()-1 ) - 1;
+      connected = false;
    }
+
+   // map only the new points
+   QVector<double> values( path.ParamIndices().size() );
+   for( qint64 serial = mappedSerial + 1; serial <= newest; serial++ ){
+      int age = newest - serial;
+      path.Values( age, values.data() );
+      QPointF mapped = transform.Map( path.Time( age ), values.constData(), path.ParamIndices() );
+
+      if( connected )
+         trail.Append( QLineF( lastMapped, mapped ) );
+      lastMapped = mapped;
+      connected = true;
+   }
+   mappedSerial = newest;
+
+   // segments whose older point has left the path
+   while( trail.Count() > path.Count() - 1 )
+      trail.EvictOldest();
+}
+
+void RenderView::setDensity(
+   DensityHistogram *histogram
+ , ToneMapping mode
+ , double gamma
+){
+   density = histogram;
+   toneMode = mode;
+   toneGamma = gamma;
+}
+
+void RenderView::appendBand(
+   const EnsembleBand &band
+ , int maxBands
+){
+   bands.append( band );
+   if( bands.size() > maxBands )
+      bands.remove( 0, bands.size() - maxBands );
+}
+
+void RenderView::setOverlay(
+   const QVector<PointValues> &points
+ , bool closed
+){
+   overlay.clear();
+   for( const PointValues &pv : points )
+      overlay << transform.Map( pv );
+   overlayClosed = closed;
+   update();
 }
 
 void RenderView::updateViewRect( QSize newViewRectSize ){
-   int defW = viewRectAlwaysVisible.width();
-   int defH = viewRectAlwaysVisible.height();
-   int newW = newViewRectSize.width();
-   int newH = newViewRectSize.height();
+   viewRect = fitViewRect( viewRectAlwaysVisible, newViewRectSize );
+}
+
+QRect RenderView::fitViewRect(
+   QRect alwaysVisible
+ , QSize size
+){
+   int defW = alwaysVisible.width();
+   int defH = alwaysVisible.height();
+   int newW = size.width();
+   int newH = size.height();
 
    int x, y, w, h; // calculated values
 
@@ -114,41 +120,38 @@ void RenderView::updateViewRect( QSize newViewRectSize ){
    w = newW * ratio;
    h = newH * ratio;
 
-   x = viewRectAlwaysVisible.x() + (defW-w)/2;
-   y = viewRectAlwaysVisible.y() + (defH-h)/2;
+   x = alwaysVisible.x() + (defW-w)/2;
+   y = alwaysVisible.y() + (defH-h)/2;
 
 //   qDebug() << "Canvas size: " << newW << " x " << newH
 //            << " \tNew viewport: (" << x << ", " << y << ") " << w << " x " << h;
 
-   // set viewport rectangle, flipping it so that y axis points up
-   viewRect.setRect( x, y+h, w, -h );
+   // viewport rectangle, flipped so that y axis points up
+   QRect rect;
+   rect.setRect( x, y+h, w, -h );
+
+   return rect;
 }
 
 void RenderView::updateColors(
 ){
-   float h, s, v;
+   colors = pathColors( maxSegments );
+}
 
-   colors.resize( maxSegments );
+QVector<QColor> RenderView::pathColors(
+   int count
+){
+   float h, s, v;
+   QVector<QColor> colors( count );
 
    for( int i = 0; i < colors.size(); i++ ){
       h = 0;
-      s = 0 + 1.0/maxSegments*i;
-      v = 0 + 1.0/maxSegments*i;
+      s = 0 + 1.0/count*i;
+      v = 0 + 1.0/count*i;
       colors[i].setHsvF( h, s, v );
    }
-}
 
-void RenderView::ParserError(
-   mu::ParserBase::exception_type &e
-){
-   std::cerr << std::endl << "Parsing error:" << std::endl;
-   std::cerr << "------" << std::endl;
-   std::cerr << "Message:  " << e.GetMsg()   << std::endl;
-   std::cerr << "Formula:  " << e.GetExpr()  << std::endl;
-   std::cerr << "Token:    " << e.GetToken() << std::endl;
-   std::cerr << "Position: " << e.GetPos()   << std::endl;
-   std::cerr << "Errcode:  " << e.GetCode()  << std::endl;
-   exit( EXIT_FAILURE );
+   return colors;
 }
 
 void RenderView::paintEvent(
@@ -159,13 +162,40 @@ void RenderView::paintEvent(
    painter.setRenderHint( QPainter::Antialiasing );
    painter.fillRect( event->rect(), QBrush(Qt::white) );
 
-   painter.setWindow( viewRect );
-
 //   qDebug() << "Window: " << geometry().width() << "x" << geometry().height();
-//   qDebug() << "Geometry: ( " << startX << ", " << startY << " ) " << width << "x" << height;
 //   qDebug() << "Viewport: " << painter.viewport();
 //   qDebug() << "World: " << painter.window();
 
+   if( density != NULL ){
+      // the histogram covers its area at its own resolution
+      painter.setWindow( viewRect );
+      QRectF target = painter.combinedTransform().mapRect( density->Area() );
+      painter.setViewTransformEnabled( false );
+      painter.drawImage( target, density->Render( toneMode, toneGamma ) );
+      painter.setViewTransformEnabled( true );
+      paintScene( painter, viewRect, QVector<QLineF>(), colors );
+      paintOverlay( painter );
+   } else {
+      painter.setWindow( viewRect );
+      if( bands.size() > 1 )
+         paintBands( painter );
+      paintTrail( painter );
+      paintScene( painter, viewRect, QVector<QLineF>(), colors );
+      paintOverlay( painter );
+   }
+
+//   // draw viewport
+//   painter.drawRect( viewRectAlwaysVisible );
+}
+
+void RenderView::paintScene(
+   QPainter &painter
+ , QRect viewRect
+ , const QVector<QLineF> &segments
+ , const QVector<QColor> &colors
+){
+   painter.setWindow( viewRect );
+
    // draw particle path
    // draw lines backwards, from old to new
    for( int i = segments.size()-1; i >= 0; i-- ){
@@ -177,9 +207,72 @@ void RenderView::paintEvent(
    painter.setPen( QPen( QBrush( Qt::blue ), 0 ) );
    painter.drawLine( viewRect.x(), 0, viewRect.x()+viewRect.width(), 0 );
    painter.drawLine( 0, viewRect.y(), 0,  viewRect.y()+viewRect.height() );
+}
 
-//   // draw viewport
-//   painter.drawRect( viewRectAlwaysVisible );
+void RenderView::paintTrail(
+   QPainter &painter
+){
+   // oldest first, so that newer segments are drawn over older ones;
+   // colours go by age, like in paintScene
+   trail.Query( QRectF( viewRect ), visible );
+   qint64 newest = trail.NewestSerial();
+   for( qint64 serial : visible ){
+      painter.setPen( QPen( QBrush( colors[newest - serial] ), 0 ) );
+      painter.drawLine( trail.Segment( serial ) );
+   }
+}
+
+void RenderView::paintBands(
+   QPainter &painter
+){
+   // symmetric quantile pairs as nested translucent bands, so the
+   // colour deepens towards the middle
+   int levels = bands.last().Quantiles.size();
+   painter.setPen( Qt::NoPen );
+   painter.setBrush( QColor( 255, 0, 0, 48 ) );
+   for( int q = 0; q < levels / 2; q++ ){
+      QPolygonF polygon;
+      for( int i = 0; i < bands.size(); i++ )
+         polygon << QPointF( bands[i].Mean.x(), bands[i].Quantiles[levels-1-q] );
+      for( int i = bands.size()-1; i >= 0; i-- )
+         polygon << QPointF( bands[i].Mean.x(), bands[i].Quantiles[q] );
+      painter.drawPolygon( polygon );
+   }
+   painter.setBrush( Qt::NoBrush );
+
+   // mean, and one standard deviation to either side
+   QPolygonF mean, upper, lower;
+   for( const EnsembleBand &band : bands ){
+      mean  << band.Mean;
+      upper << band.Mean + QPointF( 0, band.Deviation.y() );
+      lower << band.Mean - QPointF( 0, band.Deviation.y() );
+   }
+   painter.setPen( QPen( QBrush( Qt::darkRed ), 0 ) );
+   painter.drawPolyline( mean );
+   painter.setPen( QPen( QBrush( Qt::darkRed ), 0, Qt::DashLine ) );
+   painter.drawPolyline( upper );
+   painter.drawPolyline( lower );
+}
+
+void RenderView::paintOverlay(
+   QPainter &painter
+){
+   if( overlay.isEmpty() )
+      return;
+
+   painter.setPen( QPen( QBrush( QColor( 0, 160, 0 ) ), 0 ) );
+   painter.setBrush( Qt::NoBrush );
+   if( overlay.size() == 1 ){
+      // a point is marked by a cross of a hundredth of the view
+      double arm = std::abs( viewRect.width() ) / 100.0;
+      QPointF p = overlay.first();
+      painter.drawLine( QPointF( p.x()-arm, p.y()-arm ), QPointF( p.x()+arm, p.y()+arm ) );
+      painter.drawLine( QPointF( p.x()-arm, p.y()+arm ), QPointF( p.x()+arm, p.y()-arm ) );
+   } else if( overlayClosed ){
+      painter.drawPolygon( overlay );
+   } else {
+      painter.drawPolyline( overlay );
+   }
 }
 
 void RenderView::resizeEvent(
@@ -9,11 +9,13 @@
 
 // C++ includes
 
-// math expression parsing header
-#include "muParser.h"
-
 // Local includes
 #include "ode_pathtracer.hpp"
+#include "coordinate_transform.hpp"
+#include "density_histogram.hpp"
+#include "path_history.hpp"
+#include "segment_index.hpp"
+#include "ensemble_solver.hpp"
 
 class RenderView : public QWidget
 {
@@ -25,7 +27,22 @@ public:
                       , QStringList paramNames
                       , QWidget *parent = 0 );
    ~RenderView();
-   void updateObjects( QList<PointValues> pointPathList, int maxPathLength );
+   void updateObjects( const PathHistory &path, int maxPathLength );
+   void setDensity( DensityHistogram *histogram
+                  , ToneMapping mode
+                  , double gamma );
+   void appendBand( const EnsembleBand &band
+                  , int maxBands );
+   void setOverlay( const QVector<PointValues> &points
+                  , bool closed );
+
+   // shared with offscreen rendering
+   static QRect fitViewRect( QRect alwaysVisible, QSize size );
+   static QVector<QColor> pathColors( int count );
+   static void paintScene( QPainter &painter
+                         , QRect viewRect
+                         , const QVector<QLineF> &segments
+                         , const QVector<QColor> &colors );
 
 private:
    QRect viewRect;
@@ -33,21 +50,36 @@ private:
 
    double pointX;
    double pointY;
-   double t;
 
-//   QStringList           paramsName;
-//   QMap<QString, double> paramsVal;
-//   QMap<QString, int>    paramsIndex;
-   QVector<double> paramVals;
-   QVector<mu::Parser *> coordinateParsers;
+   CoordinateTransform transform;
 
-   QVector<QLineF> segments;
+   // path segments, mapped once as points arrive; painting only
+   // visits the ones under viewRect
+   SegmentIndex trail;
+   int pathGeneration = -1;
+   qint64 mappedSerial = -1;
+   QPointF lastMapped;
+   QVector<qint64> visible;
    QVector<QColor> colors;
    int maxSegments = 0;
 
+   // density mode shows the histogram instead of the path
+   DensityHistogram *density = NULL;
+   ToneMapping toneMode = ToneMapping::Log;
+   double toneGamma = 2.2;
+
+   // ensemble mode: the latest bands, drawn under the path
+   QVector<EnsembleBand> bands;
+
+   // analysis results drawn over the path: an orbit, or a single point
+   QPolygonF overlay;
+   bool overlayClosed = false;
+
    void updateViewRect( QSize newViewRectSize );
    void updateColors();
-   void ParserError( mu::Parser::exception_type &e );
+   void paintTrail( QPainter &painter );
+   void paintBands( QPainter &painter );
+   void paintOverlay( QPainter &painter );
 
 signals:
 
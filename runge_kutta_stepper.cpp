@@ -1,7 +1,18 @@
 #include "runge_kutta_stepper.hpp"
 
 RungeKuttaStepper::RungeKuttaStepper(
+   Method method
 ){
+   switch( method ){
+   case Method::Euler:        UseTableau<EulerTableau>();        break;
+   case Method::Heun:         UseTableau<HeunTableau>();         break;
+   case Method::RungeKutta3:  UseTableau<RungeKutta3Tableau>();  break;
+   case Method::RungeKutta38: UseTableau<RungeKutta38Tableau>(); break;
+   case Method::RungeKutta6:  UseTableau<RungeKutta6Tableau>();  break;
+   case Method::RungeKutta4:
+   default:                   UseTableau<RungeKutta4Tableau>();  break;
+   }
+
    derivationMode  = DerivationMode::None;
    calculationMode = CalculationMode::None;
 
@@ -21,6 +32,12 @@ RungeKuttaStepper::~RungeKuttaStepper(
       delete[] varParser;
    if( paramParser != NULL )
       delete[] paramParser;
+   if( delayed != NULL )
+      delete[] delayed;
+   if( lagParser != NULL )
+      delete[] lagParser;
+   if( evaluator != NULL )
+      delete evaluator;
 }
 
 void RungeKuttaStepper::SetConditions(
@@ -28,6 +45,7 @@ void RungeKuttaStepper::SetConditions(
  , EquationVector param_rules
  , PointValues val_init
  , double timeSlice
+ , QMap<QString, int> rate_groups
 ){
    // initialize parser
    try {
@@ -35,6 +53,10 @@ void RungeKuttaStepper::SetConditions(
       paramCount = param_rules.size();
 
       // delete old settings, if present
+      if( evaluator != NULL ){
+         delete evaluator;
+         evaluator = NULL;
+      }
       if( vars != NULL )
          delete[] vars;
       if( params != NULL )
@@ -43,29 +65,55 @@ void RungeKuttaStepper::SetConditions(
          delete[] varParser;
       if( paramParser != NULL )
          delete[] paramParser;
+      if( delayed != NULL )
+         delete[] delayed;
+      if( lagParser != NULL )
+         delete[] lagParser;
+
+      // delay terms are replaced by symbols of their own
+      QStringList varNames;
+      for( int j = 0; j < varCount; j++ )
+         varNames << ddt_rules[j].first;
+      QVector<QString> varExpr( varCount );
+      QVector<QString> paramExpr( paramCount );
+      delayTerms.clear();
+      for( int i = 0; i < varCount; i++ )
+         varExpr[i] = ExtractDelayTerms( ddt_rules[i].second, varNames, delayTerms );
+      for( int i = 0; i < paramCount; i++ )
+         paramExpr[i] = ExtractDelayTerms( param_rules[i].second, varNames, delayTerms );
+      int delayCount = delayTerms.size();
 
       // allocate memory
       vars   = new double[varCount];
       params = new double[paramCount];
       varParser   = new mu::Parser[varCount];
       paramParser = new mu::Parser[paramCount];
+      delayed   = new double[delayCount];
+      lagParser = new mu::Parser[delayCount];
+
+      // register symbols once; parsers look them up on demand
+      symbols.Clear();
+      symbols.Reserve( varCount + paramCount + delayCount + 1 );
+      symbols.Define( "t", &t );
+      for( int j = 0; j < varCount; j++ )
+         symbols.Define( ddt_rules[j].first, &vars[j] );
+      for( int j = 0; j < paramCount; j++ )
+         symbols.Define( param_rules[j].first, &params[j] );
+      for( int j = 0; j < delayCount; j++ )
+         symbols.Define( delayTerms[j].symbol, &delayed[j] );
 
       // set parsers
       for( int i = 0; i < varCount; i++ ){
-         varParser[i].DefineVar( "t", &t );
-         for( int j = 0; j < varCount; j++ )
-            varParser[i].DefineVar( ddt_rules[j].first.toStdString(), &vars[j] );
-         for( int j = 0; j < paramCount; j++ )
-            varParser[i].DefineVar( param_rules[j].first.toStdString(), &params[j] );
-         varParser[i].SetExpr( ddt_rules[i].second.toStdString() );
+         symbols.Bind( varParser[i] );
+         varParser[i].SetExpr( varExpr[i].toStdString() );
       }
       for( int i = 0; i < paramCount; i++ ){
-         paramParser[i].DefineVar( "t", &t );
-         for( int j = 0; j < varCount; j++ )
-            paramParser[i].DefineVar( ddt_rules[j].first.toStdString(), &vars[j] );
-         for( int j = 0; j < paramCount; j++ )
-            paramParser[i].DefineVar( param_rules[j].first.toStdString(), &params[j] );
-         paramParser[i].SetExpr( param_rules[i].second.toStdString() );
+         symbols.Bind( paramParser[i] );
+         paramParser[i].SetExpr( paramExpr[i].toStdString() );
+      }
+      for( int i = 0; i < delayCount; i++ ){
+         symbols.Bind( lagParser[i] );
+         lagParser[i].SetExpr( delayTerms[i].lag.toStdString() );
       }
    } catch( mu::Parser::exception_type &e ){
       ParserError( e );
@@ -74,27 +122,102 @@ void RungeKuttaStepper::SetConditions(
    derivationMode  = DerivationMode::Rule;
    calculationMode = CalculationMode::Step;
 
+   {
+      QMutexLocker lock( &pendingMutex );
+      varRules   = ddt_rules;
+      paramRules = param_rules;
+      pendingVarExpr.clear();
+      pendingParamExpr.clear();
+      pendingEquations = false;
+   }
+
    init = val_init;
    h    = timeSlice;
 
+   // assign rate groups; rate 1 is the regular step
+   varRate.fill( 1, varCount );
+   paramRate.fill( 1, paramCount );
+   varSlope.fill( 0.0, varCount );
+   slowParamValue.fill( 0.0, paramCount );
+   slowParamTime.fill( 0.0, paramCount );
+   slowParamSlope.fill( 0.0, paramCount );
+   rateGroups.clear();
+   for( auto it = rate_groups.constBegin(); it != rate_groups.constEnd(); ++it ){
+      int rate = it.value();
+      if( rate < 1 ){
+         std::cerr << "Ignoring rate group of '" << it.key().toStdString() << "': rate must be at least 1." << std::endl;
+         continue;
+      }
+
+      bool found = false;
+      for( int i = 0; i < varCount; i++ ){
+         if( ddt_rules[i].first == it.key() ){
+            varRate[i] = rate;
+            found = true;
+         }
+      }
+      for( int i = 0; i < paramCount; i++ ){
+         if( param_rules[i].first == it.key() ){
+            paramRate[i] = rate;
+            found = true;
+         }
+      }
+      if( !found ){
+         std::cerr << "Ignoring rate group of '" << it.key().toStdString() << "': unknown name." << std::endl;
+         continue;
+      }
+
+      if( rate > 1 && !rateGroups.contains( rate ) )
+         rateGroups.push_back( rate );
+   }
+   multiRate = !rateGroups.isEmpty();
+   microStep = 0;
+
+   endSlopeValid = false;
+
+   // the past of delayed variables starts with their initial values
+   QVector<int> columnVars;
+   for( const DelayTerm &term : delayTerms ){
+      columnVars.resize( std::max( columnVars.size(), term.column + 1 ) );
+      columnVars[term.column] = term.var;
+   }
+   history.Reset( columnVars, init.T, init.Val );
+   delayCursor.fill( 0, delayTerms.size() );
+   maxLag = 0.0;
+
    // calculate initial parameter values
    init.Param.resize( paramCount );
    t = init.T;
    for( int i = 0; i < varCount; i++ )
       vars[i] = init.Val[i];
-   for( int i = 0; i < paramCount; i++ )
-      init.Param[i] = params[i] = paramParser[i].Eval();
+   for( int k = 0; k < delayTerms.size(); k++ )
+      delayed[k] = init.Val[delayTerms[k].var];
+   try {
+      for( int i = 0; i < paramCount; i++ )
+         init.Param[i] = params[i] = paramParser[i].Eval();
+
+      // lags may depend on the parameters, so they go after them
+      UpdateDelays();
+
+      // first evaluation compiles the derivations,
+      // so that errors are reported on load
+      for( int i = 0; i < varCount; i++ )
+         varParser[i].Eval();
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   current = init;
 }
 
 PointValues RungeKuttaStepper::CalculateStep(
 ){
-   static PointValues pv = init;
+   if( pendingEquations.load( std::memory_order_acquire ) )
+      ApplyPendingEquations( current );
 
-   PointValues step_i1;
-   step_i1 = Step( pv );
-   pv = step_i1;
+   current = Step( current );
 
-   return pv;
+   return current;
 }
 
 PointValues RungeKuttaStepper::Step(
@@ -133,9 +256,16 @@ PointValues RungeKuttaStepper::Step(
    case DerivationMode::Rule:
       try {
          QVector<double> k1( varCount );
-         QVector<double> k2( varCount );
-         QVector<double> k3( varCount );
-         QVector<double> k4( varCount );
+         QVector<double> slopes( ( stageCount - 1 ) * varCount );
+         QVector<double *> k( stageCount );
+         k[0] = k1.data();
+         for( int s = 1; s < stageCount; s++ )
+            k[s] = slopes.data() + ( s - 1 ) * varCount;
+
+         // slow groups are advanced at their block boundaries
+         if( multiRate )
+            AdvanceRateGroups( val_i );
+         microStep++;
 
          // k1
          t = val_i.T;
@@ -143,48 +273,53 @@ PointValues RungeKuttaStepper::Step(
             vars[i] = val_i.Val[i];
          for( int i = 0; i < paramCount; i++ )
             params[i] = val_i.Param[i];
-         for( int i = 0; i < varCount; i++ )
-            k1[i] = varParser[i].Eval();
+         if( endSlopeValid && val_i.T == denseT0 + denseH
+             && val_i.Val == denseY1 && val_i.Param == denseP1 ){
+            // continuing from the previous step, reuse its end slope
+            for( int i = 0; i < varCount; i++ )
+               k1[i] = varRate.at( i ) > 1 ? varSlope.at( i ) : denseF1.at( i );
+         } else {
+            UpdateDelays();
+            EvaluateDerivatives( k1.data() );
+         }
 
-         // k2
-         t = val_i.T + h/2.0;
-         for( int i = 0; i < varCount; i++ )
-            vars[i] = val_i.Val[i] + h/2.0 * k1[i];
-         for( int i = 0; i < paramCount; i++ )
-            params[i] = paramParser[i].Eval();
-         for( int i = 0; i < varCount; i++ )
-            k2[i] = varParser[i].Eval();
-
-         // k3
-         t = val_i.T + h/2.0;
-         for( int i = 0; i < varCount; i++ )
-            vars[i] = val_i.Val[i] + h/2.0 * k2[i];
-         for( int i = 0; i < paramCount; i++ )
-            params[i] = paramParser[i].Eval();
-         for( int i = 0; i < varCount; i++ )
-            k3[i] = varParser[i].Eval();
-
-         // k4
-         t = val_i.T + h;
-         for( int i = 0; i < varCount; i++ )
-            vars[i] = val_i.Val[i] + h * k3[i];
-         for( int i = 0; i < paramCount; i++ )
-            params[i] = paramParser[i].Eval();
-         for( int i = 0; i < varCount; i++ )
-            k4[i] = varParser[i].Eval();
-
-         // final result
-         QVector<double> newVal( val_i.Val );
-         for( int i = 0; i < varCount; i++ )
-            newVal[i] += h/6.0 * ( k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i] );
+         // remaining stages and the final result
+         QVector<double> newVal( varCount );
+         ( this->*stepRule )( val_i.T, val_i.Val.constData(), k.data(), newVal.data() );
 
          // parameters
          t = val_i.T + h;
          QVector<double> newParam( val_i.Param.size() );
          for( int i = 0; i < varCount; i++ )
             vars[i] = newVal[i];
+         UpdateDelays();
+         for( int i = 0; i < paramCount; i++ )
+            newParam[i] = ParamValue( i );
+
+         // slope at the new point, which is both the end slope of the
+         // dense output and k1 of the following step
+         QVector<double> newSlope( varCount );
          for( int i = 0; i < paramCount; i++ )
-            newParam[i] = paramParser[i].Eval();
+            params[i] = newParam[i];
+         EvaluateDerivatives( newSlope.data() );
+
+         // keep the step for dense output
+         denseT0 = val_i.T;
+         denseH  = h;
+         denseY0 = val_i.Val;
+         denseY1 = newVal;
+         denseF0 = k1;
+         denseF1 = newSlope;
+         denseP0 = val_i.Param;
+         denseP1 = newParam;
+         endSlopeValid = true;
+
+         // delayed variables remember the step as long as the largest lag
+         if( !delayTerms.isEmpty() ){
+            history.Append( denseT0, denseH, denseY0.constData(), denseY1.constData()
+                          , denseF0.constData(), denseF1.constData() );
+            history.Trim( denseT0 + denseH - maxLag );
+         }
 
          PointValues val_ip1;
          val_ip1.T     = val_i.T + h;
@@ -204,6 +339,409 @@ PointValues RungeKuttaStepper::Step(
    exit( EXIT_FAILURE );
 }
 
+PointValues RungeKuttaStepper::Point(
+   double time
+ , const QVector<double> &values
+){
+   PointValues val;
+   val.T   = time;
+   val.Val = values;
+   val.Param.resize( paramCount );
+
+   try {
+      t = time;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = values[i];
+      for( int i = 0; i < paramCount; i++ )
+         val.Param[i] = params[i] = paramParser[i].Eval();
+      UpdateDelays();
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return val;
+}
+
+void RungeKuttaStepper::Derivatives(
+   const PointValues &val
+ , double *slope
+){
+   try {
+      t = val.T;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = val.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = val.Param[i];
+      UpdateDelays();
+      EvaluateDerivatives( slope );
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+}
+
+template <class Tableau>
+void RungeKuttaStepper::UseTableau(
+){
+   stageCount = Tableau::Stages;
+   stepRule   = &RungeKuttaStepper::StepRule<Tableau>;
+}
+
+template <class Tableau>
+void RungeKuttaStepper::StepRule(
+   double t_i
+ , const double *y
+ , double *const *k
+ , double *result
+){
+   // stage points are built directly in the parser variables
+   auto derive = [this]( double time, double *, double *slope ){
+      t = time;
+      UpdateDelays();
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = ParamValue( i );
+      EvaluateDerivatives( slope );
+   };
+
+   ExplicitRungeKuttaStep<Tableau>( derive, t_i, h, varCount, y, k, vars, result );
+}
+
+void RungeKuttaStepper::EnableParallelDerivatives(
+   int threads
+){
+   if( evaluator != NULL ){
+      delete evaluator;
+      evaluator = NULL;
+   }
+
+   // at least one cache line of derivatives per thread
+   threads = std::min( threads, varCount / 8 );
+   if( threads < 2 )
+      return;
+
+   ParallelEvaluator *candidate = new ParallelEvaluator( varCount, threads,
+      [this]( int begin, int end, double *out ){
+         for( int i = begin; i < end; i++ )
+            out[i] = Derivative( i );
+      } );
+
+   // keep the pool only if it beats serial evaluation on this system
+   try {
+      QVector<double> k( varCount );
+      const int rounds = 16;
+
+      t = init.T;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = init.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = init.Param[i];
+      candidate->Evaluate( k.data() );
+
+      QElapsedTimer timer;
+      timer.start();
+      for( int r = 0; r < rounds; r++ )
+         for( int i = 0; i < varCount; i++ )
+            k[i] = Derivative( i );
+      qint64 serial = timer.nsecsElapsed();
+
+      timer.restart();
+      for( int r = 0; r < rounds; r++ )
+         candidate->Evaluate( k.data() );
+      qint64 parallel = timer.nsecsElapsed();
+
+      if( parallel < serial ){
+         evaluator = candidate;
+      } else {
+         delete candidate;
+      }
+   } catch( mu::Parser::exception_type &e ){
+      delete candidate;
+      ParserError( e );
+   }
+}
+
+bool RungeKuttaStepper::UpdateEquations(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , QString &error
+){
+   QMutexLocker lock( &pendingMutex );
+
+   // only expressions can change while running
+   bool sameNames = ddt_rules.size() == varRules.size() && param_rules.size() == paramRules.size();
+   for( int i = 0; sameNames && i < varRules.size(); i++ )
+      sameNames = ddt_rules[i].first == varRules[i].first;
+   for( int i = 0; sameNames && i < paramRules.size(); i++ )
+      sameNames = param_rules[i].first == paramRules[i].first;
+   if( !sameNames ){
+      error = "variables or parameters were added, removed or renamed";
+      return false;
+   }
+
+   // compile changed expressions against scratch values; the live
+   // symbols belong to the simulation thread
+   double scratchT = init.T;
+   QVector<double> scratchVars( init.Val );
+   QVector<double> scratchParams( init.Param );
+   SymbolTable scratch;
+   scratch.Reserve( varCount + paramCount + 1 );
+   scratch.Define( "t", &scratchT );
+   for( int j = 0; j < varCount; j++ )
+      scratch.Define( varRules[j].first, &scratchVars[j] );
+   for( int j = 0; j < paramCount; j++ )
+      scratch.Define( paramRules[j].first, &scratchParams[j] );
+   QVector<double> scratchDelayed( delayTerms.size(), 0.0 );
+   for( int j = 0; j < delayTerms.size(); j++ )
+      scratch.Define( delayTerms[j].symbol, &scratchDelayed[j] );
+
+   // delay terms have their history and symbols set up on load,
+   // so edits can only use those
+   QStringList varNames;
+   for( int j = 0; j < varCount; j++ )
+      varNames << varRules[j].first;
+   QVector<DelayTerm> terms( delayTerms );
+
+   QMap<int, QString> changedVars;
+   QMap<int, QString> changedParams;
+   QString expression;
+   try {
+      for( int i = 0; i < varCount; i++ ){
+         if( ddt_rules[i].second == varRules[i].second )
+            continue;
+         expression = ddt_rules[i].second;
+         QString rewritten = ExtractDelayTerms( expression, varNames, terms );
+         if( terms.size() > delayTerms.size() ){
+            error = "new delay terms need the problem to be reloaded";
+            return false;
+         }
+         mu::Parser check;
+         scratch.Bind( check );
+         check.SetExpr( rewritten.toStdString() );
+         check.Eval();
+         changedVars[i] = rewritten;
+      }
+      for( int i = 0; i < paramCount; i++ ){
+         if( param_rules[i].second == paramRules[i].second )
+            continue;
+         expression = param_rules[i].second;
+         QString rewritten = ExtractDelayTerms( expression, varNames, terms );
+         if( terms.size() > delayTerms.size() ){
+            error = "new delay terms need the problem to be reloaded";
+            return false;
+         }
+         mu::Parser check;
+         scratch.Bind( check );
+         check.SetExpr( rewritten.toStdString() );
+         check.Eval();
+         changedParams[i] = rewritten;
+      }
+   } catch( mu::Parser::exception_type &e ){
+      error = QString( "%1 in \"%2\"" ).arg( QString::fromStdString( e.GetMsg() ), expression );
+      return false;
+   }
+
+   if( changedVars.isEmpty() && changedParams.isEmpty() )
+      return true;
+
+   // queue for the simulation thread; later edits replace earlier ones
+   for( auto it = changedVars.constBegin(); it != changedVars.constEnd(); ++it )
+      pendingVarExpr[it.key()] = it.value();
+   for( auto it = changedParams.constBegin(); it != changedParams.constEnd(); ++it )
+      pendingParamExpr[it.key()] = it.value();
+   varRules   = ddt_rules;
+   paramRules = param_rules;
+   pendingEquations.store( true, std::memory_order_release );
+
+   return true;
+}
+
+void RungeKuttaStepper::ApplyPendingEquations(
+   PointValues &pv
+){
+   QMutexLocker lock( &pendingMutex );
+
+   // between steps, so no parser is in use
+   try {
+      for( auto it = pendingVarExpr.constBegin(); it != pendingVarExpr.constEnd(); ++it )
+         varParser[it.key()].SetExpr( it.value().toStdString() );
+      for( auto it = pendingParamExpr.constBegin(); it != pendingParamExpr.constEnd(); ++it )
+         paramParser[it.key()].SetExpr( it.value().toStdString() );
+
+      // parameters of the current point follow the new equations
+      if( !pendingParamExpr.isEmpty() ){
+         t = pv.T;
+         for( int i = 0; i < varCount; i++ )
+            vars[i] = pv.Val[i];
+         for( int i = 0; i < paramCount; i++ )
+            params[i] = pv.Param[i];
+         UpdateDelays();
+         for( int i = 0; i < paramCount; i++ )
+            pv.Param[i] = params[i] = paramParser[i].Eval();
+      }
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+   pendingVarExpr.clear();
+   pendingParamExpr.clear();
+   pendingEquations.store( false, std::memory_order_release );
+
+   // old slopes and slow-group blocks no longer apply
+   endSlopeValid = false;
+   microStep = 0;
+}
+
+PointValues RungeKuttaStepper::InitialValues(
+){
+   return init;
+}
+
+void RungeKuttaStepper::SetTimeSlice(
+   double timeSlice
+){
+   h = timeSlice;
+}
+
+void RungeKuttaStepper::Reset(
+){
+   // restart rate group blocks and forget the last step
+   microStep = 0;
+   endSlopeValid = false;
+}
+
+double RungeKuttaStepper::DenseStartTime(
+){
+   return endSlopeValid ? denseT0 : init.T;
+}
+
+double RungeKuttaStepper::DenseEndTime(
+){
+   return endSlopeValid ? denseT0 + denseH : init.T;
+}
+
+PointValues RungeKuttaStepper::DenseOutput(
+   double t_out
+){
+   if( !endSlopeValid )
+      return init;
+
+   // cubic Hermite interpolation over the last step
+   double theta = ( t_out - denseT0 ) / denseH;
+   double a = 1.0 - theta;
+
+   PointValues val;
+   val.T = t_out;
+   val.Val.resize( varCount );
+   val.Param.resize( paramCount );
+
+   for( int i = 0; i < varCount; i++ ){
+      double dy = denseY1[i] - denseY0[i];
+      val.Val[i] = a*denseY0[i] + theta*denseY1[i]
+                 + theta*(theta-1.0) * ( (1.0-2.0*theta)*dy
+                                       + (theta-1.0)*denseH*denseF0[i]
+                                       + theta*denseH*denseF1[i] );
+   }
+
+   // parameters are evaluated at the interpolated point
+   try {
+      t = t_out;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = val.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = a*denseP0[i] + theta*denseP1[i];
+      UpdateDelays();
+      for( int i = 0; i < paramCount; i++ )
+         val.Param[i] = params[i] = ParamValue( i );
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return val;
+}
+
+void RungeKuttaStepper::AdvanceRateGroups(
+   const PointValues &val_i
+){
+   QVector<double> k1( varCount );
+   QVector<double> k2( varCount );
+   QVector<double> k3( varCount );
+   QVector<double> k4( varCount );
+
+   for( int rate : rateGroups ){
+      if( microStep % rate != 0 )
+         continue;
+
+      double H = rate * h;
+
+      // re-evaluate slow parameters at the block start; in between,
+      // they are extrapolated linearly from the last two samples
+      t = val_i.T;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = val_i.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = val_i.Param[i];
+      UpdateDelays();
+      for( int i = 0; i < paramCount; i++ ){
+         if( paramRate[i] != rate )
+            continue;
+         double value = paramParser[i].Eval();
+         slowParamSlope[i] = microStep > 0 ? ( value - slowParamValue[i] ) / H : 0.0;
+         slowParamValue[i] = value;
+         slowParamTime[i]  = val_i.T;
+      }
+
+      if( !varRate.contains( rate ) )
+         continue;
+
+      // advance slow variables over the whole block with the fast ones held;
+      // micro-steps then follow the straight line to the block end value
+
+      // k1
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            k1[i] = SlowDerivative( i );
+
+      // k2
+      t = val_i.T + H/2.0;
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            vars[i] = val_i.Val[i] + H/2.0 * k1[i];
+      UpdateDelays();
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = ParamValue( i );
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            k2[i] = SlowDerivative( i );
+
+      // k3
+      t = val_i.T + H/2.0;
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            vars[i] = val_i.Val[i] + H/2.0 * k2[i];
+      UpdateDelays();
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = ParamValue( i );
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            k3[i] = SlowDerivative( i );
+
+      // k4
+      t = val_i.T + H;
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            vars[i] = val_i.Val[i] + H * k3[i];
+      UpdateDelays();
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = ParamValue( i );
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            k4[i] = SlowDerivative( i );
+
+      // mean slope over the block
+      for( int i = 0; i < varCount; i++ )
+         if( varRate[i] == rate )
+            varSlope[i] = ( k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i] ) / 6.0;
+   }
+}
+
 void RungeKuttaStepper::ParserError(
    mu::ParserBase::exception_type &e
 ){
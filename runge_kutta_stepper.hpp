@@ -1,6 +1,12 @@
 #ifndef RUNGE_KUTTA_STEPPER_HPP
 #define RUNGE_KUTTA_STEPPER_HPP
 
+// Qt headers
+#include <QMap>
+#include <QString>
+#include <QElapsedTimer>
+#include <QMutex>
+
 // C headers
 #include <cstdlib>
 
@@ -8,12 +14,19 @@
 #include <vector>
 #include <utility>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
 
 // math expression parsing header
 #include "muParser.h"
 
 // Local headers
 #include "ode_pathtracer.hpp"
+#include "stepper.hpp"
+#include "butcher_tableau.hpp"
+#include "delay_history.hpp"
+#include "symbol_table.hpp"
+#include "parallel_evaluator.hpp"
 
 enum class DerivationMode{
    None
@@ -27,20 +40,44 @@ enum class CalculationMode{
  , Step
 };
 
-class RungeKuttaStepper
+class RungeKuttaStepper : public Stepper
 {
 public:
-   RungeKuttaStepper( void );
+   explicit RungeKuttaStepper( Method method = Method::RungeKutta4 );
    ~RungeKuttaStepper( void );
 
    void SetConditions( DerivationVector ddt_rules
                      , EquationVector param_rules
                      , PointValues val_init
-                     , double timeSlice );
+                     , double timeSlice
+                     , QMap<QString, int> rate_groups = QMap<QString, int>() ) override;
 
-   PointValues CalculateStep();
+   PointValues CalculateStep() override;
    PointValues Step( PointValues val_i );
 
+   // right-hand side for analysis: the point at (time, values) with its
+   // parameters, and the derivatives at a point
+   PointValues Point( double time
+                    , const QVector<double> &values );
+   void Derivatives( const PointValues &val
+                   , double *slope );
+
+   PointValues InitialValues() override;
+   void SetTimeSlice( double timeSlice );
+   void Reset();
+   void EnableParallelDerivatives( int threads ) override;
+
+   // live editing: changed expressions are checked right away and
+   // swapped in at the start of the next CalculateStep()
+   bool UpdateEquations( DerivationVector ddt_rules
+                       , EquationVector param_rules
+                       , QString &error ) override;
+
+   // continuous output between the endpoints of the last step
+   double DenseStartTime() override;
+   double DenseEndTime() override;
+   PointValues DenseOutput( double t_out ) override;
+
 private:
 //   QVector<double> (*derive)( PointValues );
 
@@ -51,15 +88,119 @@ private:
    double *params = NULL;
    mu::Parser *varParser = NULL;
    mu::Parser *paramParser = NULL;
+   SymbolTable symbols;
+   ParallelEvaluator *evaluator = NULL;
+
+   // delay terms x(t - lag): the symbol of term k holds delayed[k],
+   // looked up in the history whenever t or the variables change
+   QVector<DelayTerm> delayTerms;
+   double *delayed = NULL;
+   mu::Parser *lagParser = NULL;
+   QVector<qint64> delayCursor;
+   double maxLag = 0.0;
+   DelayHistory history;
 
    DerivationMode derivationMode;
    CalculationMode calculationMode;
 
+   // current equations and edits waiting for a step boundary
+   DerivationVector varRules;
+   EquationVector   paramRules;
+   QMutex pendingMutex;
+   std::atomic<bool> pendingEquations{ false };
+   QMap<int, QString> pendingVarExpr;
+   QMap<int, QString> pendingParamExpr;
+
+   void ApplyPendingEquations( PointValues &pv );
+
+   // explicit Runge-Kutta rule, chosen once; the stages of each rule
+   // are generated from its tableau
+   int stageCount;
+   void ( RungeKuttaStepper::*stepRule )( double t_i
+                                        , const double *y
+                                        , double *const *k
+                                        , double *result );
+
+   template <class Tableau>
+   void UseTableau();
+   template <class Tableau>
+   void StepRule( double t_i
+                , const double *y
+                , double *const *k
+                , double *result );
+
    double t_init, t_end;
    PointValues init;
+   PointValues current; // state advanced by CalculateStep()
    int n;
    double h;
 
+   // last step, kept for dense output
+   bool endSlopeValid = false;
+   double denseT0;
+   double denseH;
+   QVector<double> denseY0;
+   QVector<double> denseY1;
+   QVector<double> denseF0;
+   QVector<double> denseF1;
+   QVector<double> denseP0;
+   QVector<double> denseP1;
+
+   // multi-rate integration: variables and parameters with rate k > 1
+   // are advanced or re-evaluated only every k steps
+   bool multiRate = false;
+   long long microStep = 0;
+   QVector<int> rateGroups;
+   QVector<int> varRate;
+   QVector<int> paramRate;
+   QVector<double> varSlope;
+   QVector<double> slowParamValue;
+   QVector<double> slowParamTime;
+   QVector<double> slowParamSlope;
+   int slowEvaluations = 0; // slow derivatives short of a whole evaluation
+
+   void AdvanceRateGroups( const PointValues &val_i );
+
+   // a slow group's stage evaluates only its own derivatives; every
+   // varCount of them count as one right-hand side evaluation
+   inline double SlowDerivative( int i ){
+      if( ++slowEvaluations >= varCount ){
+         evaluations++;
+         slowEvaluations = 0;
+      }
+      return varParser[i].Eval();
+   }
+
+   inline double ParamValue( int i ){
+      if( paramRate.at( i ) > 1 )
+         return slowParamValue.at( i ) + ( t - slowParamTime.at( i ) ) * slowParamSlope.at( i );
+      return paramParser[i].Eval();
+   }
+
+   inline void UpdateDelays(){
+      for( int k = 0; k < delayTerms.size(); k++ ){
+         double lag = std::max( 0.0, lagParser[k].Eval() );
+         maxLag = std::max( maxLag, lag );
+         delayed[k] = history.Value( delayTerms[k].column, t - lag, delayCursor[k] );
+      }
+   }
+
+   inline double Derivative( int i ){
+      if( varRate.at( i ) > 1 )
+         return varSlope.at( i );
+      return varParser[i].Eval();
+   }
+
+   inline void EvaluateDerivatives( double *k ){
+      evaluations++;
+      if( evaluator != NULL ){
+         evaluator->Evaluate( k );
+         return;
+      }
+      for( int i = 0; i < varCount; i++ )
+         k[i] = Derivative( i );
+   }
+
    void ParserError( mu::Parser::exception_type &e );
 };
 
@@ -0,0 +1,36 @@
+#ifndef RUNNING_STATISTICS_HPP
+#define RUNNING_STATISTICS_HPP
+
+// Qt headers
+#include <QVector>
+#include <QMetaType>
+
+// C++ headers
+#include <cmath>
+#include <limits>
+
+// Min, max, mean and RMS of a value, updated in O(1) per sample.
+struct RunningStatistics {
+   long long count = 0;
+   double min  =  std::numeric_limits<double>::infinity();
+   double max  = -std::numeric_limits<double>::infinity();
+   double mean = 0.0;
+   double meanSquare = 0.0;
+
+   inline void Add( double x ){
+      count++;
+      if( x < min ) min = x;
+      if( x > max ) max = x;
+      // incremental means stay accurate over long runs
+      mean       += ( x   - mean )       / count;
+      meanSquare += ( x*x - meanSquare ) / count;
+   }
+
+   inline double Rms() const {
+      return std::sqrt( meanSquare );
+   }
+};
+typedef QVector<RunningStatistics> StatisticsVector;
+Q_DECLARE_METATYPE( StatisticsVector )
+
+#endif // RUNNING_STATISTICS_HPP
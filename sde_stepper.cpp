@@ -0,0 +1,242 @@
+#include "sde_stepper.hpp"
+
+SdeStepper::SdeStepper(
+   Method scheme
+ , DerivationVector diffusion_rules
+ , quint64 seed
+ , quint32 path
+) :
+   noise( seed )
+{
+   milstein       = scheme == Method::Milstein;
+   diffusionRules = diffusion_rules;
+   pathIndex      = path;
+   t = 0.0;
+   h = 0.0;
+}
+
+SdeStepper::~SdeStepper(
+){
+   FreeParsers();
+}
+
+void SdeStepper::FreeParsers(
+){
+   if( vars != NULL )
+      delete[] vars;
+   if( params != NULL )
+      delete[] params;
+   if( driftParser != NULL )
+      delete[] driftParser;
+   if( diffusionParser != NULL )
+      delete[] diffusionParser;
+   if( paramParser != NULL )
+      delete[] paramParser;
+   vars = NULL;
+   params = NULL;
+   driftParser = NULL;
+   diffusionParser = NULL;
+   paramParser = NULL;
+}
+
+void SdeStepper::SetConditions(
+   DerivationVector ddt_rules
+ , EquationVector param_rules
+ , PointValues val_init
+ , double timeSlice
+ , QMap<QString, int> rate_groups
+){
+   if( !rate_groups.isEmpty() )
+      std::cerr << "Ignoring rate groups: only the double precision Runge-Kutta stepper supports them." << std::endl;
+   if( ContainsDelayTerms( ddt_rules, param_rules ) ){
+      std::cerr << "Delay terms x(t - lag) need the double precision Runge-Kutta stepper." << std::endl;
+      exit( EXIT_FAILURE );
+   }
+
+   varCount   = ddt_rules.size();
+   paramCount = param_rules.size();
+
+   try {
+      FreeParsers();
+      vars   = new double[varCount];
+      params = new double[paramCount];
+      driftParser     = new mu::Parser[varCount];
+      diffusionParser = new mu::Parser[varCount];
+      paramParser     = new mu::Parser[paramCount];
+
+      // register symbols once; parsers look them up on demand
+      symbols.Clear();
+      symbols.Reserve( varCount + paramCount + 1 );
+      symbols.Define( "t", &t );
+      for( int j = 0; j < varCount; j++ )
+         symbols.Define( ddt_rules[j].first, &vars[j] );
+      for( int j = 0; j < paramCount; j++ )
+         symbols.Define( param_rules[j].first, &params[j] );
+
+      // set parsers; variables without noise have zero diffusion
+      for( int i = 0; i < varCount; i++ ){
+         symbols.Bind( driftParser[i] );
+         driftParser[i].SetExpr( ddt_rules[i].second.toStdString() );
+         symbols.Bind( diffusionParser[i] );
+         diffusionParser[i].SetExpr( i < diffusionRules.size() ? diffusionRules[i].second.toStdString() : "0" );
+      }
+      for( int i = 0; i < paramCount; i++ ){
+         symbols.Bind( paramParser[i] );
+         paramParser[i].SetExpr( param_rules[i].second.toStdString() );
+      }
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   init  = val_init;
+   h     = timeSlice;
+   steps = 0;
+   dW.fill( 0.0, varCount );
+
+   // calculate initial parameter values
+   init.Param.resize( paramCount );
+   t = init.T;
+   for( int i = 0; i < varCount; i++ )
+      vars[i] = init.Val[i];
+   try {
+      for( int i = 0; i < paramCount; i++ )
+         init.Param[i] = params[i] = paramParser[i].Eval();
+
+      // first evaluation compiles the expressions,
+      // so that errors are reported on load
+      for( int i = 0; i < varCount; i++ ){
+         driftParser[i].Eval();
+         diffusionParser[i].Eval();
+      }
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   previous = init;
+   current  = init;
+}
+
+PointValues SdeStepper::CalculateStep(
+){
+   previous = current;
+   current  = Step( current, pathIndex, steps++ );
+
+   return current;
+}
+
+PointValues SdeStepper::Step(
+   const PointValues &val_i
+ , quint32 path
+ , long long step
+){
+   // Wiener increments of this step, in pairs from one counter
+   double sqrtH = std::sqrt( h );
+   for( int i = 0; i < varCount; i += 2 ){
+      double z0, z1;
+      noise.Normal( path, (quint64)step, i / 2, z0, z1 );
+      dW[i] = sqrtH * z0;
+      if( i + 1 < varCount )
+         dW[i+1] = sqrtH * z1;
+   }
+
+   PointValues val_ip1;
+   val_ip1.T = val_i.T + h;
+   val_ip1.Val.resize( varCount );
+   val_ip1.Param.resize( paramCount );
+
+   try {
+      t = val_i.T;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = val_i.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         params[i] = val_i.Param[i];
+
+      evaluations++;
+      for( int i = 0; i < varCount; i++ ){
+         double g = diffusionParser[i].Eval();
+         double x = val_i.Val[i] + h * driftParser[i].Eval() + g * dW[i];
+         if( milstein && g != 0.0 ){
+            double dg = diffusionParser[i].Diff( &vars[i], vars[i] );
+            x += 0.5 * g * dg * ( dW[i]*dW[i] - h );
+         }
+         val_ip1.Val[i] = x;
+      }
+
+      // parameters at the new point
+      t = val_ip1.T;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = val_ip1.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         val_ip1.Param[i] = params[i] = paramParser[i].Eval();
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return val_ip1;
+}
+
+PointValues SdeStepper::InitialValues(
+){
+   return init;
+}
+
+double SdeStepper::DenseStartTime(
+){
+   return previous.T;
+}
+
+double SdeStepper::DenseEndTime(
+){
+   return current.T;
+}
+
+PointValues SdeStepper::DenseOutput(
+   double t_out
+){
+   if( steps == 0 )
+      return init;
+
+   double theta = ( t_out - previous.T ) / ( current.T - previous.T );
+
+   PointValues val;
+   val.T = t_out;
+   val.Val.resize( varCount );
+   val.Param.resize( paramCount );
+   for( int i = 0; i < varCount; i++ )
+      val.Val[i] = previous.Val[i] + theta * ( current.Val[i] - previous.Val[i] );
+
+   // parameters are evaluated at the interpolated point
+   try {
+      t = t_out;
+      for( int i = 0; i < varCount; i++ )
+         vars[i] = val.Val[i];
+      for( int i = 0; i < paramCount; i++ )
+         val.Param[i] = params[i] = paramParser[i].Eval();
+   } catch( mu::Parser::exception_type &e ){
+      ParserError( e );
+   }
+
+   return val;
+}
+
+bool SdeStepper::UpdateEquations(
+   DerivationVector /* ddt_rules */ // unused
+ , EquationVector /* param_rules */ // unused
+ , QString &error
+){
+   error = "stochastic problems can't be edited while running";
+   return false;
+}
+
+void SdeStepper::ParserError(
+   mu::ParserBase::exception_type &e
+){
+   std::cerr << std::endl << "Parsing error:" << std::endl;
+   std::cerr << "------" << std::endl;
+   std::cerr << "Message:  " << e.GetMsg()   << std::endl;
+   std::cerr << "Formula:  " << e.GetExpr()  << std::endl;
+   std::cerr << "Token:    " << e.GetToken() << std::endl;
+   std::cerr << "Position: " << e.GetPos()   << std::endl;
+   std::cerr << "Errcode:  " << e.GetCode()  << std::endl;
+   exit( EXIT_FAILURE );
+}
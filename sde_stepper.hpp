@@ -0,0 +1,90 @@
+#ifndef SDE_STEPPER_HPP
+#define SDE_STEPPER_HPP
+
+// Qt headers
+#include <QMap>
+#include <QString>
+
+// C headers
+#include <cstdlib>
+
+// C++ headers
+#include <iostream>
+#include <cmath>
+
+// math expression parsing header
+#include "muParser.h"
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "stepper.hpp"
+#include "symbol_table.hpp"
+#include "delay_history.hpp"
+#include "philox.hpp"
+
+// Stochastic stepper for dx_i = f_i dt + g_i dW_i, with the derivations
+// as drift f and one independent Wiener process per variable, scaled by
+// the diffusion g ([variable diffusion]). Euler-Maruyama, or Milstein,
+// which adds the g dg/dx_i correction; dg/dx_i is taken numerically with
+// the parameters held.
+// The noise of step n of path p comes from a Philox counter of (n, p),
+// so paths can be stepped in any order and on any thread.
+class SdeStepper : public Stepper
+{
+public:
+   SdeStepper( Method scheme
+             , DerivationVector diffusion_rules
+             , quint64 seed
+             , quint32 path = 0 );
+   ~SdeStepper();
+
+   void SetConditions( DerivationVector ddt_rules
+                     , EquationVector param_rules
+                     , PointValues val_init
+                     , double timeSlice
+                     , QMap<QString, int> rate_groups = QMap<QString, int>() ) override;
+
+   PointValues CalculateStep() override;
+   PointValues Step( const PointValues &val_i
+                   , quint32 path
+                   , long long step );
+
+   PointValues InitialValues() override;
+
+   // Brownian paths have no slope, output is interpolated linearly
+   double DenseStartTime() override;
+   double DenseEndTime() override;
+   PointValues DenseOutput( double t_out ) override;
+
+   bool UpdateEquations( DerivationVector ddt_rules
+                       , EquationVector param_rules
+                       , QString &error ) override;
+
+private:
+   int varCount = 0;
+   int paramCount = 0;
+   double t;
+   double *vars = NULL;
+   double *params = NULL;
+   mu::Parser *driftParser = NULL;
+   mu::Parser *diffusionParser = NULL;
+   mu::Parser *paramParser = NULL;
+   SymbolTable symbols;
+
+   bool milstein;
+   DerivationVector diffusionRules;
+   Philox4x32 noise;
+   quint32 pathIndex;
+   QVector<double> dW;
+
+   double h;
+   long long steps = 0;
+   PointValues init;
+   PointValues previous;
+   PointValues current;
+
+   void FreeParsers();
+   void ParserError( mu::Parser::exception_type &e );
+};
+
+#endif // SDE_STEPPER_HPP
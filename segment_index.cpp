@@ -0,0 +1,192 @@
+#include "segment_index.hpp"
+
+SegmentIndex::SegmentIndex(
+   QRectF area
+ , int segmentCapacity
+){
+   QRectF box = area.normalized();
+   cellWidth  = box.width()  > 0 ? box.width()  / CellsAcross : 1.0;
+   cellHeight = box.height() > 0 ? box.height() / CellsAcross : 1.0;
+
+   SetCapacity( segmentCapacity );
+}
+
+void SegmentIndex::Clear(
+){
+   cells.clear();
+   wide.clear();
+   first = end;
+}
+
+void SegmentIndex::SetCapacity(
+   int segmentCapacity
+){
+   capacity = std::max( 1, segmentCapacity );
+   ring.fill( QLineF(), capacity );
+   seen.fill( 0, capacity );
+   stamp = 0;
+   Clear();
+}
+
+void SegmentIndex::Append(
+   const QLineF &segment
+){
+   if( end - first == capacity )
+      EvictOldest();
+
+   ring[end % capacity] = segment;
+
+   int x0, y0, x1, y1;
+   if( Bucketed( Bounds( segment ), x0, y0, x1, y1 ) ){
+      for( int x = x0; x <= x1; x++ )
+         for( int y = y0; y <= y1; y++ )
+            cells[Key( x, y )].append( end );
+   } else {
+      wide.append( end );
+   }
+   end++;
+}
+
+void SegmentIndex::EvictOldest(
+){
+   if( first == end )
+      return;
+
+   // the oldest segment is at the front of every bucket it is in
+   int x0, y0, x1, y1;
+   if( Bucketed( Bounds( ring[first % capacity] ), x0, y0, x1, y1 ) ){
+      for( int x = x0; x <= x1; x++ ){
+         for( int y = y0; y <= y1; y++ ){
+            auto cell = cells.find( Key( x, y ) );
+            cell->removeFirst();
+            if( cell->isEmpty() )
+               cells.erase( cell );
+         }
+      }
+   } else {
+      wide.removeFirst();
+   }
+   first++;
+}
+
+int SegmentIndex::Count(
+) const {
+   return end - first;
+}
+
+qint64 SegmentIndex::NewestSerial(
+) const {
+   return end - 1;
+}
+
+const QLineF &SegmentIndex::Segment(
+   qint64 serial
+) const {
+   return ring[serial % capacity];
+}
+
+void SegmentIndex::Query(
+   const QRectF &rect
+ , QVector<qint64> &serials
+){
+   serials.clear();
+   QRectF area = rect.normalized();
+
+   if( ++stamp == 0 ){
+      seen.fill( 0 );
+      stamp = 1;
+   }
+
+   // closed interval test, so that horizontal and vertical segments count
+   auto add = [&]( qint64 serial ){
+      quint32 &mark = seen[serial % capacity];
+      if( mark == stamp )
+         return;
+      mark = stamp;
+      QRectF box = Bounds( ring[serial % capacity] );
+      if( box.left() <= area.right() && box.right() >= area.left()
+       && box.top() <= area.bottom() && box.bottom() >= area.top() )
+         serials.append( serial );
+   };
+
+   int x0, y0, x1, y1;
+   if( !CellRange( area, x0, y0, x1, y1 ) ){
+      // no cells that far out, check everything
+      for( qint64 serial = first; serial < end; serial++ )
+         add( serial );
+      return;
+   }
+
+   // visit whichever is fewer, the cells in the area or the occupied cells
+   qint64 areaCells = (qint64)( x1 - x0 + 1 ) * ( y1 - y0 + 1 );
+   if( areaCells > cells.size() ){
+      for( auto cell = cells.constBegin(); cell != cells.constEnd(); ++cell ){
+         int x = (qint32)( cell.key() >> 32 );
+         int y = (qint32)cell.key();
+         if( x >= x0 && x <= x1 && y >= y0 && y <= y1 )
+            for( qint64 serial : cell.value() )
+               add( serial );
+      }
+   } else {
+      for( int x = x0; x <= x1; x++ ){
+         for( int y = y0; y <= y1; y++ ){
+            auto cell = cells.constFind( Key( x, y ) );
+            if( cell != cells.constEnd() )
+               for( qint64 serial : cell.value() )
+                  add( serial );
+         }
+      }
+   }
+   for( qint64 serial : wide )
+      add( serial );
+
+   std::sort( serials.begin(), serials.end() );
+}
+
+bool SegmentIndex::CellRange(
+   const QRectF &box
+ , int &x0
+ , int &y0
+ , int &x1
+ , int &y1
+) const {
+   const double limit = 1 << 30;
+   double left   = std::floor( box.left()   / cellWidth );
+   double right  = std::floor( box.right()  / cellWidth );
+   double top    = std::floor( box.top()    / cellHeight );
+   double bottom = std::floor( box.bottom() / cellHeight );
+
+   // also false for NaN
+   if( !( left >= -limit && right <= limit && top >= -limit && bottom <= limit ) )
+      return false;
+
+   x0 = (int)left;
+   x1 = (int)right;
+   y0 = (int)top;
+   y1 = (int)bottom;
+   return true;
+}
+
+bool SegmentIndex::Bucketed(
+   const QRectF &box
+ , int &x0
+ , int &y0
+ , int &x1
+ , int &y1
+) const {
+   return CellRange( box, x0, y0, x1, y1 )
+       && (qint64)( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) <= MaxCells;
+}
+
+QRectF SegmentIndex::Bounds(
+   const QLineF &segment
+){
+   return QRectF( segment.p1(), segment.p2() ).normalized();
+}
+
+quint64 SegmentIndex::Key(
+   int x
+ , int y
+){
+   return (quint64)(quint32)x << 32 | (quint32)y;
+}
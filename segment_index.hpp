@@ -0,0 +1,82 @@
+#ifndef SEGMENT_INDEX_HPP
+#define SEGMENT_INDEX_HPP
+
+// Qt headers
+#include <QLineF>
+#include <QRectF>
+#include <QVector>
+#include <QList>
+#include <QHash>
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+
+// Trail segments in plot coordinates, bucketed in a uniform grid so that
+// drawing only visits the cells under the visible area.
+// Segments get consecutive serials; they are appended newest last and
+// evicted oldest first, so every bucket stays sorted by serial and both
+// operations only touch the front or back of the buckets they cover.
+// Segments covering more than MaxCells cells, or too far out to have a
+// cell, are kept in a separate list that every query checks.
+class SegmentIndex
+{
+public:
+   SegmentIndex( QRectF area
+               , int capacity = 1 );
+
+   // drops all segments; serials continue
+   void Clear();
+   void SetCapacity( int capacity );
+
+   // the oldest segment is evicted when full
+   void Append( const QLineF &segment );
+   void EvictOldest();
+
+   int Count() const;
+   qint64 NewestSerial() const;
+   const QLineF &Segment( qint64 serial ) const;
+
+   // serials of the segments whose bounding box meets rect, oldest first
+   void Query( const QRectF &rect
+             , QVector<qint64> &serials );
+
+private:
+   // cells across the area given to the constructor
+   static const int CellsAcross = 32;
+   // widest segment bucketed, in cells
+   static const int MaxCells = 64;
+
+   double cellWidth;
+   double cellHeight;
+
+   int capacity;
+   qint64 first = 0;
+   qint64 end = 0;
+   QVector<QLineF> ring;
+
+   // query stamp per ring slot, for segments found in several cells
+   QVector<quint32> seen;
+   quint32 stamp = 0;
+
+   QHash<quint64, QList<qint64>> cells;
+   QList<qint64> wide;
+
+   bool CellRange( const QRectF &box
+                 , int &x0
+                 , int &y0
+                 , int &x1
+                 , int &y1 ) const;
+   bool Bucketed( const QRectF &box
+                , int &x0
+                , int &y0
+                , int &x1
+                , int &y1 ) const;
+   static QRectF Bounds( const QLineF &segment );
+   static quint64 Key( int x
+                     , int y );
+};
+
+#endif // SEGMENT_INDEX_HPP
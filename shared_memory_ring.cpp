@@ -0,0 +1,109 @@
+#include "shared_memory_ring.hpp"
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // Q_OS_UNIX
+
+static_assert( sizeof( SharedMemoryRing::RingHeader ) == 128, "ring header must be 128 bytes" );
+static_assert( ATOMIC_LLONG_LOCK_FREE == 2, "ring needs lock-free 64-bit atomics" );
+
+SharedMemoryRing::SharedMemoryRing(
+   QString name
+ , QStringList varNames
+ , QStringList paramNames
+ , int capacity
+){
+   shmName    = name.startsWith( '/' ) ? name : "/" + name;
+   memory     = NULL;
+   memorySize = 0;
+   header     = NULL;
+   slots      = NULL;
+   sequence   = 0;
+
+#ifdef Q_OS_UNIX
+   QByteArray names = ( varNames + paramNames ).join( '\n' ).toUtf8() + '\n';
+   uint32_t namesSize  = ( names.size() + 63 ) / 64 * 64;
+   uint32_t recordSize = sizeof( uint64_t ) + ( 1 + varNames.size() + paramNames.size() ) * sizeof( double );
+   capacity   = capacity > 0 ? capacity : 1;
+   memorySize = sizeof( RingHeader ) + namesSize + (size_t)capacity * recordSize;
+
+   // replace a ring left over from an earlier run
+   shm_unlink( shmName.toUtf8().constData() );
+   int fd = shm_open( shmName.toUtf8().constData(), O_CREAT | O_EXCL | O_RDWR, 0644 );
+   if( fd < 0 ){
+      qDebug() << "WARNING: Can't create shared memory" << shmName << ":" << std::strerror( errno );
+      return;
+   }
+   if( ftruncate( fd, memorySize ) != 0 ){
+      qDebug() << "WARNING: Can't size shared memory" << shmName << ":" << std::strerror( errno );
+      close( fd );
+      shm_unlink( shmName.toUtf8().constData() );
+      return;
+   }
+   void *mapped = mmap( NULL, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+   close( fd );
+   if( mapped == MAP_FAILED ){
+      qDebug() << "WARNING: Can't map shared memory" << shmName << ":" << std::strerror( errno );
+      shm_unlink( shmName.toUtf8().constData() );
+      return;
+   }
+   memory = static_cast<uint8_t *>( mapped );
+
+   // fresh shared memory is zero filled, so all slots start out empty
+   header = new ( memory ) RingHeader;
+   std::memcpy( header->magic, "ODERING1", 8 );
+   header->headerSize = sizeof( RingHeader );
+   header->namesSize  = namesSize;
+   header->varCount   = varNames.size();
+   header->paramCount = paramNames.size();
+   header->recordSize = recordSize;
+   header->capacity   = capacity;
+   header->writeSequence.store( 0, std::memory_order_release );
+   std::memcpy( memory + sizeof( RingHeader ), names.constData(), names.size() );
+   slots = memory + sizeof( RingHeader ) + namesSize;
+#else
+   Q_UNUSED( varNames );
+   Q_UNUSED( paramNames );
+   Q_UNUSED( capacity );
+   qDebug() << "WARNING: Shared memory output is only available on POSIX systems.";
+#endif // Q_OS_UNIX
+}
+
+SharedMemoryRing::~SharedMemoryRing(
+){
+#ifdef Q_OS_UNIX
+   if( memory != NULL ){
+      munmap( memory, memorySize );
+      shm_unlink( shmName.toUtf8().constData() );
+   }
+#endif // Q_OS_UNIX
+}
+
+bool SharedMemoryRing::IsOpen(
+){
+   return memory != NULL;
+}
+
+void SharedMemoryRing::Write(
+   const PointValues &pv
+){
+   if( memory == NULL )
+      return;
+
+   uint8_t *slot = slots + ( sequence % header->capacity ) * header->recordSize;
+   std::atomic<uint64_t> *slotSequence = reinterpret_cast<std::atomic<uint64_t> *>( slot );
+   double *record = reinterpret_cast<double *>( slot + sizeof( uint64_t ) );
+
+   slotSequence->store( Busy, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_release );
+
+   record[0] = pv.T;
+   std::memcpy( record + 1,                       pv.Val.constData(),   header->varCount   * sizeof( double ) );
+   std::memcpy( record + 1 + header->varCount,    pv.Param.constData(), header->paramCount * sizeof( double ) );
+
+   slotSequence->store( sequence, std::memory_order_release );
+   header->writeSequence.store( ++sequence, std::memory_order_release );
+}
@@ -0,0 +1,73 @@
+#ifndef SHARED_MEMORY_RING_HPP
+#define SHARED_MEMORY_RING_HPP
+
+// Qt headers
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <QtDebug>
+
+// C headers
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+// C++ headers
+#include <atomic>
+#include <new>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+
+// Ring of step records in POSIX shared memory, for local readers that
+// want the data without copies or syscalls.
+//
+// Layout, native byte order:
+//   header     (RingHeader, 128 bytes)
+//   names      UTF-8, variable names then parameter names, one per line,
+//              padded to a multiple of 64 bytes
+//   slots      capacity x recordSize bytes; a slot is a uint64 sequence
+//              number followed by T, Val..., Param... as doubles
+//
+// Record n goes to slot n % capacity. The writer marks the slot busy
+// (sequence = UINT64_MAX), writes the data, stores n in the slot and then
+// n+1 in writeSequence. A reader of record n checks the slot sequence
+// before and after copying; if either differs from n, the record was
+// overwritten and the reader has fallen behind. Readers more than
+// `capacity` records behind writeSequence know that without looking.
+class SharedMemoryRing
+{
+public:
+   struct RingHeader {
+      char     magic[8];          // "ODERING1"
+      uint32_t headerSize;
+      uint32_t namesSize;
+      uint32_t varCount;
+      uint32_t paramCount;
+      uint32_t recordSize;
+      uint32_t capacity;
+      std::atomic<uint64_t> writeSequence;
+      char     reserved[88];
+   };
+
+   SharedMemoryRing( QString name
+                   , QStringList varNames
+                   , QStringList paramNames
+                   , int capacity );
+   ~SharedMemoryRing();
+
+   bool IsOpen();
+   void Write( const PointValues &pv );
+
+private:
+   static const uint64_t Busy = UINT64_MAX;
+
+   QString  shmName;
+   uint8_t *memory;
+   size_t   memorySize;
+   RingHeader *header;
+   uint8_t *slots;
+   uint64_t sequence;
+};
+
+#endif // SHARED_MEMORY_RING_HPP
@@ -3,11 +3,15 @@
 SimulationLoop::SimulationLoop(
    int maxFPS
  , int skipSteps
- , RungeKuttaStepper *stepperMethod
+ , double outputSpacing
+ , Stepper *stepperMethod
  , QObject */*parent*/ // unused
 ){
    minUpdateInterval = 1000 / maxFPS;
    skip = skipSteps;
+   spacing = outputSpacing;
+   outputStart = 0.0;
+   outputIndex = 0;
    stepper = stepperMethod;
 
    stateSuspend = false;
@@ -22,45 +26,186 @@ void SimulationLoop::run(
    updateTimer.start();
 
    while( true ){
-      while( stateSuspend && !stateExit ){
-         yieldCurrentThread();
-      }
-      if( stateExit )
+      if( !waitWhileSuspended() )
          return;
 
-      for( int i = 0; i < skip; i++ ){
-         stepper->CalculateStep();
-         while( stateSuspend && !stateExit ){
-            yieldCurrentThread();
-         }
-         if( stateExit )
-            return;
-      }
-      if( stateExit )
+      if( !nextOutput( pv ) )
+         return;
+      if( recorder != NULL )
+         recorder->Append( pv );
+      if( !waitWhileSuspended() )
          return;
 
-      pv = stepper->CalculateStep();
-      while( stateSuspend && !stateExit ){
-         yieldCurrentThread();
+      // density mode keeps integrating until the frame is due
+      while( density != NULL && !updateTimer.hasExpired( minUpdateInterval ) && !stateSuspend ){
+         if( !nextOutput( pv ) )
+            return;
+         if( recorder != NULL )
+            recorder->Append( pv );
       }
-      if( stateExit )
-         return;
 
       // limit update rate
-      while( ( !updateTimer.hasExpired( minUpdateInterval ) || stateSuspend ) && !stateExit ){
+      while( !updateTimer.hasExpired( minUpdateInterval ) && !stateExit ){
          long sleepDuration = minUpdateInterval-updateTimer.elapsed();
          sleepDuration = sleepDuration > 0 ? sleepDuration : 1;
          msleep( sleepDuration );
       }
 
-      if( stateExit )
+      if( !waitWhileSuspended() )
          return;
 
       // run update
       //qDebug() << "timer: " << updateTimer.elapsed() << " of " << minUpdateInterval << ", yield # = " << yields;
+      if( density != NULL )
+         density->Merge();
       emit updateView( pv );
       updateTimer.start();
+
+      if( !statIndices.isEmpty() && statTimer.hasExpired( minStatInterval ) ){
+         emit updateStatistics( stats );
+         statTimer.start();
+      }
+   }
+}
+
+void SimulationLoop::setParareal(
+   PararealSolver *solver
+ , int maxIterations
+ , double tolerance
+){
+   parareal = solver;
+   pararealIterations = maxIterations;
+   pararealTolerance = tolerance;
+   pararealIndex = -1;
+}
+
+void SimulationLoop::setEnsemble(
+   EnsembleSolver *solver
+){
+   ensemble = solver;
+}
+
+void SimulationLoop::setRecorder(
+   TrajectoryStore *store
+){
+   recorder = store;
+}
+
+void SimulationLoop::setPublisher(
+   TrajectoryPublisher *stream
+){
+   publisher = stream;
+}
+
+void SimulationLoop::setSharedRing(
+   SharedMemoryRing *ring
+){
+   sharedRing = ring;
+}
+
+void SimulationLoop::setDensity(
+   DensityHistogram::Accumulator *accumulator
+){
+   density = accumulator;
+}
+
+void SimulationLoop::setStatistics(
+   QVector<int> paramIndices
+ , int maxFPS
+){
+   statIndices = paramIndices;
+   stats.fill( RunningStatistics(), statIndices.size() );
+   minStatInterval = 1000 / ( maxFPS > 0 ? maxFPS : 1 );
+   statTimer.start();
+}
+
+PointValues SimulationLoop::step(
+){
+   PointValues pv = stepper->CalculateStep();
+   observeStep( pv );
+
+   return pv;
+}
+
+void SimulationLoop::observeStep(
+   const PointValues &pv
+){
+   for( int j = 0; j < statIndices.size(); j++ ){
+      stats[j].Add( pv.Param[statIndices[j]] );
    }
+
+   if( publisher != NULL )
+      publisher->Publish( pv );
+   if( sharedRing != NULL )
+      sharedRing->Write( pv );
+   if( density != NULL )
+      density->Add( pv );
+}
+
+bool SimulationLoop::nextOutput(
+   PointValues &pv
+){
+   if( parareal != NULL ){
+      if( pararealIndex < 0 ){
+         emit statusMessage( tr("Parareal: solving...") );
+         QElapsedTimer solveTimer;
+         solveTimer.start();
+         int iterations = parareal->Solve( pararealIterations, pararealTolerance );
+         if( stateExit )
+            return false;
+         emit statusMessage( tr("Parareal: %1 iterations, correction %2, %3 ms.")
+                                .arg( iterations )
+                                .arg( parareal->Correction() )
+                                .arg( solveTimer.elapsed() ) );
+         pararealPath = parareal->Trajectory();
+         pararealIndex = 0;
+      }
+
+      // play back the solution, stop at t_end
+      if( pararealIndex >= pararealPath.size() )
+         return false;
+      pv = pararealPath[pararealIndex++];
+      observeStep( pv );
+      return true;
+   }
+
+   if( ensemble != NULL ){
+      EnsembleBand band;
+      pv = ensemble->Advance( band );
+      if( stateExit )
+         return false;
+      observeStep( pv );
+      emit updateBand( band );
+      return true;
+   }
+
+   if( spacing <= 0 ){
+      // output the raw step endpoints
+      for( int i = 0; i < skip; i++ ){
+         step();
+         if( !waitWhileSuspended() )
+            return false;
+      }
+      if( stateExit )
+         return false;
+
+      pv = step();
+      return true;
+   }
+
+   // output on a uniform time grid, interpolating within the last step
+   if( outputIndex == 0 )
+      outputStart = stepper->DenseEndTime();
+   double tOut = outputStart + ( ++outputIndex ) * spacing;
+
+   while( stepper->DenseEndTime() < tOut ){
+      step();
+      if( !waitWhileSuspended() )
+         return false;
+   }
+
+   pv = stepper->DenseOutput( tOut );
+   return true;
 }
 
 void SimulationLoop::suspend(
@@ -70,18 +215,28 @@ void SimulationLoop::suspend(
 
 void SimulationLoop::resume(
 ){
+   QMutexLocker lock( &stateMutex );
    stateSuspend = false;
+   stateChanged.wakeAll();
 }
 
 void SimulationLoop::stop(
 ){
+   QMutexLocker lock( &stateMutex );
    stateExit = true;
+   stateChanged.wakeAll();
+   if( parareal != NULL )
+      parareal->Abort();
+   if( ensemble != NULL )
+      ensemble->Abort();
 }
 
-void SimulationLoop::checkState(
+bool SimulationLoop::waitWhileSuspended(
 ){
-   while( stateSuspend ){
-      if( stateExit ) exit();
-      yieldCurrentThread();
-   }
+   // sleep instead of spinning, so paused problems leave their core free
+   QMutexLocker lock( &stateMutex );
+   while( stateSuspend && !stateExit )
+      stateChanged.wait( &stateMutex );
+
+   return !stateExit;
 }
@@ -6,10 +6,22 @@
 #include <QThread>
 #include <QtDebug>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+
+// C++ headers
+#include <atomic>
 
 // Local headers
 #include "ode_pathtracer.hpp"
-#include "runge_kutta_stepper.hpp"
+#include "stepper.hpp"
+#include "parareal_solver.hpp"
+#include "ensemble_solver.hpp"
+#include "trajectory_store.hpp"
+#include "running_statistics.hpp"
+#include "trajectory_publisher.hpp"
+#include "shared_memory_ring.hpp"
+#include "density_histogram.hpp"
 
 class SimulationLoop : public QThread
 {
@@ -18,24 +30,70 @@ class SimulationLoop : public QThread
 public:
    explicit SimulationLoop( int maxFPS
                           , int skipSteps
-                          , RungeKuttaStepper *rk
+                          , double outputSpacing
+                          , Stepper *rk
                           , QObject *parent = 0 );
    void run() Q_DECL_OVERRIDE;
    void suspend();
    void resume();
    void stop();
+   void setParareal( PararealSolver *solver
+                   , int maxIterations
+                   , double tolerance );
+   void setEnsemble( EnsembleSolver *solver );
+   void setRecorder( TrajectoryStore *store );
+   void setPublisher( TrajectoryPublisher *stream );
+   void setSharedRing( SharedMemoryRing *ring );
+   void setDensity( DensityHistogram::Accumulator *accumulator );
+   void setStatistics( QVector<int> paramIndices
+                     , int maxFPS );
 
 signals:
    void updateView( PointValues newPoint );
+   void updateBand( EnsembleBand band );
+   void statusMessage( QString message );
+   void updateStatistics( StatisticsVector statistics );
 
 private:
    int minUpdateInterval;
    int skip;
-   bool stateSuspend;
-   bool stateExit;
-   RungeKuttaStepper *stepper;
+   double spacing;
+   double outputStart;
+   long long outputIndex;
+   std::atomic<bool> stateSuspend;
+   std::atomic<bool> stateExit;
+   QMutex stateMutex;
+   QWaitCondition stateChanged;
+   Stepper *stepper;
+   TrajectoryStore *recorder = NULL;
+   TrajectoryPublisher *publisher = NULL;
+   SharedMemoryRing *sharedRing = NULL;
+
+   // density mode: every step is counted, and the time between
+   // frames is spent integrating instead of sleeping
+   DensityHistogram::Accumulator *density = NULL;
+
+   // statistics over every step
+   QVector<int> statIndices;
+   StatisticsVector stats;
+   int minStatInterval;
+   QElapsedTimer statTimer;
+
+   // parallel-in-time mode: solve first, then play back
+   PararealSolver *parareal = NULL;
+   int pararealIterations;
+   double pararealTolerance;
+   QVector<PointValues> pararealPath;
+   int pararealIndex;
+
+   // ensemble mode: the mean point is the output, the band goes
+   // to the views
+   EnsembleSolver *ensemble = NULL;
 
-   void checkState();
+   bool waitWhileSuspended();
+   bool nextOutput( PointValues &pv );
+   PointValues step();
+   void observeStep( const PointValues &pv );
 };
 
 #endif // SIMULATION_LOOP_HPP
@@ -0,0 +1,116 @@
+#include "stepper.hpp"
+
+// Local headers
+#include "runge_kutta_stepper.hpp"
+#include "precision_stepper.hpp"
+#include "taylor_stepper.hpp"
+#include "double_double.hpp"
+
+Stepper *CreateStepper(
+   Precision precision
+ , Method method
+ , double tolerance
+){
+   if( method == Method::Taylor ){
+      switch( precision ){
+      case Precision::Float:        return new TaylorStepper<float>( tolerance );
+      case Precision::Double:       return new TaylorStepper<double>( tolerance );
+      case Precision::LongDouble:   return new TaylorStepper<long double>( tolerance );
+      case Precision::DoubleDouble: return new TaylorStepper<DoubleDouble>( tolerance );
+      }
+   }
+
+   switch( precision ){
+   case Precision::Float:
+      return new PrecisionStepper<float>( method );
+   case Precision::LongDouble:
+      return new PrecisionStepper<long double>( method );
+   case Precision::DoubleDouble:
+      return new PrecisionStepper<DoubleDouble>( method );
+   case Precision::Double:
+      break;
+   }
+
+   return new RungeKuttaStepper( method );
+}
+
+bool PrecisionFromName(
+   QString name
+ , Precision &precision
+){
+   name = name.trimmed().toLower();
+   if( name == "float" || name == "single" ){
+      precision = Precision::Float;
+   } else if( name == "double" ){
+      precision = Precision::Double;
+   } else if( name == "long double" || name == "extended" ){
+      precision = Precision::LongDouble;
+   } else if( name == "double-double" || name == "double double" || name == "dd" ){
+      precision = Precision::DoubleDouble;
+   } else {
+      return false;
+   }
+
+   return true;
+}
+
+QString PrecisionName(
+   Precision precision
+){
+   switch( precision ){
+   case Precision::Float:        return "float";
+   case Precision::Double:       return "double";
+   case Precision::LongDouble:   return "long double";
+   case Precision::DoubleDouble: return "double-double";
+   }
+
+   return QString();
+}
+
+bool MethodFromName(
+   QString name
+ , Method &method
+){
+   name = name.trimmed().toLower();
+   if( name == "euler" ){
+      method = Method::Euler;
+   } else if( name == "heun" ){
+      method = Method::Heun;
+   } else if( name == "rk3" ){
+      method = Method::RungeKutta3;
+   } else if( name == "rk4" || name == "runge-kutta" ){
+      method = Method::RungeKutta4;
+   } else if( name == "rk38" || name == "3/8" ){
+      method = Method::RungeKutta38;
+   } else if( name == "rk6" ){
+      method = Method::RungeKutta6;
+   } else if( name == "taylor" ){
+      method = Method::Taylor;
+   } else if( name == "euler-maruyama" || name == "em" ){
+      method = Method::EulerMaruyama;
+   } else if( name == "milstein" ){
+      method = Method::Milstein;
+   } else {
+      return false;
+   }
+
+   return true;
+}
+
+QString MethodName(
+   Method method
+){
+   switch( method ){
+   case Method::Euler:         return "euler";
+   case Method::Heun:          return "heun";
+   case Method::RungeKutta3:   return "rk3";
+   case Method::RungeKutta4:   return "rk4";
+   case Method::RungeKutta38:  return "rk38";
+   case Method::RungeKutta6:   return "rk6";
+   case Method::Taylor:        return "taylor";
+   case Method::EulerMaruyama: return "euler-maruyama";
+   case Method::Milstein:      return "milstein";
+   }
+
+   return QString();
+}
@@ -0,0 +1,83 @@
+#ifndef STEPPER_HPP
+#define STEPPER_HPP
+
+// Qt headers
+#include <QMap>
+#include <QString>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+
+enum class Precision{
+   Float
+ , Double
+ , LongDouble
+ , DoubleDouble
+};
+
+enum class Method{
+   Euler
+ , Heun
+ , RungeKutta3
+ , RungeKutta4
+ , RungeKutta38
+ , RungeKutta6
+ , Taylor
+ , EulerMaruyama
+ , Milstein
+};
+
+// Integrator as used by the simulation loop and the exporter. The state
+// is kept inside, in the stepper's own precision; points are handed out
+// as doubles.
+class Stepper
+{
+public:
+   virtual ~Stepper() {}
+
+   virtual void SetConditions( DerivationVector ddt_rules
+                             , EquationVector param_rules
+                             , PointValues val_init
+                             , double timeSlice
+                             , QMap<QString, int> rate_groups = QMap<QString, int>() ) = 0;
+
+   virtual PointValues CalculateStep() = 0;
+   virtual PointValues InitialValues() = 0;
+
+   // continuous output between the endpoints of the last step
+   virtual double DenseStartTime() = 0;
+   virtual double DenseEndTime() = 0;
+   virtual PointValues DenseOutput( double t_out ) = 0;
+
+   // live editing, see RungeKuttaStepper
+   virtual bool UpdateEquations( DerivationVector ddt_rules
+                               , EquationVector param_rules
+                               , QString &error ) = 0;
+
+   virtual void EnableParallelDerivatives( int /*threads*/ ) {}
+
+   // right-hand side evaluations so far, for cost measurements; a
+   // Taylor step counts one per series coefficient
+   qint64 Evaluations() const { return evaluations; }
+
+protected:
+   qint64 evaluations = 0;
+};
+
+// double Runge-Kutta runs use the muParser stepper, everything else the
+// expression evaluator compiled for the precision; tolerance is used by
+// adaptive methods, explicit Runge-Kutta methods step with a fixed dt;
+// the stochastic methods need the noise terms, see SdeStepper.
+// Rate groups, delay terms, parallel derivatives and parareal exist only
+// in the muParser stepper, so only in double precision Runge-Kutta runs
+Stepper *CreateStepper( Precision precision
+                      , Method method = Method::RungeKutta4
+                      , double tolerance = 1e-15 );
+bool PrecisionFromName( QString name
+                      , Precision &precision );
+QString PrecisionName( Precision precision );
+bool MethodFromName( QString name
+                   , Method &method );
+QString MethodName( Method method );
+
+#endif // STEPPER_HPP
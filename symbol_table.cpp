@@ -0,0 +1,56 @@
+#include "symbol_table.hpp"
+
+SymbolTable::SymbolTable(
+){
+   // stub
+}
+
+void SymbolTable::Clear(
+){
+   symbols.clear();
+}
+
+void SymbolTable::Reserve(
+   int size
+){
+   symbols.reserve( size );
+}
+
+void SymbolTable::Define(
+   QString name
+ , double *address
+){
+   symbols.insert( name, address );
+}
+
+bool SymbolTable::Contains(
+   QString name
+) const {
+   return symbols.contains( name );
+}
+
+int SymbolTable::Size(
+) const {
+   return symbols.size();
+}
+
+void SymbolTable::Bind(
+   mu::Parser &parser
+){
+   // unknown tokens are handed to the factory, which looks them up here
+   parser.SetVarFactory( Resolve, this );
+}
+
+double *SymbolTable::Resolve(
+   const mu::char_type *name
+ , void *table
+){
+   SymbolTable *self = static_cast<SymbolTable *>( table );
+
+   auto it = self->symbols.constFind( QString::fromUtf8( name ) );
+   if( it == self->symbols.constEnd() ){
+      throw mu::Parser::exception_type( "Undefined symbol \"$TOK$\".", -1, name );
+   }
+
+   return it.value();
+}
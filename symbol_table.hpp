@@ -0,0 +1,33 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+// Qt headers
+#include <QHash>
+#include <QString>
+
+// math expression parsing header
+#include "muParser.h"
+
+// Name -> storage mapping shared by all parsers of a problem.
+// Parsers bound to the table resolve symbols lazily, on first evaluation,
+// so each parser only references the symbols its expression uses.
+class SymbolTable
+{
+public:
+   SymbolTable( void );
+
+   void Clear();
+   void Reserve( int size );
+   void Define( QString name, double *address );
+   bool Contains( QString name ) const;
+   int  Size() const;
+
+   void Bind( mu::Parser &parser );
+
+private:
+   QHash<QString, double *> symbols;
+
+   static double *Resolve( const mu::char_type *name, void *table );
+};
+
+#endif // SYMBOL_TABLE_HPP
@@ -0,0 +1,145 @@
+#include "taylor_stepper.hpp"
+
+// Local headers
+#include "double_double.hpp"
+
+template <typename Scalar>
+TaylorStepper<Scalar>::TaylorStepper(
+   double stepTolerance
+) :
+   PrecisionStepper<Scalar>( Method::RungeKutta4, Expression<Scalar>::SeriesLength )
+{
+   tolerance = stepTolerance > 0 ? stepTolerance : 1e-15;
+   order = 2;
+}
+
+template <typename Scalar>
+PointValues TaylorStepper<Scalar>::DenseOutput(
+   double t_out
+){
+   if( !denseValid )
+      return init;
+
+   Scalar dt = Scalar( t_out ) - denseT0;
+   std::vector<Scalar> val( varCount );
+   std::vector<Scalar> param( paramCount );
+   for( int i = 0; i < varCount; i++ )
+      val[i] = Sum( &denseSeries[i*Length], order + 1, dt );
+   for( int i = 0; i < paramCount; i++ )
+      param[i] = Sum( &denseSeries[( varCount + i )*Length], order, dt );
+
+   return this->ToPoint( Scalar( t_out ), val, param );
+}
+
+template <typename Scalar>
+void TaylorStepper<Scalar>::Step(
+){
+   // t and the variables start the series at the current point
+   Scalar *time = this->TimeSymbol();
+   time[0] = stateT;
+   time[1] = Scalar( 1 );
+   for( int k = 2; k <= Expression<Scalar>::MaxSeriesOrder; k++ )
+      time[k] = Scalar( 0 );
+   for( int i = 0; i < varCount; i++ )
+      this->VarSymbol( i )[0] = stateVal[i];
+
+   // error per step, relative for large values
+   double norm = 0;
+   for( int i = 0; i < varCount; i++ )
+      norm = std::max( norm, std::abs( static_cast<double>( stateVal[i] ) ) );
+   double epsilon = tolerance * std::max( 1.0, norm );
+
+   // one order at a time: parameters, then the next variable coefficient.
+   // The order is raised while the work per unit time, order^2 / step for
+   // the recurrences, keeps falling; one more order may still pay off
+   // when the coefficients decay unevenly
+   double step = static_cast<double>( h );
+   double bestCost = std::numeric_limits<double>::infinity();
+   order = 0;
+   for( int k = 0; k < Expression<Scalar>::MaxSeriesOrder; k++ ){
+      for( int i = 0; i < paramCount; i++ )
+         this->ParamSymbol( i )[k] = paramExpr[i].EvalCoefficient( k );
+      for( int i = 0; i < varCount; i++ )
+         this->VarSymbol( i )[k+1] = varExpr[i].EvalCoefficient( k ) / Scalar( (double)( k + 1 ) );
+      this->evaluations++;
+
+      int p = k + 1;
+      if( p < 2 )
+         continue;
+      double pStep = StepSize( p, epsilon );
+      double cost = p * p / pStep;
+      if( cost < bestCost ){
+         bestCost = cost;
+         order = p;
+         step  = pStep;
+      } else if( p >= order + 2 ){
+         break;
+      }
+      // the coefficients decay fast enough for the longest step
+      if( pStep >= static_cast<double>( h ) )
+         break;
+   }
+
+   // keep the series for dense output
+   denseSeries.resize( ( varCount + paramCount ) * Length );
+   for( int i = 0; i < varCount; i++ )
+      std::copy( this->VarSymbol( i ), this->VarSymbol( i ) + order + 1, &denseSeries[i*Length] );
+   for( int i = 0; i < paramCount; i++ )
+      std::copy( this->ParamSymbol( i ), this->ParamSymbol( i ) + order, &denseSeries[( varCount + i )*Length] );
+
+   Scalar dt( step );
+   std::vector<Scalar> y( varCount );
+   for( int i = 0; i < varCount; i++ )
+      y[i] = Sum( &denseSeries[i*Length], order + 1, dt );
+
+   denseT0 = stateT;
+   denseT1 = stateT + dt;
+   denseValid = true;
+
+   // parameters at the new point
+   this->LoadPoint( denseT1, y.data() );
+   stateVal   = y;
+   stateParam = this->CurrentParams();
+   stateT     = denseT1;
+   steps++;
+}
+
+template <typename Scalar>
+double TaylorStepper<Scalar>::StepSize(
+   int p
+ , double epsilon
+){
+   // longest step whose terms p-1 and p stay below epsilon, no longer than dt
+   double step = static_cast<double>( h );
+   for( int k = p - 1; k <= p; k++ ){
+      double coefficient = 0;
+      for( int i = 0; i < varCount; i++ )
+         coefficient = std::max( coefficient, std::abs( static_cast<double>( this->VarSymbol( i )[k] ) ) );
+      if( coefficient > 0 )
+         step = std::min( step, std::pow( epsilon / coefficient, 1.0 / k ) );
+   }
+   // singular series, fall back to the fixed step
+   if( !( step > 0 ) || !std::isfinite( step ) )
+      step = static_cast<double>( h );
+
+   return step;
+}
+
+template <typename Scalar>
+Scalar TaylorStepper<Scalar>::Sum(
+   const Scalar *coefficients
+ , int count
+ , const Scalar &dt
+){
+   // Horner's scheme
+   Scalar sum( 0 );
+   for( int k = count - 1; k >= 0; k-- )
+      sum = sum * dt + coefficients[k];
+
+   return sum;
+}
+
+template class TaylorStepper<float>;
+template class TaylorStepper<double>;
+template class TaylorStepper<long double>;
+template class TaylorStepper<DoubleDouble>;
@@ -0,0 +1,68 @@
+#ifndef TAYLOR_STEPPER_HPP
+#define TAYLOR_STEPPER_HPP
+
+// C headers
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+#include <vector>
+#include <limits>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "precision_stepper.hpp"
+
+// Taylor series stepper. The derivations are differentiated automatically:
+// every step computes the Taylor coefficients of the solution one order
+// at a time, and takes the longest step whose last two terms stay below
+// the tolerance (Jorba & Zou), but no longer than dt. The order is chosen
+// per step from the decay of the coefficients: it stops growing when the
+// work per unit time does, which for evenly decaying series is the
+// Jorba & Zou order, or as soon as the step reaches dt.
+// The series also give the dense output.
+// Parameters referring to parameters after them see the last values of
+// those, as in LoadPoint().
+template <typename Scalar>
+class TaylorStepper : public PrecisionStepper<Scalar>
+{
+public:
+   explicit TaylorStepper( double tolerance );
+
+   PointValues DenseOutput( double t_out ) override;
+
+protected:
+   void Step() override;
+
+private:
+   using Base = PrecisionStepper<Scalar>;
+   using Base::varCount;
+   using Base::paramCount;
+   using Base::varExpr;
+   using Base::paramExpr;
+   using Base::init;
+   using Base::h;
+   using Base::steps;
+   using Base::stateT;
+   using Base::stateVal;
+   using Base::stateParam;
+   using Base::denseValid;
+   using Base::denseT0;
+   using Base::denseT1;
+
+   static const int Length = Expression<Scalar>::SeriesLength;
+
+   double tolerance;
+   int order;                // of the last step
+
+   // coefficients of the last step, variables then parameters
+   std::vector<Scalar> denseSeries;
+
+   double StepSize( int p
+                  , double epsilon );
+   Scalar Sum( const Scalar *coefficients
+             , int count
+             , const Scalar &dt );
+};
+
+#endif // TAYLOR_STEPPER_HPP
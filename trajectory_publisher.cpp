@@ -0,0 +1,306 @@
+#include "trajectory_publisher.hpp"
+
+TrajectoryPublisher::TrajectoryPublisher(
+   QStringList varNames
+ , QStringList paramNames
+ , QString localName
+ , quint16 tcpPort
+ , int stride
+ , int batchSize
+ , int queueLength
+ , QObject */*parent*/ // unused
+){
+   vars   = varNames;
+   params = paramNames;
+   localServerName = localName;
+   port = tcpPort;
+   decimation   = stride      > 0 ? stride      : 1;
+   batchRecords = batchSize   > 0 ? batchSize   : 1;
+   maxQueue     = queueLength > 0 ? queueLength : 1;
+
+   stepCount  = 0;
+   batchFirst = 0;
+   batchCount = 0;
+   flushPending = false;
+   stateExit    = false;
+   clientCount  = 0;
+}
+
+TrajectoryPublisher::~TrajectoryPublisher(
+){
+   stop();
+   quit();
+   wait();
+}
+
+void TrajectoryPublisher::run(
+){
+   // sockets live in this thread, the simulation only fills queues
+   QObject context;
+   QLocalServer *localServer = NULL;
+   QTcpServer   *tcpServer   = NULL;
+
+   if( !localServerName.isEmpty() ){
+      localServer = new QLocalServer( &context );
+      QLocalServer::removeServer( localServerName );
+      if( localServer->listen( localServerName ) ){
+         connect( localServer, &QLocalServer::newConnection, &context, [this, localServer](){
+            while( localServer->hasPendingConnections() ){
+               QLocalSocket *socket = localServer->nextPendingConnection();
+               connect( socket, &QLocalSocket::disconnected, socket, [this, socket](){
+                  removeClient( socket );
+               } );
+               addClient( socket );
+            }
+         } );
+      } else {
+         qDebug() << "WARNING: Can't listen on" << localServerName << ":" << localServer->errorString();
+      }
+   }
+
+   if( port != 0 ){
+      tcpServer = new QTcpServer( &context );
+      if( tcpServer->listen( QHostAddress::LocalHost, port ) ){
+         connect( tcpServer, &QTcpServer::newConnection, &context, [this, tcpServer](){
+            while( tcpServer->hasPendingConnections() ){
+               QTcpSocket *socket = tcpServer->nextPendingConnection();
+               connect( socket, &QTcpSocket::disconnected, socket, [this, socket](){
+                  removeClient( socket );
+               } );
+               addClient( socket );
+            }
+         } );
+      } else {
+         qDebug() << "WARNING: Can't listen on port" << port << ":" << tcpServer->errorString();
+      }
+   }
+
+   {
+      QMutexLocker lock( &clientsMutex );
+      loopContext = &context;
+   }
+
+   exec();
+
+   // send what is still queued, the last batch included, before the
+   // sockets go away with the context
+   QElapsedTimer drainTimer;
+   drainTimer.start();
+   while( !drainTimer.hasExpired( DrainTimeout ) ){
+      flushClients();
+      bool pending = false;
+      QList<ClientPointer> targets;
+      {
+         QMutexLocker lock( &clientsMutex );
+         targets = clients;
+      }
+      for( auto client : targets ){
+         {
+            QMutexLocker clientLock( &client->mutex );
+            pending = pending || !client->queue.isEmpty();
+         }
+         if( client->socket->bytesToWrite() > 0 ){
+            pending = true;
+            client->socket->waitForBytesWritten( 100 );
+         }
+      }
+      if( !pending )
+         break;
+   }
+
+   // release blocked producers and drop all clients
+   QMutexLocker lock( &clientsMutex );
+   loopContext = NULL;
+   for( auto client : clients ){
+      QMutexLocker clientLock( &client->mutex );
+      client->closed = true;
+      client->notFull.wakeAll();
+   }
+   clients.clear();
+   clientCount = 0;
+}
+
+void TrajectoryPublisher::stop(
+){
+   stateExit = true;
+   {
+      QMutexLocker lock( &clientsMutex );
+      for( auto client : clients ){
+         QMutexLocker clientLock( &client->mutex );
+         client->notFull.wakeAll();
+      }
+   }
+}
+
+void TrajectoryPublisher::Publish(
+   const PointValues &pv
+){
+   if( stepCount++ % decimation != 0 )
+      return;
+
+   // nobody is listening
+   if( clientCount.load() == 0 ){
+      batchCount = 0;
+      batch.clear();
+      return;
+   }
+
+   if( batchCount == 0 ){
+      batchFirst = stepCount - 1;
+      batch.reserve( batchRecords * ( 1 + vars.size() + params.size() ) * sizeof( double ) );
+   }
+   batch.append( reinterpret_cast<const char *>( &pv.T ), sizeof( double ) );
+   batch.append( reinterpret_cast<const char *>( pv.Val.constData() ),   pv.Val.size()   * sizeof( double ) );
+   batch.append( reinterpret_cast<const char *>( pv.Param.constData() ), pv.Param.size() * sizeof( double ) );
+   batchCount++;
+
+   if( batchCount >= batchRecords )
+      FlushBatch();
+}
+
+void TrajectoryPublisher::FlushBatch(
+){
+   if( batchCount == 0 )
+      return;
+
+   Frame frame;
+   frame.first   = batchFirst;
+   frame.records = batchCount;
+   frame.payload = batch;
+   batch.clear();
+   batchCount = 0;
+
+   QList<ClientPointer> targets;
+   {
+      QMutexLocker lock( &clientsMutex );
+      targets = clients;
+   }
+
+   for( auto client : targets ){
+      QMutexLocker lock( &client->mutex );
+      // a blocking client holds the producer until its queue has room;
+      // flushClients() wakes us for every frame it sends, the timeout
+      // only rechecks whether the client closed or we are stopping
+      while( client->blocking && client->queue.size() >= maxQueue && !client->closed && !stateExit ){
+         client->notFull.wait( &client->mutex, 100 );
+      }
+      if( client->closed )
+         continue;
+      if( client->queue.size() >= maxQueue ){
+         client->dropped++;
+         continue;
+      }
+      client->queue.enqueue( frame );
+   }
+
+   requestFlush();
+}
+
+QByteArray TrajectoryPublisher::helloFrame(
+){
+   QJsonObject layout;
+   layout["variables"]  = QJsonArray::fromStringList( vars );
+   layout["parameters"] = QJsonArray::fromStringList( params );
+   layout["stride"]     = decimation;
+   QByteArray json = QJsonDocument( layout ).toJson( QJsonDocument::Compact );
+
+   QByteArray hello( "ODEH" );
+   quint32 length = json.size();
+   hello.append( reinterpret_cast<const char *>( &length ), sizeof( length ) );
+   hello.append( json );
+
+   return hello;
+}
+
+void TrajectoryPublisher::addClient(
+   QIODevice *socket
+){
+   ClientPointer client( new Client );
+   client->socket = socket;
+   socket->write( helloFrame() );
+
+   // the client chooses its overflow policy
+   connect( socket, &QIODevice::readyRead, socket, [client](){
+      QByteArray request = client->socket->readAll();
+      QMutexLocker lock( &client->mutex );
+      if( request.contains( 'B' ) ) client->blocking = true;
+      if( request.contains( 'D' ) ) client->blocking = false;
+      client->notFull.wakeAll();
+   } );
+   connect( socket, &QIODevice::bytesWritten, socket, [this](){
+      flushClients();
+   } );
+
+   QMutexLocker lock( &clientsMutex );
+   clients.append( client );
+   clientCount = clients.size();
+}
+
+void TrajectoryPublisher::removeClient(
+   QIODevice *socket
+){
+   QMutexLocker lock( &clientsMutex );
+   for( int i = 0; i < clients.size(); i++ ){
+      if( clients[i]->socket != socket )
+         continue;
+
+      QMutexLocker clientLock( &clients[i]->mutex );
+      clients[i]->closed = true;
+      clients[i]->notFull.wakeAll();
+      clientLock.unlock();
+
+      clients.removeAt( i );
+      break;
+   }
+   clientCount = clients.size();
+   socket->deleteLater();
+}
+
+void TrajectoryPublisher::flushClients(
+){
+   QList<ClientPointer> targets;
+   {
+      QMutexLocker lock( &clientsMutex );
+      targets = clients;
+   }
+
+   // move queued frames to the sockets, but only as fast as they drain,
+   // so that slow clients fill their queue instead of our memory
+   for( auto client : targets ){
+      while( client->socket->bytesToWrite() < MaxBytesToWrite ){
+         Frame frame;
+         quint64 dropped;
+         {
+            QMutexLocker lock( &client->mutex );
+            if( client->queue.isEmpty() )
+               break;
+            frame   = client->queue.dequeue();
+            dropped = client->dropped;
+            client->notFull.wakeAll();
+         }
+
+         quint32 counts[3] = { frame.records, (quint32)vars.size(), (quint32)params.size() };
+         quint64 sequence[2] = { frame.first, dropped };
+         client->socket->write( "ODEF", 4 );
+         client->socket->write( reinterpret_cast<const char *>( counts ),   sizeof( counts ) );
+         client->socket->write( reinterpret_cast<const char *>( sequence ), sizeof( sequence ) );
+         client->socket->write( frame.payload );
+      }
+   }
+}
+
+void TrajectoryPublisher::requestFlush(
+){
+   if( flushPending.exchange( true ) )
+      return;
+
+   QMutexLocker lock( &clientsMutex );
+   if( loopContext == NULL ){
+      flushPending = false;
+      return;
+   }
+   QMetaObject::invokeMethod( loopContext, [this](){
+      flushPending = false;
+      flushClients();
+   }, Qt::QueuedConnection );
+}
@@ -0,0 +1,121 @@
+#ifndef TRAJECTORY_PUBLISHER_HPP
+#define TRAJECTORY_PUBLISHER_HPP
+
+// Qt headers
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QSharedPointer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QStringList>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QtDebug>
+
+// C headers
+#include <cstring>
+
+// C++ headers
+#include <atomic>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+
+// Publishes simulated steps to external consumers over a local socket
+// and/or a loopback TCP port.
+//
+// Every stride-th step is packed into a batch. Full batches become binary
+// frames that are queued per client, and the queues are bounded. A client
+// picks what happens when its queue is full by sending one byte after it
+// connects: 'D' drops frames (the default), 'B' blocks the producer.
+//
+// Wire format, native byte order:
+//   hello: "ODEH", quint32 length, UTF-8 JSON with the symbol names
+//   frame: "ODEF", quint32 records, quint32 vars, quint32 params,
+//          quint64 first step, quint64 frames dropped so far,
+//          then per record T, Val..., Param... as doubles
+class TrajectoryPublisher : public QThread
+{
+   Q_OBJECT
+
+public:
+   explicit TrajectoryPublisher( QStringList varNames
+                               , QStringList paramNames
+                               , QString localName
+                               , quint16 tcpPort
+                               , int stride
+                               , int batchSize
+                               , int queueLength
+                               , QObject *parent = 0 );
+   ~TrajectoryPublisher();
+
+   void run() Q_DECL_OVERRIDE;
+   // stops blocking the producer; the sockets are served, and what is
+   // queued is sent, until the publisher is deleted
+   void stop();
+
+   // called by the simulation thread
+   void Publish( const PointValues &pv );
+   void FlushBatch();
+
+private:
+   struct Frame {
+      quint64 first;
+      quint32 records;
+      QByteArray payload; // shared by all clients
+   };
+
+   struct Client {
+      QIODevice *socket = NULL;
+      QMutex mutex;
+      QWaitCondition notFull;
+      QQueue<Frame> queue;
+      bool blocking = false;
+      bool closed = false;
+      quint64 dropped = 0;
+   };
+   typedef QSharedPointer<Client> ClientPointer;
+
+   static const qint64 MaxBytesToWrite = 1 << 20;
+   static const qint64 DrainTimeout    = 2000; // ms
+
+   QStringList vars;
+   QStringList params;
+   QString localServerName;
+   quint16 port;
+   int decimation;
+   int batchRecords;
+   int maxQueue;
+
+   // producer side
+   quint64 stepCount;
+   quint64 batchFirst;
+   int batchCount;
+   QByteArray batch;
+   std::atomic<bool> flushPending;
+   std::atomic<bool> stateExit;
+
+   QMutex clientsMutex;
+   QList<ClientPointer> clients;
+   std::atomic<int> clientCount;
+
+   QObject *loopContext = NULL;
+
+   QByteArray helloFrame();
+   void addClient( QIODevice *socket );
+   void removeClient( QIODevice *socket );
+   void flushClients();
+   void requestFlush();
+};
+
+#endif // TRAJECTORY_PUBLISHER_HPP
@@ -0,0 +1,323 @@
+#include "trajectory_store.hpp"
+
+TrajectoryStore::TrajectoryStore(
+   QString filename
+ , int varCount
+ , int paramCount
+ , bool compress
+){
+   vars       = varCount;
+   params     = paramCount;
+   columns    = 1 + vars + params;
+   recordSize = columns * sizeof( double );
+   compressed = compress;
+   written    = 0;
+   flushed    = 0;
+   buffer.resize( columns );
+   if( compressed )
+      pending.resize( columns * IndexStride );
+
+   window      = NULL;
+   windowFirst = 0;
+   windowCount = 0;
+   record.resize( columns );
+   cachedBlock = -1;
+   cachedValues.resize( compressed ? columns * IndexStride : 0 );
+   cachedColumn.fill( false, columns );
+
+   writeFile.setFileName( filename );
+   readFile.setFileName( filename );
+   if( !writeFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) ){
+      qDebug() << "WARNING: Can't open recording file" << filename << ":" << writeFile.errorString();
+      return;
+   }
+
+   // header: magic, variable count, parameter count
+   qint32 counts[2] = { vars, params };
+   writeFile.write( compressed ? "ODETRAJ2" : "ODETRAJ1", 8 );
+   writeFile.write( reinterpret_cast<const char *>( counts ), sizeof( counts ) );
+   writeFile.flush();
+
+   if( !readFile.open( QIODevice::ReadOnly ) ){
+      qDebug() << "WARNING: Can't read recording file" << filename << ":" << readFile.errorString();
+      writeFile.close();
+   }
+}
+
+TrajectoryStore::~TrajectoryStore(
+){
+   if( window != NULL )
+      readFile.unmap( window );
+   if( writeFile.isOpen() ){
+      if( compressed && written % IndexStride != 0 )
+         WriteBlock();
+      Flush();
+      writeFile.close();
+   }
+   readFile.close();
+}
+
+bool TrajectoryStore::IsOpen(
+){
+   return writeFile.isOpen();
+}
+
+void TrajectoryStore::Append(
+   const PointValues &pv
+){
+   if( !writeFile.isOpen() )
+      return;
+
+   buffer[0] = pv.T;
+   std::memcpy( buffer.data() + 1,        pv.Val.constData(),   vars   * sizeof( double ) );
+   std::memcpy( buffer.data() + 1 + vars, pv.Param.constData(), params * sizeof( double ) );
+   if( compressed ){
+      QMutexLocker lock( &blockMutex );
+      qint64 i = written % IndexStride;
+      for( int c = 0; c < columns; c++ )
+         pending[c*IndexStride+i] = buffer[c];
+   } else {
+      writeFile.write( reinterpret_cast<const char *>( buffer.constData() ), recordSize );
+   }
+
+   if( written % IndexStride == 0 ){
+      QMutexLocker lock( &indexMutex );
+      indexTimes.push_back( pv.T );
+   }
+   written++;
+
+   if( compressed && written % IndexStride == 0 )
+      WriteBlock();
+
+   if( written % FlushStride == 0 )
+      Flush();
+}
+
+void TrajectoryStore::Flush(
+){
+   writeFile.flush();
+   flushed.storeRelease( written );
+}
+
+qint64 TrajectoryStore::Count(
+){
+   return flushed.loadAcquire();
+}
+
+PointValues TrajectoryStore::At(
+   qint64 index
+){
+   PointValues pv;
+   const double *record = Record( index );
+   if( record == NULL )
+      return pv;
+
+   pv.T = record[0];
+   pv.Val.resize( vars );
+   pv.Param.resize( params );
+   std::memcpy( pv.Val.data(),   record + 1,        vars   * sizeof( double ) );
+   std::memcpy( pv.Param.data(), record + 1 + vars, params * sizeof( double ) );
+
+   return pv;
+}
+
+qint64 TrajectoryStore::Seek(
+   double t
+){
+   qint64 count = Count();
+   if( count == 0 )
+      return -1;
+
+   // last indexed block starting at or before t
+   qint64 block = 0;
+   {
+      QMutexLocker lock( &indexMutex );
+      qint64 lo = 0;
+      qint64 hi = std::min<qint64>( indexTimes.size(), ( count + IndexStride - 1 ) / IndexStride ) - 1;
+      while( lo < hi ){
+         qint64 mid = ( lo + hi + 1 ) / 2;
+         if( indexTimes[mid] <= t )
+            lo = mid;
+         else
+            hi = mid - 1;
+      }
+      block = lo;
+   }
+
+   // first record in the block with T >= t
+   qint64 lo = block * IndexStride;
+   qint64 hi = std::min( lo + IndexStride, count ) - 1;
+   while( lo < hi ){
+      qint64 mid = ( lo + hi ) / 2;
+      if( Value( mid, 0 ) < t )
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo;
+}
+
+QVector<double> TrajectoryStore::Column(
+   int column
+ , qint64 first
+ , qint64 count
+){
+   QVector<double> values;
+   if( column < 0 || column >= columns )
+      return values;
+   first = std::max<qint64>( first, 0 );
+   count = std::min( count, Count() - first );
+   if( count <= 0 )
+      return values;
+
+   values.resize( count );
+   if( !compressed ){
+      for( qint64 i = 0; i < count; i++ ){
+         const double *rec = Record( first + i );
+         if( rec == NULL )
+            return QVector<double>();
+         values[i] = rec[column];
+      }
+      return values;
+   }
+
+   // a block at a time, decoding only the requested column
+   qint64 i = 0;
+   while( i < count ){
+      qint64 index = first + i;
+      qint64 block = index / IndexStride;
+      qint64 from  = index % IndexStride;
+      qint64 take  = std::min( IndexStride - from, count - i );
+      {
+         QMutexLocker lock( &blockMutex );
+         if( block >= blockOffsets.size() ){
+            std::memcpy( values.data() + i, pending.constData() + column*IndexStride + from, take * sizeof( double ) );
+            i += take;
+            continue;
+         }
+      }
+      const double *decoded = BlockColumn( block, column );
+      if( decoded == NULL )
+         return QVector<double>();
+      std::memcpy( values.data() + i, decoded + from, take * sizeof( double ) );
+      i += take;
+   }
+
+   return values;
+}
+
+double TrajectoryStore::Value(
+   qint64 index
+ , int column
+){
+   if( !compressed ){
+      const double *values = Record( index );
+      return values == NULL ? NAN : values[column];
+   }
+
+   qint64 block = index / IndexStride;
+   {
+      QMutexLocker lock( &blockMutex );
+      if( block >= blockOffsets.size() )
+         return pending[column*IndexStride+index%IndexStride];
+   }
+   const double *decoded = BlockColumn( block, column );
+   return decoded == NULL ? NAN : decoded[index%IndexStride];
+}
+
+void TrajectoryStore::WriteBlock(
+){
+   // only this thread changes the pending block, so it is encoded and
+   // written without the lock; readers keep using it until the block
+   // is in the directory
+   qint32 records = ( written - 1 ) % IndexStride + 1;
+   QVector<QByteArray> streams( columns );
+   QVector<qint32> sizes( columns );
+   for( int c = 0; c < columns; c++ ){
+      XorCodec::Encode( pending.constData() + c*IndexStride, records, streams[c] );
+      sizes[c] = streams[c].size();
+   }
+
+   // block: record count, stream sizes, streams
+   qint64 offset = writeFile.pos();
+   writeFile.write( reinterpret_cast<const char *>( &records ), sizeof( records ) );
+   writeFile.write( reinterpret_cast<const char *>( sizes.constData() ), columns * sizeof( qint32 ) );
+   offset += ( 1 + columns ) * sizeof( qint32 );
+
+   QVector<qint64> offsets( columns + 1 );
+   for( int c = 0; c < columns; c++ ){
+      writeFile.write( streams[c] );
+      offsets[c] = offset;
+      offset += sizes[c];
+   }
+   offsets[columns] = offset;
+   writeFile.flush();
+
+   QMutexLocker lock( &blockMutex );
+   blockOffsets.push_back( offsets );
+   blockRecords.push_back( records );
+}
+
+const double *TrajectoryStore::BlockColumn(
+   qint64 block
+ , int column
+){
+   if( cachedBlock != block ){
+      cachedBlock = block;
+      cachedColumn.fill( false, columns );
+   }
+
+   double *values = cachedValues.data() + column*IndexStride;
+   if( !cachedColumn[column] ){
+      qint64 from, to;
+      qint32 records;
+      {
+         QMutexLocker lock( &blockMutex );
+         from    = blockOffsets[block][column];
+         to      = blockOffsets[block][column+1];
+         records = blockRecords[block];
+      }
+      QByteArray data;
+      if( readFile.seek( from ) )
+         data = readFile.read( to - from );
+      if( data.size() != to - from || !XorCodec::Decode( data.constData(), data.size(), records, values ) ){
+         qDebug() << "WARNING: Can't read recording block" << block << ":" << readFile.errorString();
+         cachedBlock = -1;
+         return NULL;
+      }
+      cachedColumn[column] = true;
+   }
+
+   return values;
+}
+
+const double *TrajectoryStore::Record(
+   qint64 index
+){
+   if( index < 0 || index >= Count() )
+      return NULL;
+
+   if( compressed ){
+      for( int c = 0; c < columns; c++ )
+         record[c] = Value( index, c );
+      return record.constData();
+   }
+
+   // map the window containing the record, or extend the last one
+   if( window == NULL || index < windowFirst || index >= windowFirst + windowCount ){
+      if( window != NULL ){
+         readFile.unmap( window );
+         window = NULL;
+      }
+      windowFirst = index / WindowRecords * WindowRecords;
+      windowCount = std::min( WindowRecords, Count() - windowFirst );
+      window = readFile.map( HeaderSize + windowFirst * recordSize, windowCount * recordSize );
+      if( window == NULL ){
+         qDebug() << "WARNING: Can't map recording:" << readFile.errorString();
+         return NULL;
+      }
+   }
+
+   return reinterpret_cast<const double *>( window + ( index - windowFirst ) * recordSize );
+}
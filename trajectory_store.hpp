@@ -0,0 +1,106 @@
+#ifndef TRAJECTORY_STORE_HPP
+#define TRAJECTORY_STORE_HPP
+
+// Qt headers
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+#include <QString>
+#include <QAtomicInteger>
+#include <QtDebug>
+
+// C headers
+#include <cstring>
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+
+// Local headers
+#include "ode_pathtracer.hpp"
+#include "xor_codec.hpp"
+
+// On-disk recording of a run.
+// Records hold T, Val and Param as doubles and have a fixed size, so
+// record n lives at a known offset. Every IndexStride-th time is kept in
+// a sparse in-memory index, which makes seeking by time O(log n).
+// Reading goes through memory-mapped windows of the file, so recordings
+// don't need to fit in memory.
+// Compressed recordings store IndexStride records per block instead,
+// each column of the block encoded separately by XorCodec. Blocks are
+// found through an in-memory directory and decoded one column at a time
+// when read; the block being filled is read from memory.
+// One thread appends, another one reads.
+class TrajectoryStore
+{
+public:
+   TrajectoryStore( QString filename
+                  , int varCount
+                  , int paramCount
+                  , bool compress = false );
+   ~TrajectoryStore();
+
+   bool IsOpen();
+
+   // writer
+   void Append( const PointValues &pv );
+   void Flush();
+
+   // reader
+   qint64 Count();
+   PointValues At( qint64 index );
+   qint64 Seek( double t );
+   // column 0 is T, then Val, then Param
+   QVector<double> Column( int column
+                         , qint64 first
+                         , qint64 count );
+
+private:
+   static const qint64 IndexStride   = 1024;
+   static const qint64 FlushStride   = 64;
+   static const qint64 WindowRecords = 65536;
+   static const qint64 HeaderSize    = 16;
+
+   QFile writeFile;
+   QFile readFile;
+   int vars;
+   int params;
+   int columns;
+   qint64 recordSize;
+   bool compressed;
+
+   // writer state
+   qint64 written;
+   QVector<double> buffer;
+
+   // visible to the reader
+   QAtomicInteger<qint64> flushed;
+   QMutex indexMutex;
+   QVector<double> indexTimes;
+
+   // compressed blocks: the block being filled, column by column, and
+   // where the written ones start, with one more entry for their end,
+   // and how many records they hold
+   QMutex blockMutex;
+   QVector<double> pending;
+   QVector<QVector<qint64>> blockOffsets;
+   QVector<qint32> blockRecords;
+
+   // reader state
+   uchar *window;
+   qint64 windowFirst;
+   qint64 windowCount;
+   QVector<double> record;
+   qint64 cachedBlock;
+   QVector<double> cachedValues;
+   QVector<bool> cachedColumn;
+
+   const double *Record( qint64 index );
+   double Value( qint64 index
+               , int column );
+   void WriteBlock();
+   const double *BlockColumn( qint64 block
+                            , int column );
+};
+
+#endif // TRAJECTORY_STORE_HPP
@@ -0,0 +1,133 @@
+#include "workspace.hpp"
+
+Workspace::Workspace(
+   QWidget *parent
+) :
+   QMainWindow( parent )
+{
+   // create tabs
+   tabs = new QTabWidget( this );
+   tabs->setTabsClosable( true );
+   tabs->setMovable( true );
+   tabs->setDocumentMode( true );
+   connect( tabs, &QTabWidget::currentChanged, this, &Workspace::schedule );
+   connect( tabs, &QTabWidget::tabCloseRequested, this, &Workspace::closeTab );
+   setCentralWidget( tabs );
+
+   // create actions
+   newTabAction = new QAction( tr("&New tab"), this );
+   newTabAction->setShortcut( QKeySequence::AddTab );
+   newTabAction->setStatusTip( tr("Open another problem in a new tab.") );
+   connect( newTabAction, &QAction::triggered, this, &Workspace::newTab );
+
+   closeTabAction = new QAction( tr("Close &tab"), this );
+   closeTabAction->setShortcut( QKeySequence::Close );
+   closeTabAction->setStatusTip( tr("Close the current tab and its problem.") );
+   connect( closeTabAction, &QAction::triggered, this, [this]{
+      closeTab( tabs->currentIndex() );
+   } );
+
+   backgroundAction = new QAction( tr("&Background"), this );
+   backgroundAction->setStatusTip( tr("Keep computing problems in hidden tabs, without rendering them.") );
+   backgroundAction->setCheckable( true );
+   backgroundAction->setChecked( true );
+   connect( backgroundAction, &QAction::toggled, this, &Workspace::schedule );
+
+   // make toolbar
+   QToolBar *workspaceToolBar = new QToolBar( tr("Workspace"), this );
+   workspaceToolBar->addAction( newTabAction );
+   workspaceToolBar->addAction( closeTabAction );
+   workspaceToolBar->addSeparator();
+   workspaceToolBar->addAction( backgroundAction );
+   addToolBar( Qt::TopToolBarArea, workspaceToolBar );
+
+   // decorate window
+   setWindowTitle( tr("ODE PathTracer") );
+   resize( 800, 600 );
+
+   newTab();
+}
+
+Workspace::~Workspace(
+){
+   // problems stop their threads on deletion
+   while( tabs->count() > 0 ){
+      QWidget *tab = tabs->widget( 0 );
+      tabs->removeTab( 0 );
+      delete tab;
+   }
+}
+
+PlotWindow *Workspace::problemAt(
+   int index
+){
+   return qobject_cast<PlotWindow *>( tabs->widget( index ) );
+}
+
+void Workspace::newTab(
+   bool /* checked */ // unused
+){
+   PlotWindow *problem = new PlotWindow;
+   problem->setWindowFlags( Qt::Widget );
+   connect( problem, &QWidget::windowTitleChanged, this, &Workspace::updateTitles );
+
+   int index = tabs->addTab( problem, problem->problemName() );
+   tabs->setCurrentIndex( index );
+   schedule();
+}
+
+void Workspace::closeTab(
+   int index
+){
+   PlotWindow *problem = problemAt( index );
+   if( problem == NULL )
+      return;
+
+   tabs->removeTab( index );
+   delete problem;
+
+   // always keep one tab to open problems in
+   if( tabs->count() == 0 )
+      newTab();
+   schedule();
+}
+
+void Workspace::updateTitles(
+){
+   for( int i = 0; i < tabs->count(); i++ ){
+      tabs->setTabText( i, problemAt( i )->problemName() );
+      tabs->setTabToolTip( i, problemAt( i )->windowTitle() );
+   }
+
+   if( tabs->currentWidget() != NULL )
+      setWindowTitle( tabs->currentWidget()->windowTitle() );
+}
+
+void Workspace::schedule(
+){
+   int cores   = QThread::idealThreadCount();
+   int current = tabs->currentIndex();
+
+   // the visible problem always runs; hidden running problems get one
+   // of the remaining cores each, in tab order, and pause without one
+   int spareCores = std::max( 0, cores - 1 );
+   for( int i = 0; i < tabs->count(); i++ ){
+      PlotWindow *problem = problemAt( i );
+      if( i == current ){
+         problem->setBackground( false, true );
+         continue;
+      }
+
+      bool compute = backgroundAction->isChecked() && problem->runRequested() && spareCores > 0;
+      if( compute )
+         spareCores--;
+      problem->setBackground( true, compute );
+   }
+
+   // derivative evaluation threads are shared out between open problems
+   for( int i = 0; i < tabs->count(); i++ ){
+      problemAt( i )->setThreadBudget( cores / tabs->count() );
+   }
+
+   updateTitles();
+}
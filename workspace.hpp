@@ -0,0 +1,45 @@
+#ifndef WORKSPACE_HPP
+#define WORKSPACE_HPP
+
+// Qt headers
+#include <QMainWindow>
+#include <QTabWidget>
+#include <QToolBar>
+#include <QAction>
+#include <QThread>
+#include <QtDebug>
+
+// C++ headers
+#include <algorithm>
+
+// Local headers
+#include "plot_window.hpp"
+
+// Holds several open problems, one per tab. Every problem has its own
+// stepper and simulation thread. Only the visible one is rendered, and
+// background problems either pause or keep computing, as long as there
+// are spare cores for them.
+class Workspace : public QMainWindow
+{
+   Q_OBJECT
+
+public:
+   explicit Workspace( QWidget *parent = 0 );
+   ~Workspace();
+
+private:
+   QTabWidget *tabs;
+
+   // actions
+   QAction *newTabAction;
+   QAction *closeTabAction;
+   QAction *backgroundAction;
+
+   PlotWindow *problemAt( int index );
+   void newTab( bool checked = false );
+   void closeTab( int index );
+   void updateTitles();
+   void schedule();
+};
+
+#endif // WORKSPACE_HPP
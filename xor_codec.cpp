@@ -0,0 +1,187 @@
+#include "xor_codec.hpp"
+
+namespace {
+
+// most significant bit first
+class BitWriter
+{
+public:
+   explicit BitWriter( QByteArray &target ) : out( target ) {}
+
+   // count is 1 to 64
+   inline void Write( quint64 value
+                    , int count ){
+      if( count < 64 )
+         value &= ( 1ULL << count ) - 1;
+      int room = 64 - filled;
+      if( count < room ){
+         acc = acc << count | value;
+         filled += count;
+         return;
+      }
+
+      // fill the accumulator up, write it out, keep the rest
+      int rest = count - room;
+      acc = ( room == 64 ? 0 : acc << room ) | value >> rest;
+      for( int b = 56; b >= 0; b -= 8 )
+         out.append( (char)( acc >> b ) );
+      acc = rest == 0 ? 0 : value & ( ( 1ULL << rest ) - 1 );
+      filled = rest;
+   }
+
+   inline void Finish(){
+      if( filled == 0 )
+         return;
+      acc <<= 64 - filled;
+      for( int b = 56; b > 56 - filled; b -= 8 )
+         out.append( (char)( acc >> b ) );
+      acc = 0;
+      filled = 0;
+   }
+
+private:
+   QByteArray &out;
+   quint64 acc = 0;
+   int filled = 0;
+};
+
+class BitReader
+{
+public:
+   BitReader( const uchar *bytes
+            , int size ) : data( bytes ), end( bytes + size ) {}
+
+   inline bool Read( int count
+                   , quint64 &value ){
+      value = 0;
+      while( count > 0 ){
+         if( available == 0 ){
+            if( data == end )
+               return false;
+            acc = *data++;
+            available = 8;
+         }
+         int take = std::min( count, available );
+         available -= take;
+         value = ( value << take ) | ( ( acc >> available ) & ( ( 1u << take ) - 1 ) );
+         count -= take;
+      }
+      return true;
+   }
+
+private:
+   const uchar *data;
+   const uchar *end;
+   quint32 acc = 0;
+   int available = 0;
+};
+
+}
+
+void XorCodec::Encode(
+   const double *values
+ , int count
+ , QByteArray &out
+){
+   QByteArray best;
+   for( Predictor predictor : { Previous, Linear, Quadratic } ){
+      QByteArray stream;
+      EncodeWith( predictor, values, count, stream );
+      if( best.size() == 0 || stream.size() < best.size() )
+         best = stream;
+   }
+   out.append( best );
+}
+
+void XorCodec::EncodeWith(
+   Predictor predictor
+ , const double *values
+ , int count
+ , QByteArray &out
+){
+   out.reserve( out.size() + 1 + count * 9 );
+   out.append( (char)predictor );
+   if( count == 0 )
+      return;
+
+   BitWriter writer( out );
+   writer.Write( Bits( values[0] ), 64 );
+
+   // window of the last stored bits, as leading and trailing zeros
+   int windowLead  = -1;
+   int windowTrail = 0;
+   for( int i = 1; i < count; i++ ){
+      quint64 x = Bits( values[i] ) ^ Bits( Predict( predictor, values, i ) );
+      if( x == 0 ){
+         writer.Write( 0, 1 );
+         continue;
+      }
+
+      int lead  = std::min( 31, (int)qCountLeadingZeroBits( x ) );
+      int trail = qCountTrailingZeroBits( x );
+      if( windowLead >= 0 && lead >= windowLead && trail >= windowTrail ){
+         writer.Write( 2, 2 );
+         writer.Write( x >> windowTrail, 64 - windowLead - windowTrail );
+      } else {
+         int length = 64 - lead - trail;
+         writer.Write( 3, 2 );
+         writer.Write( lead, 5 );
+         writer.Write( length - 1, 6 );
+         writer.Write( x >> trail, length );
+         windowLead  = lead;
+         windowTrail = trail;
+      }
+   }
+   writer.Finish();
+}
+
+bool XorCodec::Decode(
+   const char *data
+ , int size
+ , int count
+ , double *values
+){
+   if( count == 0 )
+      return true;
+   if( size < 1 )
+      return false;
+
+   Predictor predictor = (Predictor)data[0];
+   BitReader reader( reinterpret_cast<const uchar *>( data ) + 1, size - 1 );
+
+   quint64 bits;
+   if( !reader.Read( 64, bits ) )
+      return false;
+   values[0] = Value( bits );
+
+   int windowLead  = -1;
+   int windowTrail = 0;
+   for( int i = 1; i < count; i++ ){
+      quint64 flag, x;
+      if( !reader.Read( 1, flag ) )
+         return false;
+      if( flag == 0 ){
+         x = 0;
+      } else {
+         if( !reader.Read( 1, flag ) )
+            return false;
+         if( flag == 1 ){
+            quint64 lead, length;
+            if( !reader.Read( 5, lead ) || !reader.Read( 6, length ) )
+               return false;
+            windowLead  = (int)lead;
+            windowTrail = 64 - windowLead - ( (int)length + 1 );
+            if( windowTrail < 0 )
+               return false;
+         } else if( windowLead < 0 ){
+            return false;
+         }
+         if( !reader.Read( 64 - windowLead - windowTrail, x ) )
+            return false;
+         x <<= windowTrail;
+      }
+      values[i] = Value( Bits( Predict( predictor, values, i ) ) ^ x );
+   }
+
+   return true;
+}
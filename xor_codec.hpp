@@ -0,0 +1,69 @@
+#ifndef XOR_CODEC_HPP
+#define XOR_CODEC_HPP
+
+// Qt headers
+#include <QByteArray>
+#include <QtAlgorithms>
+
+// C headers
+#include <cstring>
+#include <cmath>
+
+// C++ headers
+#include <algorithm>
+
+// Lossless compression of a column of doubles.
+// Every value is XORed with a prediction from the values before it, and
+// only the bits between the leading and trailing zeros of the result are
+// stored: one bit for an exact prediction, the bits alone if they fit
+// the window of the previous value, or a new window with them. Smooth
+// columns leave few bits after the XOR.
+// The first value is stored whole. A column is predicted by the previous
+// value, or by linear or quadratic extrapolation from the values before
+// it, whichever gives the shortest stream; the choice is the first byte.
+class XorCodec
+{
+public:
+   static void Encode( const double *values
+                     , int count
+                     , QByteArray &out );
+   // false if data is too short for count values
+   static bool Decode( const char *data
+                     , int size
+                     , int count
+                     , double *values );
+
+private:
+   enum Predictor : char { Previous = 0, Linear = 1, Quadratic = 2 };
+
+   static void EncodeWith( Predictor predictor
+                         , const double *values
+                         , int count
+                         , QByteArray &out );
+
+   static inline quint64 Bits( double value ){
+      quint64 bits;
+      std::memcpy( &bits, &value, sizeof( bits ) );
+      return bits;
+   }
+   static inline double Value( quint64 bits ){
+      double value;
+      std::memcpy( &value, &bits, sizeof( value ) );
+      return value;
+   }
+   // the same operations on both sides, so predictions match exactly
+   static inline double Predict( Predictor predictor
+                               , const double *values
+                               , int i ){
+      double extrapolated = values[i-1];
+      if( predictor == Linear && i >= 2 )
+         extrapolated = values[i-1] + ( values[i-1] - values[i-2] );
+      else if( predictor == Quadratic && i >= 3 )
+         extrapolated = 3.0 * ( values[i-1] - values[i-2] ) + values[i-3];
+      else if( predictor == Quadratic && i >= 2 )
+         extrapolated = values[i-1] + ( values[i-1] - values[i-2] );
+      return std::isfinite( extrapolated ) ? extrapolated : values[i-1];
+   }
+};
+
+#endif // XOR_CODEC_HPP